@@ -0,0 +1,330 @@
+#include "ops_bounds.h"
+#include <climits>
+#include <unordered_map>
+
+namespace {
+
+// Начало выражения, значение которого лежит на вершине стека перед командой end;
+// выражение не выходит за пределы линейного участка
+bool expressionStart(const std::vector<Instruction>& code, size_t end, size_t& start) {
+    int need = 1;
+    for (size_t k = end; k-- > 0;) {
+        OpCode op = code[k].op;
+        if (op == OpCode::LABEL || op == OpCode::JUMP || isConditionalJump(op)) return false;
+        StackEffect effect = stackEffect(op);
+        need += effect.pops - effect.pushes;
+        if (need == 0) {
+            start = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+OpCode uncheckedOf(OpCode op) {
+    switch (op) {
+        case OpCode::ARRAY_GET:    return OpCode::ARRAY_GET_UNCHECKED;
+        case OpCode::ARRAY_SET:    return OpCode::ARRAY_SET_UNCHECKED;
+        case OpCode::ARRAY_GET_2D: return OpCode::ARRAY_GET_2D_UNCHECKED;
+        default:                   return OpCode::ARRAY_SET_2D_UNCHECKED;
+    }
+}
+
+// Выделение памяти, меняющее размер, который проверяет охрана
+OpCode allocationFor(OpCode guard) {
+    return guard == OpCode::GUARD_INDEX ? OpCode::ALLOC_ARRAY : OpCode::ALLOC_ARRAY_2D;
+}
+
+std::string guardText(OpCode guard) {
+    if (guard == OpCode::GUARD_INDEX) return "guard_index";
+    return guard == OpCode::GUARD_ROW ? "guard_row" : "guard_col";
+}
+
+// Новая метка копии цикла: $m0, $m1, ... (в исходном коде такие имена невозможны)
+int newLabel(OPSProgram& program) {
+    size_t created = 0;
+    for (const std::string& name : program.labels) {
+        if (isTemporaryName(name)) created++;
+    }
+    program.labels.push_back("$m" + std::to_string(created));
+    return static_cast<int>(program.labels.size() - 1);
+}
+
+} // namespace
+
+size_t OPSBoundsChecks::optimize(OPSProgram& program) const {
+    if (program.linked) return 0;
+
+    Analysis analysis;
+    analysis.loops = findLoops(program);
+    if (analysis.loops.empty()) return 0;
+
+    const size_t count = program.code.size();
+    analysis.loopAt.assign(count, -1);
+    analysis.accessAt.assign(count, -1);
+    for (size_t l = 0; l < analysis.loops.size(); ++l) {
+        analysis.loopAt[analysis.loops[l].init] = static_cast<long>(l);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Access access;
+        if (!analyzeAccess(program, analysis.loops, i, access)) continue;
+        analysis.accessAt[i] = static_cast<long>(analysis.accesses.size());
+        analysis.accesses.push_back(access);
+    }
+    if (analysis.accesses.empty()) return 0;
+
+    std::vector<bool> fast(analysis.loops.size(), false);
+    Output out;
+    out.code.reserve(count);
+    out.text.reserve(count);
+    size_t unchecked = emit(program, analysis, 0, count, fast, out);
+    if (unchecked == 0) return 0;
+
+    program.code = std::move(out.code);
+    program.text = std::move(out.text);
+    return unchecked;
+}
+
+std::vector<OPSBoundsChecks::CountedLoop> OPSBoundsChecks::findLoops(const OPSProgram& program) const {
+    // loop_init, сразу за ним метка начала тела; loop_next того же счётчика переходит на неё
+    const std::vector<Instruction>& code = program.code;
+    std::vector<CountedLoop> loops;
+    for (size_t i = 0; i + 1 < code.size(); ++i) {
+        if (code[i].op != OpCode::LOOP_INIT || code[i + 1].op != OpCode::LABEL) continue;
+        for (size_t k = i + 2; k < code.size(); ++k) {
+            if (code[k].op == OpCode::LOOP_NEXT && code[k].a == code[i + 1].a && code[k].c == code[i].c) {
+                CountedLoop loop;
+                loop.init = i;
+                loop.next = k;
+                loop.variable = code[i].b;
+                loops.push_back(loop);
+                break;
+            }
+        }
+    }
+    return loops;
+}
+
+bool OPSBoundsChecks::inductionIndex(const std::vector<Instruction>& code, size_t end,
+                                     size_t& start, int& variable, int& offset) const {
+    if (!expressionStart(code, end, start)) return false;
+    const Instruction& load = code[start];
+    if (load.op != OpCode::PUSH_VAR) return false;
+    variable = load.a;
+    offset = 0;
+    if (end - start == 1) return true;
+
+    // i k + / i k -
+    if (end - start != 3) return false;
+    const Instruction& constant = code[start + 1];
+    const Instruction& op = code[start + 2];
+    if (constant.op != OpCode::PUSH_CONST || !constant.imm.isInt()) return false;
+    if (op.op == OpCode::ADD) {
+        offset = constant.imm.asInt();
+        return true;
+    }
+    if (op.op == OpCode::SUB && constant.imm.asInt() != INT_MIN) {
+        offset = -constant.imm.asInt();
+        return true;
+    }
+    return false;
+}
+
+bool OPSBoundsChecks::analyzeAccess(const OPSProgram& program, const std::vector<CountedLoop>& loops,
+                                    size_t position, Access& access) const {
+    const std::vector<Instruction>& code = program.code;
+    const Instruction& ins = code[position];
+
+    // Где кончается выражение последнего индекса и какие измерения охраняются
+    size_t end = position;
+    std::vector<OpCode> guards;
+    switch (ins.op) {
+        case OpCode::ARRAY_GET:
+            guards = {OpCode::GUARD_INDEX};
+            break;
+        case OpCode::ARRAY_SET:
+            if (!expressionStart(code, position, end)) return false;
+            guards = {OpCode::GUARD_INDEX};
+            break;
+        case OpCode::ARRAY_GET_2D:
+            guards = {OpCode::GUARD_COL, OpCode::GUARD_ROW};
+            break;
+        case OpCode::ARRAY_SET_2D:
+            if (!expressionStart(code, position, end)) return false;
+            guards = {OpCode::GUARD_COL, OpCode::GUARD_ROW};
+            break;
+        default:
+            return false;
+    }
+
+    // Индексы разбираются с последнего: столбец, затем строка
+    access.position = position;
+    for (OpCode guard : guards) {
+        size_t start;
+        Dimension dimension;
+        dimension.guard = guard;
+        dimension.array = ins.a;
+        int variable;
+        if (!inductionIndex(code, end, start, variable, dimension.offset)) return false;
+        end = start;
+
+        // Цикл этой переменной, внутри которого массив не выделяется заново
+        bool owned = false;
+        for (size_t l = 0; l < loops.size() && !owned; ++l) {
+            const CountedLoop& loop = loops[l];
+            if (loop.variable != variable || position <= loop.init || position >= loop.next) continue;
+            owned = true;
+            for (size_t k = loop.init; k < loop.next; ++k) {
+                if (code[k].op == allocationFor(guard) && code[k].a == ins.a) owned = false;
+            }
+            dimension.owner = l;
+        }
+        if (!owned) return false;
+        access.dimensions.push_back(dimension);
+    }
+    return true;
+}
+
+std::vector<OPSBoundsChecks::Dimension> OPSBoundsChecks::guardsFor(const Analysis& analysis, size_t loop,
+                                                                   const std::vector<bool>& fast) const {
+    // Обращение использует охрану цикла, если остальные его измерения охраняют
+    // либо внешние циклы, уже выбравшие быструю копию, либо вложенные циклы
+    const CountedLoop& counted = analysis.loops[loop];
+    std::vector<Dimension> guards;
+    for (const Access& access : analysis.accesses) {
+        if (access.position <= counted.init || access.position >= counted.next) continue;
+        bool uses = false;
+        bool provable = true;
+        for (const Dimension& dimension : access.dimensions) {
+            if (dimension.owner == loop) {
+                uses = true;
+            } else if (!fast[dimension.owner] && analysis.loops[dimension.owner].init < counted.init) {
+                provable = false;
+            }
+        }
+        if (!uses || !provable) continue;
+
+        for (const Dimension& dimension : access.dimensions) {
+            if (dimension.owner != loop) continue;
+            bool known = false;
+            for (const Dimension& guard : guards) {
+                if (guard.guard == dimension.guard && guard.array == dimension.array &&
+                    guard.offset == dimension.offset) {
+                    known = true;
+                }
+            }
+            if (!known) guards.push_back(dimension);
+        }
+    }
+    return guards;
+}
+
+size_t OPSBoundsChecks::emit(OPSProgram& program, const Analysis& analysis, size_t begin, size_t end,
+                             std::vector<bool>& fast, Output& out) const {
+    const std::vector<Instruction>& code = program.code;
+    auto copy = [&](size_t i) {
+        out.code.push_back(code[i]);
+        out.text.push_back(program.text[i]);
+    };
+
+    size_t unchecked = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (analysis.loopAt[i] >= 0) {
+            size_t loop = static_cast<size_t>(analysis.loopAt[i]);
+            std::vector<Dimension> guards = guardsFor(analysis, loop, fast);
+            if (!guards.empty()) {
+                const CountedLoop& counted = analysis.loops[loop];
+                const Instruction& init = code[counted.init];
+                const std::string& name = program.variables[counted.variable];
+                int checked = newLabel(program);
+
+                // Вход в цикл и охраны: при нарушении - проверяемая копия
+                copy(counted.init);
+                for (const Dimension& dimension : guards) {
+                    Instruction guard;
+                    guard.op = dimension.guard;
+                    guard.a = checked;
+                    guard.b = dimension.array;
+                    guard.c = init.c;
+                    guard.imm = Value(dimension.offset);
+                    std::string offset;
+                    if (dimension.offset > 0) offset = "+" + std::to_string(dimension.offset);
+                    if (dimension.offset < 0) offset = std::to_string(dimension.offset);
+                    out.code.push_back(guard);
+                    out.text.push_back(program.labels[checked] + " " + name + offset + " " +
+                                       program.arrays[dimension.array] + " " + guardText(dimension.guard));
+                }
+
+                // Быстрая копия: исходные метки, обращения без проверки
+                copy(counted.init + 1);
+                fast[loop] = true;
+                unchecked += emit(program, analysis, counted.init + 2, counted.next, fast, out);
+                fast[loop] = false;
+                copy(counted.next);
+
+                Instruction exit;
+                exit.op = OpCode::JUMP;
+                exit.a = init.a;
+                out.code.push_back(exit);
+                out.text.push_back(program.labels[init.a] + " j");
+
+                // Проверяемая копия с новыми метками
+                Instruction label;
+                label.op = OpCode::LABEL;
+                label.a = checked;
+                out.code.push_back(label);
+                out.text.push_back(program.labels[checked] + ":");
+
+                Output body;
+                unchecked += emit(program, analysis, counted.init + 2, counted.next, fast, body);
+                renameLabels(program, body);
+                out.code.insert(out.code.end(), body.code.begin(), body.code.end());
+                out.text.insert(out.text.end(), body.text.begin(), body.text.end());
+
+                Instruction next = code[counted.next];
+                next.a = checked;
+                out.code.push_back(next);
+                out.text.push_back(program.labels[checked] + " " + name + " loop_next");
+
+                i = counted.next;
+                continue;
+            }
+        }
+
+        if (analysis.accessAt[i] >= 0) {
+            const Access& access = analysis.accesses[static_cast<size_t>(analysis.accessAt[i])];
+            bool proven = true;
+            for (const Dimension& dimension : access.dimensions) {
+                if (!fast[dimension.owner]) proven = false;
+            }
+            if (proven) {
+                Instruction ins = code[i];
+                ins.op = uncheckedOf(ins.op);
+                out.code.push_back(ins);
+                out.text.push_back(program.text[i]);
+                unchecked++;
+                continue;
+            }
+        }
+
+        copy(i);
+    }
+    return unchecked;
+}
+
+void OPSBoundsChecks::renameLabels(OPSProgram& program, Output& chunk) const {
+    std::unordered_map<int, int> renamed;
+    for (const Instruction& ins : chunk.code) {
+        if (ins.op == OpCode::LABEL) renamed[ins.a] = newLabel(program);
+    }
+
+    // Запись команды начинается с имени метки: mN:, mN j, mN i loop_next ...
+    for (size_t i = 0; i < chunk.code.size(); ++i) {
+        Instruction& ins = chunk.code[i];
+        if (ins.op != OpCode::LABEL && ins.op != OpCode::JUMP && !isConditionalJump(ins.op)) continue;
+        auto found = renamed.find(ins.a);
+        if (found == renamed.end()) continue;
+        chunk.text[i] = program.labels[found->second] + chunk.text[i].substr(program.labels[ins.a].size());
+        ins.a = found->second;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef OPS_BOUNDS_H
+#define OPS_BOUNDS_H
+
+#include <string>
+#include <vector>
+#include "ops_program.h"
+
+// Удаление проверок границ массивов в циклах со счётчиком. Индекс вида i или
+// i ± k, где i - переменная цикла loop_init / loop_next, за весь цикл
+// пробегает известный диапазон. Перед телом цикла ставится охрана: один раз
+// на вход в цикл она сверяет диапазон с текущим размером массива. Если
+// охрана прошла, выполняется копия тела, где такие обращения заменены
+// командами без проверки; иначе - исходная копия с проверками:
+//   n mE i loop_init mC i arr guard_index mS: <без проверок> mS i loop_next mE j
+//   mC: <с проверками> mC i loop_next mE:
+// Для 2D массива строка и столбец охраняются отдельно, каждый - циклом своей
+// переменной. Работает по нескомпонованной программе после циклов со счётчиком
+class OPSBoundsChecks {
+public:
+    // Возвращает число обращений к массивам, переведённых в варианты без проверки
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    // Цикл со счётчиком: позиции loop_init и loop_next в исходном потоке команд
+    struct CountedLoop {
+        size_t init = 0;
+        size_t next = 0;
+        int variable = 0;
+    };
+
+    // Измерение индекса: guard - команда охраны (GUARD_INDEX, GUARD_ROW, GUARD_COL),
+    // owner - цикл, переменная которого задаёт индекс
+    struct Dimension {
+        OpCode guard = OpCode::GUARD_INDEX;
+        int array = 0;
+        int offset = 0;
+        size_t owner = 0;
+    };
+
+    // Обращение к массиву, все измерения которого охраняются циклами
+    struct Access {
+        size_t position = 0;
+        std::vector<Dimension> dimensions;
+    };
+
+    // Результат анализа исходной программы
+    struct Analysis {
+        std::vector<CountedLoop> loops;
+        std::vector<long> loopAt;     // номер цикла по позиции loop_init
+        std::vector<Access> accesses;
+        std::vector<long> accessAt;   // номер обращения по позиции команды
+    };
+
+    // Выходной поток команд
+    struct Output {
+        std::vector<Instruction> code;
+        std::vector<std::string> text;
+    };
+
+    std::vector<CountedLoop> findLoops(const OPSProgram& program) const;
+
+    // Обращение в позиции position, если каждое его измерение охраняемо
+    bool analyzeAccess(const OPSProgram& program, const std::vector<CountedLoop>& loops,
+                       size_t position, Access& access) const;
+
+    // Индекс i или i ± k, вычисляемый непосредственно перед позицией end
+    bool inductionIndex(const std::vector<Instruction>& code, size_t end,
+                        size_t& start, int& variable, int& offset) const;
+
+    // Охраны цикла loop при уже выбранных быстрых копиях внешних циклов (fast)
+    std::vector<Dimension> guardsFor(const Analysis& analysis, size_t loop,
+                                     const std::vector<bool>& fast) const;
+
+    // Переписывает команды [begin, end) в out; возвращает число обращений без проверки
+    size_t emit(OPSProgram& program, const Analysis& analysis, size_t begin, size_t end,
+                std::vector<bool>& fast, Output& out) const;
+
+    // Метки, определённые в куске кода, получают новые имена
+    void renameLabels(OPSProgram& program, Output& chunk) const;
+};
+
+#endif // OPS_BOUNDS_H
@@ -0,0 +1,752 @@
+#include "ops_cbackend.h"
+#include "ops_typing.h"
+#include "ops_fusion.h"
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Среда выполнения сгенерированной программы: значение ОПС с тегом (поля
+// без объединения, чтобы компилятор C разложил локальные значения по
+// регистрам), арифметика с семантикой Value, буферизованные ввод и вывод.
+// Вывод double совпадает с std::to_chars: кратчайшая обратимая запись с
+// фиксированной точкой или с порядком - какая короче (целое значение с
+// фиксированной точкой - точно)
+const char RUNTIME[] = R"(#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Значение ОПС: t = 0 - int (поле i), t = 1 - double (поле d) */
+typedef struct {
+    int t;
+    int i;
+    double d;
+} ops_value;
+
+static inline ops_value ops_int(int x) { ops_value v; v.t = 0; v.i = x; v.d = 0.0; return v; }
+static inline ops_value ops_dbl(double x) { ops_value v; v.t = 1; v.i = 0; v.d = x; return v; }
+static inline int ops_as_int(ops_value v) { return v.t == 0 ? v.i : (int)v.d; }
+static inline double ops_as_dbl(ops_value v) { return v.t == 0 ? (double)v.i : v.d; }
+static inline int ops_false(ops_value v) { return v.t == 0 ? v.i == 0 : v.d == 0.0; }
+
+/* Целая арифметика с переполнением по модулю 2^32, как у int интерпретатора */
+static inline int ops_iadd(int a, int b) { return (int)((unsigned)a + (unsigned)b); }
+static inline int ops_isub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }
+static inline int ops_imul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }
+
+static inline ops_value ops_add(ops_value a, ops_value b) {
+    return a.t || b.t ? ops_dbl(ops_as_dbl(a) + ops_as_dbl(b)) : ops_int(ops_iadd(a.i, b.i));
+}
+static inline ops_value ops_sub(ops_value a, ops_value b) {
+    return a.t || b.t ? ops_dbl(ops_as_dbl(a) - ops_as_dbl(b)) : ops_int(ops_isub(a.i, b.i));
+}
+static inline ops_value ops_mul(ops_value a, ops_value b) {
+    return a.t || b.t ? ops_dbl(ops_as_dbl(a) * ops_as_dbl(b)) : ops_int(ops_imul(a.i, b.i));
+}
+static inline ops_value ops_div(ops_value a, ops_value b) {
+    return a.t || b.t ? ops_dbl(ops_as_dbl(a) / ops_as_dbl(b)) : ops_int(a.i / b.i);
+}
+static inline int ops_gt(ops_value a, ops_value b) { return a.t || b.t ? ops_as_dbl(a) > ops_as_dbl(b) : a.i > b.i; }
+static inline int ops_lt(ops_value a, ops_value b) { return a.t || b.t ? ops_as_dbl(a) < ops_as_dbl(b) : a.i < b.i; }
+static inline int ops_eq(ops_value a, ops_value b) { return a.t || b.t ? ops_as_dbl(a) == ops_as_dbl(b) : a.i == b.i; }
+
+/* Вывод w: буфер сбрасывается при заполнении, в конце и перед ошибкой */
+static char ops_out[1 << 16];
+static size_t ops_out_used = 0;
+
+static inline void ops_flush(void) {
+    fwrite(ops_out, 1, ops_out_used, stdout);
+    ops_out_used = 0;
+    fflush(stdout);
+}
+
+static inline void ops_put(const char* data, size_t length) {
+    if (sizeof(ops_out) - ops_out_used < length) ops_flush();
+    memcpy(ops_out + ops_out_used, data, length);
+    ops_out_used += length;
+}
+
+static inline void ops_fail(const char* message, int pc) {
+    ops_flush();
+    fprintf(stderr, "Ошибка выполнения: %s (позиция %d)\n", message, pc);
+    exit(1);
+}
+
+static inline void ops_fail_index(int index, int pc) {
+    char message[64];
+    snprintf(message, sizeof(message), "Индекс массива вне границ: %d", index);
+    ops_fail(message, pc);
+}
+
+static inline void ops_fail_index2(int row, int col, int pc) {
+    char message[80];
+    snprintf(message, sizeof(message), "Индексы массива вне границ: %d, %d", row, col);
+    ops_fail(message, pc);
+}
+
+static inline void* ops_alloc(size_t count, size_t size, int pc) {
+    void* memory = calloc(count > 0 ? count : 1, size);
+    if (memory == NULL) ops_fail("Недостаточно памяти для массива", pc);
+    return memory;
+}
+
+static inline int ops_format_double(char* text, double value) {
+    char sci[32], fixed[400];
+    const char* p = sci;
+    char digits[20];
+    int precision, count = 0, n = 0, exponent, i;
+
+    if (value != value) return sprintf(text, "%s", signbit(value) ? "-nan" : "nan");
+    if (isinf(value)) return sprintf(text, "%s", value < 0 ? "-inf" : "inf");
+
+    /* Кратчайшая запись с порядком, которая читается обратно в то же число */
+    for (precision = 1; precision <= 17; ++precision) {
+        snprintf(sci, sizeof(sci), "%.*e", precision - 1, value);
+        if (strtod(sci, NULL) == value) break;
+    }
+
+    /* Те же цифры с фиксированной точкой */
+    if (*p == '-') {
+        fixed[n++] = '-';
+        ++p;
+    }
+    while (*p != 'e') {
+        if (*p != '.') digits[count++] = *p;
+        ++p;
+    }
+    exponent = atoi(p + 1);
+    if (exponent + 1 >= count) {
+        /* Целое значение с фиксированной точкой выводится точно, всеми цифрами */
+        n = snprintf(fixed, sizeof(fixed), "%.0f", value);
+    } else if (exponent >= 0) {
+        for (i = 0; i <= exponent || i < count; ++i) {
+            if (i == exponent + 1) fixed[n++] = '.';
+            fixed[n++] = i < count ? digits[i] : '0';
+        }
+    } else {
+        fixed[n++] = '0';
+        fixed[n++] = '.';
+        for (i = 1; i < -exponent; ++i) fixed[n++] = '0';
+        for (i = 0; i < count; ++i) fixed[n++] = digits[i];
+    }
+    fixed[n] = '\0';
+    return sprintf(text, "%s", (int)strlen(sci) < n ? sci : fixed);
+}
+
+static inline void ops_write(ops_value value) {
+    char text[64];
+    int length;
+    if (!ops_raw_output) ops_put("  ВЫВОД: ", sizeof("  ВЫВОД: ") - 1);
+    length = value.t == 0 ? sprintf(text, "%d", value.i) : ops_format_double(text, value.d);
+    text[length++] = '\n';
+    ops_put(text, (size_t)length);
+}
+
+/* Ввод r: stdin читается целиком при первом чтении, числа разделены пробельными символами */
+static char* ops_in = NULL;
+static size_t ops_in_size = 0, ops_in_pos = 0;
+
+static inline int ops_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+static inline void ops_load_input(int pc) {
+    size_t capacity = 1 << 16, count;
+    ops_in = (char*)malloc(capacity + 1);
+    if (ops_in == NULL) ops_fail("Недостаточно памяти для входных данных", pc);
+    while ((count = fread(ops_in + ops_in_size, 1, capacity - ops_in_size, stdin)) > 0) {
+        ops_in_size += count;
+        if (ops_in_size == capacity) {
+            capacity *= 2;
+            ops_in = (char*)realloc(ops_in, capacity + 1);
+            if (ops_in == NULL) ops_fail("Недостаточно памяти для входных данных", pc);
+        }
+    }
+    ops_in[ops_in_size] = '\0';
+}
+
+static inline double ops_read(int pc) {
+    size_t begin;
+    char saved, *end;
+    const char* start;
+    double value;
+
+    if (ops_in == NULL) ops_load_input(pc);
+    while (ops_in_pos < ops_in_size && ops_space(ops_in[ops_in_pos])) ++ops_in_pos;
+    if (ops_in_pos == ops_in_size) ops_fail("Входные данные исчерпаны", pc);
+    begin = ops_in_pos;
+    while (ops_in_pos < ops_in_size && !ops_space(ops_in[ops_in_pos])) ++ops_in_pos;
+
+    saved = ops_in[ops_in_pos];
+    ops_in[ops_in_pos] = '\0';
+    start = ops_in + begin + (ops_in[begin] == '+' ? 1 : 0);
+    value = strtod(start, &end);
+    if (end == start || *end != '\0' || *start == '+' || strpbrk(start, "xX") != NULL) {
+        char message[128];
+        snprintf(message, sizeof(message), "Неверное число во входных данных: %.64s", ops_in + begin);
+        ops_fail(message, pc);
+    }
+    ops_in[ops_in_pos] = saved;
+    return value;
+}
+
+/* Число итераций цикла со счётчиком (как tripCount интерпретатора) */
+static inline long long ops_trip_count(int start, ops_value bound, int step, int lessThan) {
+    long long limit, distance, stride;
+    if (bound.t == 0) {
+        limit = bound.i;
+    } else {
+        double value = bound.d;
+        if (value != value) return 0;
+        value = lessThan ? ceil(value) : floor(value);
+        if (value < -9.0e15) value = -9.0e15;
+        if (value > 9.0e15) value = 9.0e15;
+        limit = (long long)value;
+    }
+    distance = lessThan ? limit - start : start - limit;
+    stride = step < 0 ? -(long long)step : step;
+    if (distance <= 0) return 0;
+    return (distance + stride - 1) / stride;
+}
+)";
+
+std::string intLiteral(int value) {
+    if (value == INT_MIN) return "(-2147483647 - 1)";
+    return std::to_string(value);
+}
+
+// Точная запись double: шестнадцатеричный литерал C99
+std::string doubleLiteral(double value) {
+    if (value != value) return "NAN";
+    if (std::isinf(value)) return value < 0 ? "(-HUGE_VAL)" : "HUGE_VAL";
+    char text[64];
+    std::snprintf(text, sizeof(text), "%a", value);
+    return value < 0 ? "(" + std::string(text) + ")" : std::string(text);
+}
+
+std::string valueLiteral(const Value& value) {
+    return value.isInt() ? "ops_int(" + intLiteral(value.asInt()) + ")"
+                         : "ops_dbl(" + doubleLiteral(value.asDouble()) + ")";
+}
+
+std::string stringLiteral(const std::string& text) {
+    std::string literal = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') literal += '\\';
+        literal += c;
+    }
+    return literal + "\"";
+}
+
+std::string commentText(const std::string& text) {
+    std::string safe = text;
+    for (size_t pos = safe.find("*/"); pos != std::string::npos; pos = safe.find("*/")) {
+        safe.replace(pos, 2, "* /");
+    }
+    return safe;
+}
+
+std::string slot(size_t depth) { return "s" + std::to_string(depth); }
+std::string var(int index) { return "v" + std::to_string(index); }
+std::string label(size_t pc) { return "L" + std::to_string(pc); }
+
+// Операнд сравнения: значение и поля для специализированных вариантов
+struct Operand {
+    std::string value;
+    std::string rawInt;
+    std::string rawDouble;
+};
+
+Operand variableOperand(int index) {
+    return Operand{var(index), var(index) + ".i", var(index) + ".d"};
+}
+
+Operand constantOperand(const Value& value) {
+    return Operand{valueLiteral(value), intLiteral(value.asInt()), doubleLiteral(value.asDouble())};
+}
+
+// Сравнение внутри слитой команды (как compareValues интерпретатора)
+std::string compare(OpCode op, const Operand& a, const Operand& b) {
+    switch (op) {
+        case OpCode::GT_I32: return a.rawInt + " > " + b.rawInt;
+        case OpCode::LT_I32: return a.rawInt + " < " + b.rawInt;
+        case OpCode::EQ_I32: return a.rawInt + " == " + b.rawInt;
+        case OpCode::GT_F64: return a.rawDouble + " > " + b.rawDouble;
+        case OpCode::LT_F64: return a.rawDouble + " < " + b.rawDouble;
+        case OpCode::EQ_F64: return a.rawDouble + " == " + b.rawDouble;
+        case OpCode::GT: return "ops_gt(" + a.value + ", " + b.value + ")";
+        case OpCode::LT: return "ops_lt(" + a.value + ", " + b.value + ")";
+        default: return "ops_eq(" + a.value + ", " + b.value + ")";
+    }
+}
+
+// Элемент буфера в значение и значение в элемент буфера
+std::string loadElement(const std::string& type, const std::string& element) {
+    return (type == "double" ? "ops_dbl(" : "ops_int(") + element + ")";
+}
+
+std::string storeElement(const std::string& type, const std::string& value) {
+    if (type == "double") return "ops_as_dbl(" + value + ")";
+    return "(" + type + ")ops_as_int(" + value + ")";
+}
+
+} // namespace
+
+OPSCBackend::OPSCBackend(bool rawOutput) : raw(rawOutput) {}
+
+std::vector<std::string> OPSCBackend::elementTypes(const OPSProgram& program, bool twoDimensional) const {
+    const OpCode alloc = twoDimensional ? OpCode::ALLOC_ARRAY_2D : OpCode::ALLOC_ARRAY;
+    std::vector<std::string> types(program.arrays.size());
+    for (const Instruction& ins : program.code) {
+        if (ins.op != alloc) continue;
+        std::string type = "int32_t";
+        if (ins.type == DataType::CHAR) {
+            type = "uint8_t";
+        } else if (ins.type == DataType::FLOAT || ins.type == DataType::DOUBLE) {
+            type = "double";
+        }
+        if (!types[ins.a].empty() && types[ins.a] != type) {
+            throw std::runtime_error("ОПС не переводится в C: у массива " + program.arrays[ins.a] +
+                                     " разные типы элементов");
+        }
+        types[ins.a] = type;
+    }
+    for (std::string& type : types) {
+        if (type.empty()) type = "int32_t";  // массив не выделяется: обращение к нему - ошибка
+    }
+    return types;
+}
+
+std::string OPSCBackend::translate(const OPSProgram& source) const {
+    // Та же программа, что выполняет интерпретатор: адреса переходов,
+    // специализированные по типам команды и суперкоманды
+    OPSProgram program = source;
+    OPSLinker linker;
+    linker.link(program);
+    std::vector<Value> frame(program.variables.size(), Value());
+    OPSTypeInference typing;
+    typing.specialize(program, frame);
+    OPSFusion fusion;
+    fusion.fuse(program);
+
+    // Глубина стека в каждой команде одна на всех путях: ячейки - локальные переменные
+    if (!typing.analyze(program, frame)) {
+        throw std::runtime_error("ОПС не переводится в C: глубина стека различается на разных путях");
+    }
+
+    const std::vector<Instruction>& code = program.code;
+    const size_t count = code.size();
+    std::vector<std::string> arrayTypes = elementTypes(program, false);
+    std::vector<std::string> arrayTypes2D = elementTypes(program, true);
+
+    std::vector<bool> isTarget(count + 1, false);
+    for (const Instruction& ins : code) {
+        if (ins.op == OpCode::JUMP || isConditionalJump(ins.op)) {
+            isTarget[static_cast<size_t>(ins.a)] = true;
+        }
+    }
+
+    std::ostringstream out;
+    out << "/* Программа ОПС, переведённая в C (syntax_analyzer --emit-c) */\n";
+    out << "static const int ops_raw_output = " << (raw ? 1 : 0) << ";\n\n";
+    out << RUNTIME << "\n";
+    out << "int main(void) {\n";
+    for (size_t i = 0; i < program.variables.size(); ++i) {
+        out << "    ops_value " << var(static_cast<int>(i)) << " = {0, 0, 0.0};  /* "
+            << commentText(program.variables[i]) << " */\n";
+    }
+    for (size_t depth = 0; depth < program.maxStackDepth; ++depth) {
+        out << "    ops_value " << slot(depth) << " = {0, 0, 0.0};\n";
+    }
+    // Объявляются только буферы, размеры и диапазоны счётчиков, которые
+    // читает достижимый код: сгенерированный текст без предупреждений -Wall -Wextra
+    const size_t arrayCount = program.arrays.size();
+    std::vector<bool> uses1D(arrayCount, false), readsLength(arrayCount, false);
+    std::vector<bool> uses2D(arrayCount, false), readsRows(arrayCount, false), readsCols(arrayCount, false);
+    std::vector<bool> readsRange(program.loopCounters, false);
+    std::vector<bool> readsVariable(program.variables.size(), false);
+    for (size_t pc = 0; pc < count; ++pc) {
+        if (!typing.reached(pc)) continue;
+        const Instruction& ins = code[pc];
+        switch (ins.op) {
+            case OpCode::PUSH_VAR:
+            case OpCode::INC_VAR:
+                readsVariable[ins.a] = true;
+                break;
+            case OpCode::CMP_VAR_VAR_JF:
+                readsVariable[ins.b] = true;
+                readsVariable[ins.c] = true;
+                break;
+            case OpCode::CMP_VAR_CONST_JF:
+            case OpCode::LOAD_ELEM_VAR_INDEX:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+            case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+            case OpCode::LOOP_INIT:
+            case OpCode::LOOP_NEXT:
+                readsVariable[ins.b] = true;
+                break;
+            default:
+                break;
+        }
+        switch (ins.op) {
+            case OpCode::ARRAY_GET:
+            case OpCode::ARRAY_SET:
+            case OpCode::ARRAY_READ:
+            case OpCode::LOAD_ELEM_VAR_INDEX:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+                readsLength[ins.a] = true;
+                uses1D[ins.a] = true;
+                break;
+            case OpCode::ALLOC_ARRAY:
+            case OpCode::ARRAY_GET_UNCHECKED:
+            case OpCode::ARRAY_SET_UNCHECKED:
+            case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+                uses1D[ins.a] = true;
+                break;
+            case OpCode::ARRAY_GET_2D:
+            case OpCode::ARRAY_SET_2D:
+            case OpCode::ARRAY_READ_2D:
+                readsRows[ins.a] = true;
+                readsCols[ins.a] = true;
+                uses2D[ins.a] = true;
+                break;
+            case OpCode::ARRAY_GET_2D_UNCHECKED:
+            case OpCode::ARRAY_SET_2D_UNCHECKED:
+                readsCols[ins.a] = true;
+                uses2D[ins.a] = true;
+                break;
+            case OpCode::ALLOC_ARRAY_2D:
+                uses2D[ins.a] = true;
+                break;
+            case OpCode::GUARD_INDEX:
+                readsLength[ins.b] = true;
+                uses1D[ins.b] = true;
+                readsRange[ins.c] = true;
+                break;
+            case OpCode::GUARD_ROW:
+            case OpCode::GUARD_COL:
+                (ins.op == OpCode::GUARD_ROW ? readsRows : readsCols)[ins.b] = true;
+                uses2D[ins.b] = true;
+                readsRange[ins.c] = true;
+                break;
+            default:
+                break;
+        }
+    }
+    for (size_t a = 0; a < arrayCount; ++a) {
+        if (uses1D[a]) {
+            out << "    " << arrayTypes[a] << "* a" << a << " = NULL;  /* " << commentText(program.arrays[a]) << " */\n";
+        }
+        if (readsLength[a]) {
+            out << "    int a" << a << "_n = 0;\n";
+        }
+        if (uses2D[a]) {
+            out << "    " << arrayTypes2D[a] << "* b" << a << " = NULL;  /* " << commentText(program.arrays[a]) << "[][] */\n";
+        }
+        if (readsRows[a]) {
+            out << "    int b" << a << "_rows = 0;\n";
+        }
+        if (readsCols[a]) {
+            out << "    int b" << a << "_cols = 0;\n";
+        }
+    }
+    for (size_t c = 0; c < program.loopCounters; ++c) {
+        out << "    long long c" << c << " = 0";
+        if (readsRange[c]) {
+            out << ", c" << c << "_lo = 0, c" << c << "_hi = 0";
+        }
+        out << ";\n";
+    }
+    // Переменные, которые код только записывает (их значения нужны лишь для
+    // итогового состояния интерпретатора), не считаются неиспользуемыми
+    for (size_t i = 0; i < program.variables.size(); ++i) {
+        if (!readsVariable[i]) out << "    (void)" << var(static_cast<int>(i)) << ";\n";
+    }
+    out << "\n";
+
+    for (size_t pc = 0; pc < count; ++pc) {
+        if (isTarget[pc]) out << label(pc) << ": ;\n";
+        if (!typing.reached(pc)) continue;
+
+        const Instruction& ins = code[pc];
+        const size_t depth = typing.stackTypes(pc).size();
+        const std::string at = std::to_string(pc);
+        const std::string top = depth >= 1 ? slot(depth - 1) : "";
+        const std::string second = depth >= 2 ? slot(depth - 2) : "";
+        const std::string third = depth >= 3 ? slot(depth - 3) : "";
+        const std::string a = "a" + std::to_string(ins.a);
+        const std::string b = "b" + std::to_string(ins.a);
+        const bool arrayOperand = ins.a >= 0 && static_cast<size_t>(ins.a) < program.arrays.size();
+        const std::string type = arrayOperand ? arrayTypes[ins.a] : std::string();
+        const std::string type2D = arrayOperand ? arrayTypes2D[ins.a] : std::string();
+        const std::string name = arrayOperand ? program.arrays[ins.a] : std::string();
+
+        // Проверки обращений к массивам - те же сообщения, что у интерпретатора
+        auto check1D = [&](const std::string& index) {
+            return "        if (!" + a + ") ops_fail(" + stringLiteral("Массив не инициализирован: " + name) + ", " + at + ");\n"
+                   "        if (" + index + " < 0 || " + index + " >= " + a + "_n) ops_fail_index(" + index + ", " + at + ");\n";
+        };
+        auto check2D = [&](const std::string& row, const std::string& col) {
+            return "        if (!" + b + ") ops_fail(" + stringLiteral("Двумерный массив не инициализирован: " + name) + ", " + at + ");\n"
+                   "        if (" + row + " < 0 || " + row + " >= " + b + "_rows || " + col + " < 0 || " + col + " >= " + b +
+                   "_cols) ops_fail_index2(" + row + ", " + col + ", " + at + ");\n";
+        };
+        auto element2D = [&](const std::string& row, const std::string& col) {
+            return b + "[(size_t)" + row + " * " + b + "_cols + " + col + "]";
+        };
+
+        out << "    /* " << pc << ": " << commentText(program.text[pc]) << " */\n";
+        switch (ins.op) {
+            case OpCode::NOP:
+            case OpCode::LABEL:
+            case OpCode::POP:
+                break;
+            case OpCode::TEE:
+            case OpCode::STORE:
+                out << "    " << var(ins.a) << " = " << top << ";\n";
+                break;
+            case OpCode::PUSH_CONST:
+                out << "    " << slot(depth) << " = " << valueLiteral(ins.imm) << ";\n";
+                break;
+            case OpCode::PUSH_VAR:
+                out << "    " << slot(depth) << " = " << var(ins.a) << ";\n";
+                break;
+            case OpCode::DECLARE: {
+                bool real = ins.type == DataType::DOUBLE || ins.type == DataType::FLOAT;
+                out << "    " << var(ins.a) << " = " << (real ? "ops_dbl(0.0)" : "ops_int(0)") << ";\n";
+                break;
+            }
+            case OpCode::DECLARE_ASSIGN:
+                if (ins.type == DataType::INT) {
+                    out << "    " << var(ins.a) << " = ops_int(ops_as_int(" << top << "));\n";
+                } else if (ins.type == DataType::DOUBLE || ins.type == DataType::FLOAT) {
+                    out << "    " << var(ins.a) << " = ops_dbl(ops_as_dbl(" << top << "));\n";
+                } else {
+                    out << "    " << var(ins.a) << " = " << top << ";\n";
+                }
+                break;
+            case OpCode::ADD:
+                out << "    " << second << " = ops_add(" << second << ", " << top << ");\n";
+                break;
+            case OpCode::SUB:
+                out << "    " << second << " = ops_sub(" << second << ", " << top << ");\n";
+                break;
+            case OpCode::MUL:
+                out << "    " << second << " = ops_mul(" << second << ", " << top << ");\n";
+                break;
+            case OpCode::DIV:
+                out << "    if (ops_false(" << top << ")) ops_fail(\"Деление на ноль\", " << at << ");\n";
+                out << "    " << second << " = ops_div(" << second << ", " << top << ");\n";
+                break;
+            case OpCode::GT:
+                out << "    " << second << " = ops_int(ops_gt(" << second << ", " << top << "));\n";
+                break;
+            case OpCode::LT:
+                out << "    " << second << " = ops_int(ops_lt(" << second << ", " << top << "));\n";
+                break;
+            case OpCode::EQ:
+                out << "    " << second << " = ops_int(ops_eq(" << second << ", " << top << "));\n";
+                break;
+            case OpCode::ADD_I32:
+                out << "    " << second << ".i = ops_iadd(" << second << ".i, " << top << ".i);\n";
+                break;
+            case OpCode::SUB_I32:
+                out << "    " << second << ".i = ops_isub(" << second << ".i, " << top << ".i);\n";
+                break;
+            case OpCode::MUL_I32:
+                out << "    " << second << ".i = ops_imul(" << second << ".i, " << top << ".i);\n";
+                break;
+            case OpCode::DIV_I32:
+                out << "    if (" << top << ".i == 0) ops_fail(\"Деление на ноль\", " << at << ");\n";
+                out << "    " << second << ".i = " << second << ".i / " << top << ".i;\n";
+                break;
+            case OpCode::ADD_F64:
+                out << "    " << second << ".d = " << second << ".d + " << top << ".d;\n";
+                break;
+            case OpCode::SUB_F64:
+                out << "    " << second << ".d = " << second << ".d - " << top << ".d;\n";
+                break;
+            case OpCode::MUL_F64:
+                out << "    " << second << ".d = " << second << ".d * " << top << ".d;\n";
+                break;
+            case OpCode::DIV_F64:
+                out << "    if (" << top << ".d == 0.0) ops_fail(\"Деление на ноль\", " << at << ");\n";
+                out << "    " << second << ".d = " << second << ".d / " << top << ".d;\n";
+                break;
+            case OpCode::GT_I32:
+                out << "    " << second << ".i = " << second << ".i > " << top << ".i;\n";
+                break;
+            case OpCode::LT_I32:
+                out << "    " << second << ".i = " << second << ".i < " << top << ".i;\n";
+                break;
+            case OpCode::EQ_I32:
+                out << "    " << second << ".i = " << second << ".i == " << top << ".i;\n";
+                break;
+            case OpCode::GT_F64:
+                out << "    " << second << " = ops_int(" << second << ".d > " << top << ".d);\n";
+                break;
+            case OpCode::LT_F64:
+                out << "    " << second << " = ops_int(" << second << ".d < " << top << ".d);\n";
+                break;
+            case OpCode::EQ_F64:
+                out << "    " << second << " = ops_int(" << second << ".d == " << top << ".d);\n";
+                break;
+            case OpCode::JUMP:
+                out << "    goto " << label(static_cast<size_t>(ins.a)) << ";\n";
+                break;
+            case OpCode::JUMP_FALSE:
+                out << "    if (ops_false(" << top << ")) goto " << label(static_cast<size_t>(ins.a)) << ";\n";
+                break;
+            case OpCode::READ:
+                out << "    " << var(ins.a) << " = ops_dbl(ops_read(" << at << "));\n";
+                break;
+            case OpCode::WRITE:
+                out << "    ops_write(" << top << ");\n";
+                break;
+            case OpCode::ALLOC_ARRAY:
+                out << "    free(" << a << ");\n";
+                out << "    " << a << " = (" << type << "*)ops_alloc((size_t)" << ins.b << ", sizeof(" << type << "), " << at << ");\n";
+                if (readsLength[ins.a]) {
+                    out << "    " << a << "_n = " << ins.b << ";\n";
+                }
+                break;
+            case OpCode::ARRAY_GET:
+                out << "    {\n        int k = ops_as_int(" << top << ");\n" << check1D("k");
+                out << "        " << top << " = " << loadElement(type, a + "[k]") << ";\n    }\n";
+                break;
+            case OpCode::ARRAY_SET:
+                out << "    {\n        int k = ops_as_int(" << second << ");\n" << check1D("k");
+                out << "        " << a << "[k] = " << storeElement(type, top) << ";\n    }\n";
+                break;
+            case OpCode::ARRAY_READ:
+                out << "    {\n        int k = ops_as_int(" << top << ");\n" << check1D("k");
+                out << "        " << a << "[k] = " << storeElement(type, "ops_dbl(ops_read(" + at + "))") << ";\n    }\n";
+                break;
+            case OpCode::ALLOC_ARRAY_2D:
+                out << "    free(" << b << ");\n";
+                out << "    " << b << " = (" << type2D << "*)ops_alloc((size_t)" << ins.b << " * (size_t)" << ins.c
+                    << ", sizeof(" << type2D << "), " << at << ");\n";
+                if (readsRows[ins.a]) {
+                    out << "    " << b << "_rows = " << ins.b << ";\n";
+                }
+                if (readsCols[ins.a]) {
+                    out << "    " << b << "_cols = " << ins.c << ";\n";
+                }
+                break;
+            case OpCode::ARRAY_GET_2D:
+                out << "    {\n        int row = ops_as_int(" << second << "), col = ops_as_int(" << top << ");\n"
+                    << check2D("row", "col");
+                out << "        " << second << " = " << loadElement(type2D, element2D("row", "col")) << ";\n    }\n";
+                break;
+            case OpCode::ARRAY_SET_2D:
+                out << "    {\n        int row = ops_as_int(" << third << "), col = ops_as_int(" << second << ");\n"
+                    << check2D("row", "col");
+                out << "        " << element2D("row", "col") << " = " << storeElement(type2D, top) << ";\n    }\n";
+                break;
+            case OpCode::ARRAY_READ_2D:
+                out << "    {\n        int row = ops_as_int(" << second << "), col = ops_as_int(" << top << ");\n"
+                    << check2D("row", "col");
+                out << "        " << element2D("row", "col") << " = "
+                    << storeElement(type2D, "ops_dbl(ops_read(" + at + "))") << ";\n    }\n";
+                break;
+            case OpCode::INC_VAR: {
+                const std::string v = var(ins.a);
+                switch (ins.fused) {
+                    case OpCode::ADD_I32: out << "    " << v << ".i = ops_iadd(" << v << ".i, " << intLiteral(ins.imm.asInt()) << ");\n"; break;
+                    case OpCode::SUB_I32: out << "    " << v << ".i = ops_isub(" << v << ".i, " << intLiteral(ins.imm.asInt()) << ");\n"; break;
+                    case OpCode::ADD_F64: out << "    " << v << ".d = " << v << ".d + " << doubleLiteral(ins.imm.asDouble()) << ";\n"; break;
+                    case OpCode::SUB_F64: out << "    " << v << ".d = " << v << ".d - " << doubleLiteral(ins.imm.asDouble()) << ";\n"; break;
+                    case OpCode::SUB:     out << "    " << v << " = ops_sub(" << v << ", " << valueLiteral(ins.imm) << ");\n"; break;
+                    default:              out << "    " << v << " = ops_add(" << v << ", " << valueLiteral(ins.imm) << ");\n"; break;
+                }
+                break;
+            }
+            case OpCode::CMP_VAR_VAR_JF:
+            case OpCode::CMP_VAR_CONST_JF: {
+                Operand rhs = ins.op == OpCode::CMP_VAR_VAR_JF ? variableOperand(ins.c) : constantOperand(ins.imm);
+                out << "    if (!(" << compare(ins.fused, variableOperand(ins.b), rhs) << ")) goto "
+                    << label(static_cast<size_t>(ins.a)) << ";\n";
+                break;
+            }
+            case OpCode::LOAD_ELEM_VAR_INDEX:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+                out << "    {\n        int k = ops_as_int(" << var(ins.b) << ");\n" << check1D("k");
+                out << "        " << slot(depth) << " = " << loadElement(type, a + "[k]") << ";\n    }\n";
+                if (ins.op == OpCode::LOAD_ELEM_VAR_INDEX_TEE) {
+                    out << "    " << var(ins.c) << " = " << slot(depth) << ";\n";
+                }
+                break;
+            case OpCode::LOOP_INIT: {
+                const std::string counter = "c" + std::to_string(ins.c);
+                const std::string step = intLiteral(ins.imm.asInt());
+                out << "    {\n        int start = ops_as_int(" << var(ins.b) << ");\n";
+                out << "        " << counter << " = ops_trip_count(start, " << top << ", " << step << ", "
+                    << (ins.fused == OpCode::LT ? 1 : 0) << ");\n";
+                out << "        if (" << counter << " <= 0) goto " << label(static_cast<size_t>(ins.a)) << ";\n";
+                // Диапазон значений переменной цикла нужен только охране границ
+                if (readsRange[ins.c]) {
+                    out << "        long long last = start + (" << counter << " - 1) * " << step << ";\n";
+                    out << "        " << counter << "_lo = start < last ? start : last;\n";
+                    out << "        " << counter << "_hi = start < last ? last : start;\n";
+                }
+                out << "    }\n";
+                break;
+            }
+            case OpCode::LOOP_NEXT: {
+                const std::string counter = "c" + std::to_string(ins.c);
+                out << "    " << var(ins.b) << " = ops_int(ops_iadd(ops_as_int(" << var(ins.b) << "), "
+                    << intLiteral(ins.imm.asInt()) << "));\n";
+                out << "    if (--" << counter << " > 0) goto " << label(static_cast<size_t>(ins.a)) << ";\n";
+                break;
+            }
+            case OpCode::GUARD_INDEX:
+            case OpCode::GUARD_ROW:
+            case OpCode::GUARD_COL: {
+                const std::string counter = "c" + std::to_string(ins.c);
+                const std::string offset = intLiteral(ins.imm.asInt());
+                std::string extent;
+                if (ins.op == OpCode::GUARD_INDEX) {
+                    extent = "(a" + std::to_string(ins.b) + " ? a" + std::to_string(ins.b) + "_n : 0)";
+                } else {
+                    const std::string dimension = ins.op == OpCode::GUARD_ROW ? "_rows" : "_cols";
+                    extent = "(b" + std::to_string(ins.b) + " ? b" + std::to_string(ins.b) + dimension + " : 0)";
+                }
+                out << "    if (!(" << counter << "_lo + " << offset << " >= 0 && " << counter << "_hi + " << offset
+                    << " < " << extent << ")) goto " << label(static_cast<size_t>(ins.a)) << ";\n";
+                break;
+            }
+            case OpCode::ARRAY_GET_UNCHECKED:
+                out << "    " << top << " = " << loadElement(type, a + "[" + top + ".i]") << ";\n";
+                break;
+            case OpCode::ARRAY_SET_UNCHECKED:
+                out << "    " << a << "[" << second << ".i] = " << storeElement(type, top) << ";\n";
+                break;
+            case OpCode::ARRAY_GET_2D_UNCHECKED:
+                out << "    " << second << " = " << loadElement(type2D, element2D(second + ".i", top + ".i")) << ";\n";
+                break;
+            case OpCode::ARRAY_SET_2D_UNCHECKED:
+                out << "    " << element2D(third + ".i", second + ".i") << " = " << storeElement(type2D, top) << ";\n";
+                break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+                out << "    " << slot(depth) << " = " << loadElement(type, a + "[" + var(ins.b) + ".i]") << ";\n";
+                if (ins.op == OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED) {
+                    out << "    " << var(ins.c) << " = " << slot(depth) << ";\n";
+                }
+                break;
+        }
+    }
+
+    if (isTarget[count]) out << label(count) << ": ;\n";
+    out << "    ops_flush();\n";
+    out << "    return 0;\n";
+    out << "}\n";
+    return out.str();
+}
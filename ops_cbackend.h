@@ -0,0 +1,33 @@
+#ifndef OPS_CBACKEND_H
+#define OPS_CBACKEND_H
+
+#include <string>
+#include <vector>
+#include "ops_program.h"
+
+// Заблаговременная компиляция: программа ОПС переводится в самостоятельный
+// исходный текст на C, который собирается системным компилятором C. Программа
+// компонуется, специализируется по типам и сливается так же, как перед
+// выполнением интерпретатором. Переменные становятся локальными переменными
+// main, ячейки стека операндов - локальными переменными по глубине стека,
+// массивы - буферами в куче родного типа элементов, адреса переходов - метками
+// goto, r / w - буферизованным вводом из stdin и выводом в stdout. Ошибки
+// выполнения (деление на ноль, выход за границы) завершают программу с кодом 1
+class OPSCBackend {
+public:
+    // rawOutput - вывод w без префикса "ВЫВОД:" (как --raw-output)
+    explicit OPSCBackend(bool rawOutput = false);
+
+    // Исходный текст на C; программа - после оптимизатора, до компоновки.
+    // Программа, которую нельзя перевести (глубина стека различается на
+    // разных путях, у массива разные типы элементов), - std::runtime_error
+    std::string translate(const OPSProgram& program) const;
+
+private:
+    bool raw;
+
+    // Тип элементов массива в C (int32_t, double, uint8_t) по всем его выделениям
+    std::vector<std::string> elementTypes(const OPSProgram& program, bool twoDimensional) const;
+};
+
+#endif // OPS_CBACKEND_H
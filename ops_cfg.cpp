@@ -0,0 +1,133 @@
+#include "ops_cfg.h"
+#include <algorithm>
+
+ControlFlowGraph ControlFlowGraph::build(const OPSProgram& program) {
+    const std::vector<Instruction>& code = program.code;
+    ControlFlowGraph graph;
+    graph.blockOf.assign(code.size(), 0);
+    if (code.empty()) return graph;
+
+    // Начало блока: первая команда, метка, команда после перехода
+    std::vector<bool> leader(code.size(), false);
+    leader[0] = true;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].op == OpCode::LABEL) leader[i] = true;
+        if ((code[i].op == OpCode::JUMP || isConditionalJump(code[i].op)) && i + 1 < code.size()) {
+            leader[i + 1] = true;
+        }
+    }
+
+    std::vector<long> labelBlock(program.labels.size(), -1);
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (leader[i]) {
+            if (!graph.blocks.empty()) graph.blocks.back().end = i;
+            graph.blocks.push_back(Block());
+            graph.blocks.back().begin = i;
+        }
+        graph.blockOf[i] = graph.blocks.size() - 1;
+        if (code[i].op == OpCode::LABEL) {
+            labelBlock[code[i].a] = static_cast<long>(graph.blocks.size() - 1);
+        }
+    }
+    graph.blocks.back().end = code.size();
+
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        const Instruction& last = code[graph.blocks[b].end - 1];
+        std::vector<size_t>& successors = graph.blocks[b].successors;
+        if (last.op != OpCode::JUMP && b + 1 < graph.blocks.size()) {
+            successors.push_back(b + 1);
+        }
+        if ((last.op == OpCode::JUMP || isConditionalJump(last.op)) && labelBlock[last.a] >= 0) {
+            size_t target = static_cast<size_t>(labelBlock[last.a]);
+            if (successors.empty() || successors[0] != target) successors.push_back(target);
+        }
+        for (size_t successor : successors) {
+            graph.blocks[successor].predecessors.push_back(b);
+        }
+    }
+    return graph;
+}
+
+std::vector<bool> ControlFlowGraph::reachable() const {
+    std::vector<bool> reached(blocks.size(), false);
+    if (blocks.empty()) return reached;
+
+    std::vector<size_t> worklist = {0};
+    reached[0] = true;
+    while (!worklist.empty()) {
+        size_t b = worklist.back();
+        worklist.pop_back();
+        for (size_t successor : blocks[b].successors) {
+            if (!reached[successor]) {
+                reached[successor] = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+    return reached;
+}
+
+std::vector<ControlFlowGraph::Loop> ControlFlowGraph::loops() const {
+    std::vector<Loop> found;
+    std::vector<bool> reached = reachable();
+
+    for (size_t latch = 0; latch < blocks.size(); ++latch) {
+        if (!reached[latch]) continue;
+        for (size_t header : blocks[latch].successors) {
+            if (header > latch) continue;
+
+            Loop loop;
+            loop.header = header;
+            loop.latch = latch;
+            loop.body.assign(blocks.size(), false);
+            loop.body[header] = true;
+            loop.size = 1;
+
+            // Обратный обход от блока с переходом до заголовка
+            std::vector<size_t> worklist;
+            if (!loop.body[latch]) {
+                loop.body[latch] = true;
+                loop.size++;
+                worklist.push_back(latch);
+            }
+            while (!worklist.empty()) {
+                size_t b = worklist.back();
+                worklist.pop_back();
+                for (size_t predecessor : blocks[b].predecessors) {
+                    if (loop.body[predecessor] || !reached[predecessor]) continue;
+                    loop.body[predecessor] = true;
+                    loop.size++;
+                    worklist.push_back(predecessor);
+                }
+            }
+            found.push_back(std::move(loop));
+        }
+    }
+
+    std::stable_sort(found.begin(), found.end(), [](const Loop& a, const Loop& b) {
+        return a.size < b.size;
+    });
+    return found;
+}
+
+bool ControlFlowGraph::enteredByFallthrough(const OPSProgram& program, const Loop& loop) const {
+    const Block& header = blocks[loop.header];
+    const Instruction& label = program.code[header.begin];
+    if (label.op != OpCode::LABEL) return false;
+
+    for (size_t predecessor : header.predecessors) {
+        if (loop.body[predecessor]) continue;
+        if (predecessor + 1 != loop.header) return false;
+        const Instruction& last = program.code[blocks[predecessor].end - 1];
+        if ((last.op == OpCode::JUMP || last.op == OpCode::JUMP_FALSE) && last.a == label.a) return false;
+    }
+
+    // В тело цикла можно попасть только через заголовок
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (!loop.body[b] || b == loop.header) continue;
+        for (size_t predecessor : blocks[b].predecessors) {
+            if (!loop.body[predecessor]) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef OPS_CFG_H
+#define OPS_CFG_H
+
+#include <vector>
+#include "ops_program.h"
+
+// Граф потока управления нескомпонованной программы: базовые блоки
+// разделяются метками mN: и командами перехода (j, jf, циклы со счётчиком)
+struct ControlFlowGraph {
+    struct Block {
+        size_t begin = 0;              // первая команда блока
+        size_t end = 0;                // за последней командой
+        std::vector<size_t> successors;
+        std::vector<size_t> predecessors;
+    };
+
+    // Естественный цикл: заголовок (метка начала цикла), блок с обратным
+    // переходом mN j и все блоки, из которых он достижим без захода в заголовок
+    struct Loop {
+        size_t header = 0;
+        size_t latch = 0;
+        std::vector<bool> body;        // принадлежность блоков циклу
+        size_t size = 0;               // число блоков в цикле
+    };
+
+    std::vector<Block> blocks;
+    std::vector<size_t> blockOf;       // номер блока для каждой команды
+
+    static ControlFlowGraph build(const OPSProgram& program);
+
+    // Блоки, достижимые из первого
+    std::vector<bool> reachable() const;
+
+    // Циклы по обратным переходам (на блок, стоящий не дальше перехода),
+    // от внутренних к внешним
+    std::vector<Loop> loops() const;
+
+    // Вход в цикл только проходом из предыдущего блока в метку заголовка (без
+    // перехода на неё) и только через заголовок: код, вставленный перед меткой,
+    // выполняется ровно один раз перед циклом
+    bool enteredByFallthrough(const OPSProgram& program, const Loop& loop) const;
+};
+
+#endif // OPS_CFG_H
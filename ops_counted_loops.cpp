@@ -0,0 +1,168 @@
+#include "ops_counted_loops.h"
+#include <climits>
+
+namespace {
+
+bool definesVariable(OpCode op) {
+    return op == OpCode::STORE || op == OpCode::TEE || op == OpCode::DECLARE_ASSIGN ||
+           op == OpCode::DECLARE || op == OpCode::READ;
+}
+
+bool isPush(OpCode op) {
+    return op == OpCode::PUSH_CONST || op == OpCode::PUSH_VAR;
+}
+
+bool isIntConstant(const Instruction& ins) {
+    return ins.op == OpCode::PUSH_CONST && ins.imm.isInt();
+}
+
+} // namespace
+
+size_t OPSCountedLoops::optimize(OPSProgram& program) const {
+    if (program.linked) return 0;
+
+    // После переписывания позиции команд сдвигаются - граф строится заново
+    size_t total = 0;
+    bool lowered = true;
+    while (lowered) {
+        lowered = false;
+        ControlFlowGraph graph = ControlFlowGraph::build(program);
+        for (const ControlFlowGraph::Loop& loop : graph.loops()) {
+            if (!graph.enteredByFallthrough(program, loop)) continue;
+            CountedLoop counted;
+            if (!recognize(program, graph, loop, counted)) continue;
+            rewrite(program, counted);
+            total++;
+            lowered = true;
+            break;
+        }
+    }
+    return total;
+}
+
+bool OPSCountedLoops::recognize(const OPSProgram& program, const ControlFlowGraph& graph,
+                                const ControlFlowGraph::Loop& loop, CountedLoop& counted) const {
+    const std::vector<Instruction>& code = program.code;
+
+    // Заголовок: mS: i n < mE jf - и больше ничего
+    const ControlFlowGraph::Block& header = graph.blocks[loop.header];
+    if (loop.header == 0 || header.end - header.begin != 5) return false;
+    const Instruction& load = code[header.begin + 1];
+    const Instruction& bound = code[header.begin + 2];
+    const Instruction& compare = code[header.begin + 3];
+    const Instruction& exit = code[header.begin + 4];
+    if (load.op != OpCode::PUSH_VAR || !isPush(bound.op) || exit.op != OpCode::JUMP_FALSE) return false;
+    if (compare.op != OpCode::LT && compare.op != OpCode::GT) return false;
+    if (bound.op == OpCode::PUSH_VAR && bound.a == load.a) return false;
+    const int variable = load.a;
+
+    // Обратный переход в заголовок ровно один - из конца тела
+    for (size_t predecessor : header.predecessors) {
+        if (loop.body[predecessor] && predecessor != loop.latch) return false;
+    }
+
+    // Конец тела: i s + i := mS j (или i s - i :=), сразу за ним метка выхода
+    const ControlFlowGraph::Block& latch = graph.blocks[loop.latch];
+    if (latch.end - latch.begin < 5) return false;
+    const size_t increment = latch.end - 5;
+    const Instruction& step = code[increment + 1];
+    const Instruction& add = code[increment + 2];
+    const Instruction& store = code[increment + 3];
+    const Instruction& back = code[increment + 4];
+    if (code[increment].op != OpCode::PUSH_VAR || code[increment].a != variable) return false;
+    if (!isIntConstant(step) || (add.op != OpCode::ADD && add.op != OpCode::SUB)) return false;
+    if (store.op != OpCode::STORE || store.a != variable) return false;
+    if (back.op != OpCode::JUMP || back.a != code[header.begin].a) return false;
+    if (add.op == OpCode::SUB && step.imm.asInt() == INT_MIN) return false;
+
+    int stride = add.op == OpCode::ADD ? step.imm.asInt() : -step.imm.asInt();
+    if (compare.op == OpCode::LT ? stride <= 0 : stride >= 0) return false;
+
+    bool exits = false;
+    for (size_t k = latch.end; k < code.size() && code[k].op == OpCode::LABEL; ++k) {
+        if (code[k].a == exit.a) exits = true;
+    }
+    if (!exits) return false;
+
+    // В теле не меняются ни переменная цикла (кроме приращения), ни граница
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (!loop.body[b]) continue;
+        for (size_t i = graph.blocks[b].begin; i < graph.blocks[b].end; ++i) {
+            const Instruction& ins = code[i];
+            if (!definesVariable(ins.op)) continue;
+            if (ins.a == variable && i != increment + 3) return false;
+            if (bound.op == OpCode::PUSH_VAR && ins.a == bound.a) return false;
+        }
+    }
+
+    if (!startsAsInt(program, graph.blocks[loop.header - 1], variable)) return false;
+
+    counted.condition = header.begin + 1;
+    counted.increment = increment;
+    counted.variable = variable;
+    counted.step = stride;
+    counted.compare = compare.op;
+    return true;
+}
+
+bool OPSCountedLoops::startsAsInt(const OPSProgram& program, const ControlFlowGraph::Block& block,
+                                  int variable) const {
+    // Последнее присваивание перед циклом: int i = a, int i или i := <целая константа>
+    const std::vector<Instruction>& code = program.code;
+    for (size_t i = block.end; i-- > block.begin;) {
+        const Instruction& ins = code[i];
+        if (!definesVariable(ins.op) || ins.a != variable) continue;
+        if (ins.op == OpCode::DECLARE || ins.op == OpCode::DECLARE_ASSIGN) return ins.type == DataType::INT;
+        return ins.op == OpCode::STORE && i > block.begin && isIntConstant(code[i - 1]);
+    }
+    return false;
+}
+
+void OPSCountedLoops::rewrite(OPSProgram& program, const CountedLoop& counted) const {
+    const std::vector<Instruction>& code = program.code;
+    const size_t label = counted.condition - 1;
+    const int startLabel = code[label].a;
+    const int exitLabel = code[counted.condition + 3].a;
+    const std::string& name = program.variables[counted.variable];
+
+    Instruction init;
+    init.op = OpCode::LOOP_INIT;
+    init.a = exitLabel;
+    init.b = counted.variable;
+    init.c = static_cast<int>(program.loopCounters++);
+    init.imm = Value(counted.step);
+    init.fused = counted.compare;
+
+    Instruction next = init;
+    next.op = OpCode::LOOP_NEXT;
+    next.a = startLabel;
+
+    std::vector<Instruction> rewritten;
+    std::vector<std::string> text;
+    rewritten.reserve(code.size());
+    text.reserve(code.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (i == label) {
+            // Граница и число итераций - перед меткой начала, один раз на вход в цикл
+            rewritten.push_back(code[counted.condition + 1]);
+            text.push_back(program.text[counted.condition + 1]);
+            rewritten.push_back(init);
+            text.push_back(program.labels[exitLabel] + " " + name + " loop_init");
+            rewritten.push_back(code[label]);
+            text.push_back(program.text[label]);
+            i = counted.condition + 3;
+            continue;
+        }
+        if (i == counted.increment) {
+            rewritten.push_back(next);
+            text.push_back(program.labels[startLabel] + " " + name + " loop_next");
+            i = counted.increment + 4;
+            continue;
+        }
+        rewritten.push_back(code[i]);
+        text.push_back(program.text[i]);
+    }
+
+    program.code = std::move(rewritten);
+    program.text = std::move(text);
+}
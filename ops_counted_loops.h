@@ -0,0 +1,39 @@
+#ifndef OPS_COUNTED_LOOPS_H
+#define OPS_COUNTED_LOOPS_H
+
+#include "ops_cfg.h"
+
+// Циклы со счётчиком. Распознаётся индуктивная переменная цикла for/while:
+//   int i = a; mS: i n < mE jf <тело> i s + i := mS j mE:
+// где i меняется только приращением на целую константу s в конце тела,
+// а граница n (константа или переменная) в цикле не меняется. Такой цикл
+// переписывается в
+//   int i = a; n mE i loop_init mS: <тело> mS i loop_next mE:
+// loop_init один раз вычисляет число итераций, loop_next за одну команду
+// увеличивает i, уменьшает счётчик и переходит на начало тела.
+// Работает по нескомпонованной программе
+class OPSCountedLoops {
+public:
+    // Возвращает число переписанных циклов
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    // Распознанный цикл: позиции условия в заголовке и приращения в конце тела
+    struct CountedLoop {
+        size_t condition = 0;   // i n < mE jf
+        size_t increment = 0;   // i s + i := mS j
+        int variable = 0;
+        int step = 0;
+        OpCode compare = OpCode::LT;
+    };
+
+    bool recognize(const OPSProgram& program, const ControlFlowGraph& graph,
+                   const ControlFlowGraph::Loop& loop, CountedLoop& counted) const;
+
+    // Перед циклом переменная получает целое значение
+    bool startsAsInt(const OPSProgram& program, const ControlFlowGraph::Block& block, int variable) const;
+
+    void rewrite(OPSProgram& program, const CountedLoop& counted) const;
+};
+
+#endif // OPS_COUNTED_LOOPS_H
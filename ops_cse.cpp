@@ -0,0 +1,257 @@
+#include "ops_cse.h"
+#include <charconv>
+#include <unordered_map>
+
+namespace {
+
+bool isPush(OpCode op) {
+    return op == OpCode::PUSH_CONST || op == OpCode::PUSH_VAR;
+}
+
+// Число операндов выражения, заканчивающегося командой op (0 - не выражение)
+int operandCount(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV:
+        case OpCode::GT: case OpCode::LT: case OpCode::EQ:
+        case OpCode::ARRAY_GET_2D:
+            return 2;
+        case OpCode::ARRAY_GET:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+std::string operandKey(const Instruction& ins) {
+    if (ins.op == OpCode::PUSH_VAR) return "v" + std::to_string(ins.a);
+    if (ins.imm.isInt()) return "i" + std::to_string(ins.imm.asInt());
+    char buffer[64];
+    auto converted = std::to_chars(buffer, buffer + sizeof(buffer), ins.imm.asDouble());
+    return "d" + std::string(buffer, converted.ptr);
+}
+
+// x c + x := сливается в INC_VAR - чтение временной переменной было бы дороже
+bool fusesToIncrement(const std::vector<Instruction>& code, size_t start, size_t end) {
+    return (code[end].op == OpCode::ADD || code[end].op == OpCode::SUB) &&
+           end + 1 < code.size() && code[end + 1].op == OpCode::STORE &&
+           code[start].op == OpCode::PUSH_VAR && code[start].a == code[end + 1].a &&
+           code[start + 1].op == OpCode::PUSH_CONST;
+}
+
+} // namespace
+
+size_t OPSCommonSubexpressions::optimize(OPSProgram& program) const {
+    if (program.linked) return 0;
+
+    // Заменённое выражение может стать операндом следующего: i 1 + arr array_get
+    size_t total = 0;
+    while (true) {
+        size_t replaced = eliminate(program);
+        if (replaced == 0) break;
+        total += replaced;
+    }
+    return total;
+}
+
+bool OPSCommonSubexpressions::match(const OPSProgram& program, size_t blockBegin, size_t end,
+                                    size_t& start, std::string& key) const {
+    const std::vector<Instruction>& code = program.code;
+    const Instruction& ins = code[end];
+    size_t count = static_cast<size_t>(operandCount(ins.op));
+    if (count == 0 || end < blockBegin + count) return false;
+
+    // Операнды - команды, непосредственно предшествующие операции
+    start = end - count;
+    key = std::to_string(static_cast<int>(ins.op));
+    if (ins.op == OpCode::ARRAY_GET || ins.op == OpCode::ARRAY_GET_2D) {
+        key += "@" + std::to_string(ins.a);
+    }
+    for (size_t i = start; i < end; ++i) {
+        if (!isPush(code[i].op)) return false;
+        key += " " + operandKey(code[i]);
+    }
+    return true;
+}
+
+void OPSCommonSubexpressions::kill(const Instruction& ins, const std::vector<Expression>& expressions,
+                                   std::vector<bool>& available) const {
+    switch (ins.op) {
+        case OpCode::STORE:
+        case OpCode::TEE:
+        case OpCode::DECLARE:
+        case OpCode::DECLARE_ASSIGN:
+        case OpCode::READ:
+            for (size_t e = 0; e < expressions.size(); ++e) {
+                for (int variable : expressions[e].variables) {
+                    if (variable == ins.a) available[e] = false;
+                }
+            }
+            break;
+        case OpCode::ALLOC_ARRAY:
+        case OpCode::ARRAY_SET:
+        case OpCode::ARRAY_READ:
+            for (size_t e = 0; e < expressions.size(); ++e) {
+                if (expressions[e].op == OpCode::ARRAY_GET && expressions[e].array == ins.a) available[e] = false;
+            }
+            break;
+        case OpCode::ALLOC_ARRAY_2D:
+        case OpCode::ARRAY_SET_2D:
+        case OpCode::ARRAY_READ_2D:
+            for (size_t e = 0; e < expressions.size(); ++e) {
+                if (expressions[e].op == OpCode::ARRAY_GET_2D && expressions[e].array == ins.a) available[e] = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+size_t OPSCommonSubexpressions::eliminate(OPSProgram& program) const {
+    const std::vector<Instruction>& code = program.code;
+    ControlFlowGraph graph = ControlFlowGraph::build(program);
+
+    // Все вхождения выражений; одинаковые выражения получают один номер
+    std::vector<Expression> expressions;
+    std::vector<Occurrence> occurrences;
+    std::unordered_map<std::string, size_t> expressionIndex;
+    std::vector<long> occurrenceAt(code.size(), -1);   // по последней команде выражения
+    for (const ControlFlowGraph::Block& block : graph.blocks) {
+        for (size_t i = block.begin; i < block.end; ++i) {
+            size_t start;
+            std::string key;
+            if (!match(program, block.begin, i, start, key)) continue;
+
+            auto found = expressionIndex.find(key);
+            if (found == expressionIndex.end()) {
+                Expression expression;
+                expression.op = code[i].op;
+                expression.array = code[i].a;
+                for (size_t k = start; k < i; ++k) {
+                    if (code[k].op == OpCode::PUSH_VAR) expression.variables.push_back(code[k].a);
+                }
+                found = expressionIndex.emplace(key, expressions.size()).first;
+                expressions.push_back(expression);
+            }
+
+            Occurrence occurrence;
+            occurrence.start = start;
+            occurrence.end = i;
+            occurrence.expression = found->second;
+            occurrenceAt[i] = static_cast<long>(occurrences.size());
+            occurrences.push_back(occurrence);
+        }
+    }
+    if (occurrences.empty()) return 0;
+
+    // Доступные выражения: анализ вперёд, встреча - пересечение по предшественникам
+    const size_t blockCount = graph.blocks.size();
+    const size_t expressionCount = expressions.size();
+    std::vector<bool> reached = graph.reachable();
+    std::vector<std::vector<bool>> in(blockCount, std::vector<bool>(expressionCount, true));
+    std::vector<std::vector<bool>> out(blockCount, std::vector<bool>(expressionCount, true));
+
+    auto walk = [&](size_t b, std::vector<bool>& available, bool mark) {
+        for (size_t i = graph.blocks[b].begin; i < graph.blocks[b].end; ++i) {
+            if (occurrenceAt[i] >= 0) {
+                Occurrence& occurrence = occurrences[static_cast<size_t>(occurrenceAt[i])];
+                if (mark && available[occurrence.expression] &&
+                    !fusesToIncrement(code, occurrence.start, occurrence.end)) {
+                    occurrence.redundant = true;
+                }
+                available[occurrence.expression] = true;
+            }
+            kill(code[i], expressions, available);
+        }
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < blockCount; ++b) {
+            if (!reached[b]) continue;
+            // Вход в программу: ничего ещё не вычислено
+            std::vector<bool> state(expressionCount, b != 0);
+            for (size_t predecessor : graph.blocks[b].predecessors) {
+                if (!reached[predecessor]) continue;
+                for (size_t e = 0; e < expressionCount; ++e) {
+                    if (!out[predecessor][e]) state[e] = false;
+                }
+            }
+            in[b] = state;
+            walk(b, state, false);
+            if (state != out[b]) {
+                out[b] = std::move(state);
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t b = 0; b < blockCount; ++b) {
+        if (!reached[b]) continue;
+        std::vector<bool> state = in[b];
+        walk(b, state, true);
+    }
+
+    // Временная переменная для каждого выражения, вычисляемого повторно
+    std::vector<int> temporary(expressionCount, -1);
+    size_t temporaries = 0;
+    for (const std::string& name : program.variables) {
+        if (isTemporaryName(name)) temporaries++;
+    }
+    size_t replaced = 0;
+    for (const Occurrence& occurrence : occurrences) {
+        if (!occurrence.redundant) continue;
+        replaced++;
+        int& slot = temporary[occurrence.expression];
+        if (slot < 0) {
+            slot = static_cast<int>(program.variables.size());
+            program.variables.push_back(temporaryName(temporaries++));
+        }
+    }
+    if (replaced == 0) return 0;
+
+    std::vector<Instruction> rewritten;
+    std::vector<std::string> text;
+    rewritten.reserve(code.size() + replaced);
+    text.reserve(code.size() + replaced);
+    std::vector<long> occurrenceFrom(code.size(), -1);
+    for (size_t k = 0; k < occurrences.size(); ++k) {
+        occurrenceFrom[occurrences[k].start] = static_cast<long>(k);
+    }
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (occurrenceFrom[i] >= 0) {
+            const Occurrence& occurrence = occurrences[static_cast<size_t>(occurrenceFrom[i])];
+            int slot = temporary[occurrence.expression];
+            if (occurrence.redundant) {
+                // Повторное вычисление - чтение сохранённого результата
+                Instruction load;
+                load.op = OpCode::PUSH_VAR;
+                load.a = slot;
+                rewritten.push_back(load);
+                text.push_back(program.variables[slot]);
+                i = occurrence.end;
+                continue;
+            }
+        }
+
+        rewritten.push_back(code[i]);
+        text.push_back(program.text[i]);
+
+        if (occurrenceAt[i] >= 0) {
+            int slot = temporary[occurrences[static_cast<size_t>(occurrenceAt[i])].expression];
+            if (slot >= 0) {
+                // Первое вычисление сохраняет результат для повторных
+                Instruction tee;
+                tee.op = OpCode::TEE;
+                tee.a = slot;
+                rewritten.push_back(tee);
+                text.push_back(program.variables[slot] + " tee");
+            }
+        }
+    }
+
+    program.code = std::move(rewritten);
+    program.text = std::move(text);
+    return replaced;
+}
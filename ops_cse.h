@@ -0,0 +1,47 @@
+#ifndef OPS_CSE_H
+#define OPS_CSE_H
+
+#include <string>
+#include <vector>
+#include "ops_cfg.h"
+
+// Устранение общих подвыражений по графу потока управления (в блоке и между
+// блоками). Выражение - операция над простыми операндами (переменная или
+// константа): x y +, k arr array_get, i j M array_get_2d. Если выражение уже
+// вычислено на всех путях и ни операнды, ни массив с тех пор не менялись,
+// повторное вычисление заменяется чтением временной переменной $tN, а первое
+// вычисление сохраняет результат командой tee.
+// Работает по нескомпонованной программе
+class OPSCommonSubexpressions {
+public:
+    // Возвращает число заменённых вычислений
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    // Вхождение выражения в поток команд: команды [start, end]
+    struct Occurrence {
+        size_t start = 0;
+        size_t end = 0;
+        size_t expression = 0;
+        bool redundant = false;
+    };
+
+    // Выражение и множество переменных/массивов, запись в которые его убивает
+    struct Expression {
+        OpCode op = OpCode::NOP;
+        int array = -1;
+        std::vector<int> variables;
+    };
+
+    size_t eliminate(OPSProgram& program) const;
+
+    // Выражение, заканчивающееся командой end; false - не подходит
+    bool match(const OPSProgram& program, size_t blockBegin, size_t end,
+               size_t& start, std::string& key) const;
+
+    // Команда делает недействительными выражения (запись переменной или массива)
+    void kill(const Instruction& ins, const std::vector<Expression>& expressions,
+              std::vector<bool>& available) const;
+};
+
+#endif // OPS_CSE_H
@@ -0,0 +1,165 @@
+#include "ops_deadcode.h"
+
+namespace {
+
+bool isPush(OpCode op) {
+    return op == OpCode::PUSH_CONST || op == OpCode::PUSH_VAR;
+}
+
+// Команда задаёт новое значение переменной в поле a
+bool definesVariable(OpCode op) {
+    return op == OpCode::STORE || op == OpCode::TEE || op == OpCode::DECLARE_ASSIGN ||
+           op == OpCode::DECLARE || op == OpCode::READ;
+}
+
+// Шаг анализа живых переменных назад через одну команду
+void transfer(const Instruction& ins, std::vector<bool>& live) {
+    if (definesVariable(ins.op)) {
+        live[ins.a] = false;
+    } else if (ins.op == OpCode::PUSH_VAR) {
+        live[ins.a] = true;
+    }
+}
+
+// Живые переменные в конце программы: временные переменные оптимизатора
+// в итоговом состоянии не показываются
+std::vector<bool> liveAtExit(const OPSProgram& program, bool keepFinalState) {
+    std::vector<bool> live(program.variables.size(), false);
+    for (size_t v = 0; v < live.size(); ++v) {
+        live[v] = keepFinalState && !isTemporaryName(program.variables[v]);
+    }
+    return live;
+}
+
+// Пересборка потока команд без помеченных к удалению
+void compact(OPSProgram& program, const std::vector<bool>& removed) {
+    std::vector<Instruction> code;
+    std::vector<std::string> text;
+    code.reserve(program.code.size());
+    text.reserve(program.text.size());
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        if (removed[i]) continue;
+        code.push_back(program.code[i]);
+        text.push_back(program.text[i]);
+    }
+    program.code = std::move(code);
+    program.text = std::move(text);
+}
+
+} // namespace
+
+OPSDeadCode::OPSDeadCode(bool keepState) : keepFinalState(keepState) {}
+
+size_t OPSDeadCode::optimize(OPSProgram& program) const {
+    if (program.linked) return 0;
+
+    // Удалённое присваивание может сделать мёртвым предыдущее
+    size_t total = 0;
+    while (true) {
+        size_t removed = removeUnreachable(program);
+        removed += removeDeadStores(program);
+        if (removed == 0) break;
+        total += removed;
+    }
+    return total;
+}
+
+size_t OPSDeadCode::removeUnreachable(OPSProgram& program) const {
+    ControlFlowGraph graph = ControlFlowGraph::build(program);
+    std::vector<bool> reached = graph.reachable();
+
+    // Метки остаются: после компоновки они ничего не стоят, а таблица адресов
+    // меток остаётся полной
+    std::vector<bool> removed(program.code.size(), false);
+    size_t count = 0;
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (reached[b]) continue;
+        for (size_t i = graph.blocks[b].begin; i < graph.blocks[b].end; ++i) {
+            if (program.code[i].op == OpCode::LABEL) continue;
+            removed[i] = true;
+            count++;
+        }
+    }
+
+    if (count > 0) compact(program, removed);
+    return count;
+}
+
+std::vector<std::vector<bool>> OPSDeadCode::liveIn(const OPSProgram& program,
+                                                   const ControlFlowGraph& graph) const {
+    const size_t variableCount = program.variables.size();
+    std::vector<std::vector<bool>> live(graph.blocks.size(), std::vector<bool>(variableCount, false));
+    const std::vector<bool> atExit = liveAtExit(program, keepFinalState);
+
+    // Обратный анализ до неподвижной точки; блоки обходятся с конца,
+    // чтобы за один проход охватить ациклический код
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = graph.blocks.size(); b-- > 0;) {
+            const ControlFlowGraph::Block& block = graph.blocks[b];
+            std::vector<bool> state = block.successors.empty() ? atExit : std::vector<bool>(variableCount, false);
+            for (size_t successor : block.successors) {
+                for (size_t v = 0; v < variableCount; ++v) {
+                    if (live[successor][v]) state[v] = true;
+                }
+            }
+            for (size_t i = block.end; i-- > block.begin;) {
+                transfer(program.code[i], state);
+            }
+            if (state != live[b]) {
+                live[b] = std::move(state);
+                changed = true;
+            }
+        }
+    }
+    return live;
+}
+
+size_t OPSDeadCode::removeDeadStores(OPSProgram& program) const {
+    ControlFlowGraph graph = ControlFlowGraph::build(program);
+    std::vector<std::vector<bool>> live = liveIn(program, graph);
+    const size_t variableCount = program.variables.size();
+    const std::vector<bool> atExit = liveAtExit(program, keepFinalState);
+
+    std::vector<bool> removed(program.code.size(), false);
+    size_t count = 0;
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        const ControlFlowGraph::Block& block = graph.blocks[b];
+        std::vector<bool> state = block.successors.empty() ? atExit : std::vector<bool>(variableCount, false);
+        for (size_t successor : block.successors) {
+            for (size_t v = 0; v < variableCount; ++v) {
+                if (live[successor][v]) state[v] = true;
+            }
+        }
+
+        for (size_t i = block.end; i-- > block.begin;) {
+            Instruction& ins = program.code[i];
+            bool dead = definesVariable(ins.op) && ins.op != OpCode::READ && !state[ins.a];
+            transfer(ins, state);
+            if (!dead) continue;
+
+            // Стек не меняется - команда просто удаляется
+            if (ins.op == OpCode::DECLARE || ins.op == OpCode::TEE) {
+                removed[i] = true;
+                count++;
+                continue;
+            }
+
+            // Простое значение снимается вместе с присваиванием,
+            // вычисленное - заменяется на pop
+            if (i > block.begin && isPush(program.code[i - 1].op)) {
+                removed[i] = removed[i - 1] = true;
+                count += 2;
+                i--;
+            } else {
+                ins = Instruction();
+                ins.op = OpCode::POP;
+                program.text[i] = "pop";
+            }
+        }
+    }
+
+    if (count > 0) compact(program, removed);
+    return count;
+}
@@ -0,0 +1,33 @@
+#ifndef OPS_DEADCODE_H
+#define OPS_DEADCODE_H
+
+#include <vector>
+#include "ops_cfg.h"
+
+// Удаление мёртвого кода по графу потока управления:
+//   - недостижимые блоки (код после mN j, на который не ведёт ни одна метка);
+//   - мёртвые присваивания x := / declare_assign / declare, значение которых
+//     не читается ни на одном пути (анализ живых переменных).
+// Вычисление мёртвого значения остаётся в виде pop - его снимает оконная
+// оптимизация, а ошибки (деление на ноль, выход за границы) не теряются.
+// Работает по нескомпонованной программе
+class OPSDeadCode {
+public:
+    // keepFinalState - значения переменных в конце программы считаются живыми
+    // (их показывает итоговое состояние интерпретатора)
+    explicit OPSDeadCode(bool keepFinalState = true);
+
+    // Возвращает число удалённых команд
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    bool keepFinalState;
+
+    size_t removeUnreachable(OPSProgram& program) const;
+    size_t removeDeadStores(OPSProgram& program) const;
+
+    // Живые переменные на входе в каждый блок
+    std::vector<std::vector<bool>> liveIn(const OPSProgram& program, const ControlFlowGraph& graph) const;
+};
+
+#endif // OPS_DEADCODE_H
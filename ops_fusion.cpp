@@ -0,0 +1,138 @@
+#include "ops_fusion.h"
+
+namespace {
+
+bool isIncrement(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::ADD_I32 || op == OpCode::ADD_F64 ||
+           op == OpCode::SUB || op == OpCode::SUB_I32 || op == OpCode::SUB_F64;
+}
+
+bool isCompare(OpCode op) {
+    return op == OpCode::GT || op == OpCode::LT || op == OpCode::EQ ||
+           op == OpCode::GT_I32 || op == OpCode::LT_I32 || op == OpCode::EQ_I32 ||
+           op == OpCode::GT_F64 || op == OpCode::LT_F64 || op == OpCode::EQ_F64;
+}
+
+} // namespace
+
+size_t OPSFusion::fuse(OPSProgram& program) const {
+    const size_t count = program.code.size();
+
+    // Адреса, на которые есть переходы: внутрь суперкоманды попасть нельзя
+    std::vector<bool> isTarget(count + 1, false);
+    for (const Instruction& ins : program.code) {
+        if (ins.op == OpCode::JUMP || isConditionalJump(ins.op)) {
+            isTarget[static_cast<size_t>(ins.a)] = true;
+        }
+    }
+
+    std::vector<Instruction> code;
+    std::vector<std::string> text;
+    std::vector<size_t> newIndex(count + 1, 0);
+    code.reserve(count);
+    text.reserve(count);
+    size_t created = 0;
+
+    size_t pc = 0;
+    while (pc < count) {
+        Instruction fused;
+        size_t length = match(program, pc, fused);
+        for (size_t i = 1; i < length; ++i) {
+            if (isTarget[pc + i]) {
+                length = 0;
+                break;
+            }
+        }
+
+        newIndex[pc] = code.size();
+        if (length == 0) {
+            code.push_back(program.code[pc]);
+            text.push_back(program.text[pc]);
+            pc++;
+            continue;
+        }
+
+        std::string joined = program.text[pc];
+        for (size_t i = 1; i < length; ++i) {
+            newIndex[pc + i] = code.size();
+            joined += " " + program.text[pc + i];
+        }
+        code.push_back(fused);
+        text.push_back(joined);
+        created++;
+        pc += length;
+    }
+    newIndex[count] = code.size();
+
+    if (created == 0) return 0;
+
+    // Адреса переходов и меток пересчитываются под сжатый поток команд
+    for (Instruction& ins : code) {
+        if (ins.op == OpCode::JUMP || isConditionalJump(ins.op)) {
+            ins.a = static_cast<int>(newIndex[static_cast<size_t>(ins.a)]);
+        }
+    }
+    for (size_t& target : program.labelTargets) {
+        target = newIndex[target];
+    }
+
+    program.code = std::move(code);
+    program.text = std::move(text);
+    return created;
+}
+
+size_t OPSFusion::match(const OPSProgram& program, size_t pc, Instruction& fused) const {
+    const std::vector<Instruction>& code = program.code;
+    const size_t left = code.size() - pc;
+    if (left < 2 || code[pc].op != OpCode::PUSH_VAR) return 0;
+
+    const Instruction& first = code[pc];
+    const Instruction& second = code[pc + 1];
+
+    // i arr array_get / i arr array_get $t tee (с проверкой границ или без)
+    if (second.op == OpCode::ARRAY_GET || second.op == OpCode::ARRAY_GET_UNCHECKED) {
+        bool checked = second.op == OpCode::ARRAY_GET;
+        fused.op = checked ? OpCode::LOAD_ELEM_VAR_INDEX : OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED;
+        fused.a = second.a;
+        fused.b = first.a;
+        if (left >= 3 && code[pc + 2].op == OpCode::TEE) {
+            fused.op = checked ? OpCode::LOAD_ELEM_VAR_INDEX_TEE : OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED;
+            fused.c = code[pc + 2].a;
+            return 3;
+        }
+        return 2;
+    }
+
+    if (left < 4) return 0;
+    const Instruction& third = code[pc + 2];
+    const Instruction& fourth = code[pc + 3];
+
+    // x c + x :=
+    if (second.op == OpCode::PUSH_CONST && isIncrement(third.op) &&
+        fourth.op == OpCode::STORE && fourth.a == first.a) {
+        fused.op = OpCode::INC_VAR;
+        fused.a = first.a;
+        fused.imm = second.imm;
+        fused.fused = third.op;
+        return 4;
+    }
+
+    // x y < mN jf  /  x c < mN jf
+    if (isCompare(third.op) && fourth.op == OpCode::JUMP_FALSE) {
+        if (second.op == OpCode::PUSH_VAR) {
+            fused.op = OpCode::CMP_VAR_VAR_JF;
+            fused.c = second.a;
+        } else if (second.op == OpCode::PUSH_CONST) {
+            fused.op = OpCode::CMP_VAR_CONST_JF;
+            fused.imm = second.imm;
+        } else {
+            return 0;
+        }
+        fused.a = fourth.a;
+        fused.b = first.a;
+        fused.fused = third.op;
+        return 4;
+    }
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef OPS_FUSION_H
+#define OPS_FUSION_H
+
+#include "ops_program.h"
+
+// Слияние типичных последовательностей ОПС в суперкоманды:
+//   x c + x :=      → INC_VAR
+//   x y < mN jf     → CMP_VAR_VAR_JF
+//   x c < mN jf     → CMP_VAR_CONST_JF
+//   i arr array_get → LOAD_ELEM_VAR_INDEX
+//   i arr array_get $t tee → LOAD_ELEM_VAR_INDEX_TEE
+// Работает по скомпонованной программе (после вывода типов, чтобы сохранить
+// специализацию) и не сливает последовательности, в середину которых есть переход
+class OPSFusion {
+public:
+    // Возвращает число созданных суперкоманд
+    size_t fuse(OPSProgram& program) const;
+
+private:
+    // Длина последовательности, сливаемой с позиции pc (0 - слияние невозможно)
+    size_t match(const OPSProgram& program, size_t pc, Instruction& fused) const;
+};
+
+#endif // OPS_FUSION_H
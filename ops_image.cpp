@@ -0,0 +1,509 @@
+#include "ops_image.h"
+#include "ops_typing.h"
+#include "ops_fusion.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OPS_IMAGE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[4] = {'O', 'P', 'S', 'B'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint64_t ALIGNMENT = 8;
+
+// Раздел образа: смещение от начала файла и число записей
+struct ImageSection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct ImageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t maxStackDepth;
+    uint64_t loopCounters;
+    ImageSection code;
+    ImageSection constants;
+    ImageSection variables;
+    ImageSection arrays;
+    ImageSection labels;
+    ImageSection labelTargets;
+    ImageSection text;
+    ImageSection strings;
+};
+
+// Строка: байты в разделе strings
+struct ImageString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct ImageInstruction {
+    uint16_t op;
+    uint8_t type;
+    uint8_t fused;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+    uint32_t constant;  // номер в пуле непосредственных значений
+};
+
+struct ImageConstant {
+    uint32_t tag;       // 0 - int, 1 - double
+    int32_t intValue;
+    double doubleValue;
+};
+
+struct ImageArray {
+    ImageString name;
+    uint8_t dimensions;  // 0 - память не выделяется, 1 или 2
+    uint8_t elementType;
+    uint16_t reserved;
+    int32_t rows;
+    int32_t cols;
+};
+
+static_assert(std::is_trivially_copyable<ImageHeader>::value, "заголовок образа копируется побайтно");
+static_assert(sizeof(ImageInstruction) == 20, "запись команды образа - 20 байт");
+static_assert(sizeof(ImageConstant) == 16, "запись константы образа - 16 байт");
+static_assert(sizeof(ImageArray) == 20, "дескриптор массива образа - 20 байт");
+
+const OpCode LAST_OPCODE = OpCode::GUARD_COL;
+const DataType LAST_TYPE = DataType::CHAR;
+
+void imageError(const std::string& path, const std::string& message) {
+    throw std::runtime_error("Образ " + path + ": " + message);
+}
+
+// Сборка образа в памяти: разделы дописываются подряд с выравниванием
+class ImageBuilder {
+public:
+    ImageBuilder() : bytes(sizeof(ImageHeader), 0) {}
+
+    template <class T>
+    ImageSection append(const std::vector<T>& records) {
+        bytes.resize((bytes.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, 0);
+        ImageSection section{bytes.size(), records.size()};
+        if (!records.empty()) {
+            const char* data = reinterpret_cast<const char*>(records.data());
+            bytes.insert(bytes.end(), data, data + records.size() * sizeof(T));
+        }
+        return section;
+    }
+
+    ImageString addString(const std::string& value) {
+        ImageString result{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings.insert(strings.end(), value.begin(), value.end());
+        return result;
+    }
+
+    std::vector<ImageString> addStrings(const std::vector<std::string>& values) {
+        std::vector<ImageString> result;
+        result.reserve(values.size());
+        for (const std::string& value : values) {
+            result.push_back(addString(value));
+        }
+        return result;
+    }
+
+    std::vector<char> strings;
+    std::vector<char> bytes;
+};
+
+// Файл образа в памяти: отображение одним mmap (копия в буфер там, где mmap нет)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef OPS_IMAGE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) imageError(path, "не удалось открыть файл");
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            imageError(path, "не удалось определить размер файла");
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* memory = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (memory == MAP_FAILED) {
+                ::close(fd);
+                imageError(path, "не удалось отобразить файл в память");
+            }
+            bytes = static_cast<const unsigned char*>(memory);
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file) imageError(path, "не удалось открыть файл");
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        length = buffer.size();
+        bytes = reinterpret_cast<const unsigned char*>(buffer.data());
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef OPS_IMAGE_MMAP
+        if (bytes) ::munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifndef OPS_IMAGE_MMAP
+    std::vector<char> buffer;
+#endif
+};
+
+// Чтение разделов отображённого образа с проверкой границ
+class ImageReader {
+public:
+    ImageReader(const MappedFile& file, const std::string& path) : file(file), path(path) {}
+
+    template <class T>
+    const T* section(const ImageSection& section, const char* name) const {
+        if (section.count == 0) return nullptr;
+        if (section.offset % alignof(T) != 0 || section.offset > file.size() ||
+            section.count > (file.size() - section.offset) / sizeof(T)) {
+            imageError(path, std::string("раздел ") + name + " выходит за конец файла");
+        }
+        return reinterpret_cast<const T*>(file.data() + section.offset);
+    }
+
+    void setStrings(const ImageSection& section) {
+        strings = this->section<char>(section, "strings");
+        stringBytes = section.count;
+    }
+
+    std::string string(const ImageString& value) const {
+        if (value.offset > stringBytes || value.length > stringBytes - value.offset) {
+            imageError(path, "строка выходит за раздел strings");
+        }
+        if (value.length == 0) return std::string();
+        return std::string(strings + value.offset, value.length);
+    }
+
+    std::vector<std::string> stringTable(const ImageSection& section, const char* name) const {
+        const ImageString* records = this->section<ImageString>(section, name);
+        std::vector<std::string> result;
+        result.reserve(section.count);
+        for (uint64_t i = 0; i < section.count; ++i) {
+            result.push_back(string(records[i]));
+        }
+        return result;
+    }
+
+private:
+    const MappedFile& file;
+    const std::string& path;
+    const char* strings = nullptr;
+    uint64_t stringBytes = 0;
+};
+
+// Дескрипторы массивов (без имён) - по первому выделению памяти каждого массива
+std::vector<ImageArray> arrayDescriptors(const OPSProgram& program) {
+    std::vector<ImageArray> arrays(program.arrays.size(), ImageArray{});
+    for (const Instruction& ins : program.code) {
+        if (ins.op != OpCode::ALLOC_ARRAY && ins.op != OpCode::ALLOC_ARRAY_2D) continue;
+        ImageArray& array = arrays[ins.a];
+        if (array.dimensions != 0) continue;
+        array.dimensions = ins.op == OpCode::ALLOC_ARRAY ? 1 : 2;
+        array.elementType = static_cast<uint8_t>(ins.type);
+        array.rows = ins.b;
+        array.cols = ins.op == OpCode::ALLOC_ARRAY ? 1 : ins.c;
+    }
+    return arrays;
+}
+
+// Обращение без проверки границ безопасно только под охраной guard_*, которую
+// доказал OPSBoundsChecks; загрузчик этого доказательства не повторяет и
+// возвращает обращению проверку (охрана остаётся выбором между копиями цикла)
+OpCode checkedForm(OpCode op) {
+    switch (op) {
+        case OpCode::ARRAY_GET_UNCHECKED:               return OpCode::ARRAY_GET;
+        case OpCode::ARRAY_SET_UNCHECKED:               return OpCode::ARRAY_SET;
+        case OpCode::ARRAY_GET_2D_UNCHECKED:            return OpCode::ARRAY_GET_2D;
+        case OpCode::ARRAY_SET_2D_UNCHECKED:            return OpCode::ARRAY_SET_2D;
+        case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:     return OpCode::LOAD_ELEM_VAR_INDEX;
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED: return OpCode::LOAD_ELEM_VAR_INDEX_TEE;
+        default:                                        return op;
+    }
+}
+
+// Поля команды, которые интерпретатор использует как индексы без проверки
+void checkOperands(const Instruction& ins, size_t pc, const OPSProgram& program, const std::string& path) {
+    const int variables = static_cast<int>(program.variables.size());
+    const int arrays = static_cast<int>(program.arrays.size());
+    const int counters = static_cast<int>(program.loopCounters);
+    const int count = static_cast<int>(program.code.size());
+    auto check = [&](int value, int limit, const char* what) {
+        if (value < 0 || value >= limit) {
+            imageError(path, std::string("неверный ") + what + " в команде " + std::to_string(pc));
+        }
+    };
+
+    switch (ins.op) {
+        case OpCode::LABEL:
+            imageError(path, "метка в скомпонованной программе (команда " + std::to_string(pc) + ")");
+            break;
+        case OpCode::PUSH_VAR:
+        case OpCode::STORE:
+        case OpCode::TEE:
+        case OpCode::DECLARE:
+        case OpCode::DECLARE_ASSIGN:
+        case OpCode::READ:
+        case OpCode::INC_VAR:
+            check(ins.a, variables, "номер переменной");
+            break;
+        case OpCode::ALLOC_ARRAY:
+        case OpCode::ALLOC_ARRAY_2D:
+            check(ins.a, arrays, "номер массива");
+            if (ins.b < 0 || ins.c < 0) {
+                imageError(path, "неверный размер массива в команде " + std::to_string(pc));
+            }
+            break;
+        case OpCode::ARRAY_GET:
+        case OpCode::ARRAY_SET:
+        case OpCode::ARRAY_READ:
+        case OpCode::ARRAY_GET_2D:
+        case OpCode::ARRAY_SET_2D:
+        case OpCode::ARRAY_READ_2D:
+        case OpCode::ARRAY_GET_UNCHECKED:
+        case OpCode::ARRAY_SET_UNCHECKED:
+        case OpCode::ARRAY_GET_2D_UNCHECKED:
+        case OpCode::ARRAY_SET_2D_UNCHECKED:
+            check(ins.a, arrays, "номер массива");
+            break;
+        case OpCode::LOAD_ELEM_VAR_INDEX:
+        case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            check(ins.a, arrays, "номер массива");
+            check(ins.b, variables, "номер переменной");
+            break;
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+            check(ins.a, arrays, "номер массива");
+            check(ins.b, variables, "номер переменной");
+            check(ins.c, variables, "номер переменной");
+            break;
+        case OpCode::CMP_VAR_VAR_JF:
+            check(ins.c, variables, "номер переменной");
+            check(ins.b, variables, "номер переменной");
+            break;
+        case OpCode::CMP_VAR_CONST_JF:
+            check(ins.b, variables, "номер переменной");
+            break;
+        case OpCode::LOOP_INIT:
+        case OpCode::LOOP_NEXT:
+            check(ins.b, variables, "номер переменной");
+            check(ins.c, counters, "номер счётчика цикла");
+            break;
+        case OpCode::GUARD_INDEX:
+        case OpCode::GUARD_ROW:
+        case OpCode::GUARD_COL:
+            check(ins.b, arrays, "номер массива");
+            check(ins.c, counters, "номер счётчика цикла");
+            break;
+        default:
+            break;
+    }
+    // Переход на конец программы - завершение
+    if (ins.op == OpCode::JUMP || isConditionalJump(ins.op)) {
+        check(ins.a, count + 1, "адрес перехода");
+    }
+}
+
+} // namespace
+
+void OPSImageWriter::write(const OPSProgram& source, const std::string& path) const {
+    // Та же подготовка, что перед выполнением интерпретатором; кадр - нулевой,
+    // как у программы, запущенной без setVariable
+    OPSProgram program = source;
+    OPSLinker linker;
+    linker.link(program);
+    std::vector<Value> frame(program.variables.size(), Value());
+    OPSTypeInference typing;
+    typing.specialize(program, frame);
+    OPSFusion fusion;
+    fusion.fuse(program);
+
+    ImageBuilder builder;
+
+    // Пул непосредственных значений: одинаковые значения - одна запись
+    std::vector<ImageConstant> constants;
+    std::map<std::pair<uint32_t, uint64_t>, uint32_t> constantIndex;
+    auto constant = [&](const Value& value) {
+        ImageConstant record{};
+        uint64_t bits = 0;
+        if (value.isInt()) {
+            record.tag = 0;
+            record.intValue = value.asInt();
+            bits = static_cast<uint32_t>(record.intValue);
+        } else {
+            record.tag = 1;
+            record.doubleValue = value.asDouble();
+            std::memcpy(&bits, &record.doubleValue, sizeof bits);
+        }
+        auto found = constantIndex.emplace(std::make_pair(record.tag, bits), static_cast<uint32_t>(constants.size()));
+        if (found.second) constants.push_back(record);
+        return found.first->second;
+    };
+
+    std::vector<ImageInstruction> code;
+    code.reserve(program.code.size());
+    for (const Instruction& ins : program.code) {
+        ImageInstruction record{};
+        record.op = static_cast<uint16_t>(ins.op);
+        record.type = static_cast<uint8_t>(ins.type);
+        record.fused = static_cast<uint8_t>(ins.fused);
+        record.a = ins.a;
+        record.b = ins.b;
+        record.c = ins.c;
+        record.constant = constant(ins.imm);
+        code.push_back(record);
+    }
+
+    std::vector<ImageArray> arrays = arrayDescriptors(program);
+    for (size_t i = 0; i < program.arrays.size(); ++i) {
+        arrays[i].name = builder.addString(program.arrays[i]);
+    }
+
+    std::vector<ImageString> variables = builder.addStrings(program.variables);
+    std::vector<ImageString> labels = builder.addStrings(program.labels);
+    std::vector<ImageString> text = builder.addStrings(program.text);
+    std::vector<uint32_t> labelTargets(program.labelTargets.begin(), program.labelTargets.end());
+
+    ImageHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof MAGIC);
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.maxStackDepth = program.maxStackDepth;
+    header.loopCounters = program.loopCounters;
+    header.code = builder.append(code);
+    header.constants = builder.append(constants);
+    header.variables = builder.append(variables);
+    header.arrays = builder.append(arrays);
+    header.labels = builder.append(labels);
+    header.labelTargets = builder.append(labelTargets);
+    header.text = builder.append(text);
+    header.strings = builder.append(builder.strings);
+    header.fileSize = builder.bytes.size();
+    std::memcpy(builder.bytes.data(), &header, sizeof header);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(builder.bytes.data(), static_cast<std::streamsize>(builder.bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Не удалось записать файл: " + path);
+    }
+}
+
+OPSProgram OPSImageLoader::load(const std::string& path) const {
+    MappedFile file(path);
+    if (file.size() < sizeof(ImageHeader)) {
+        imageError(path, "файл не является образом программы ОПС");
+    }
+    ImageHeader header;
+    std::memcpy(&header, file.data(), sizeof header);
+    if (std::memcmp(header.magic, MAGIC, sizeof MAGIC) != 0) {
+        imageError(path, "файл не является образом программы ОПС");
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK) {
+        imageError(path, "образ записан машиной с другим порядком байтов");
+    }
+    if (header.version != OPSImageWriter::VERSION) {
+        imageError(path, "версия образа " + std::to_string(header.version) + ", поддерживается " +
+                         std::to_string(OPSImageWriter::VERSION));
+    }
+    if (header.fileSize != file.size()) {
+        imageError(path, "размер файла не совпадает с заголовком");
+    }
+    // Глубина стека не больше числа команд + 1 (граница компоновщика), у
+    // каждого счётчика цикла своя команда loop_init
+    if (header.maxStackDepth > header.code.count + 1 || header.loopCounters > header.code.count) {
+        imageError(path, "повреждён заголовок");
+    }
+
+    ImageReader reader(file, path);
+    reader.setStrings(header.strings);
+
+    OPSProgram program;
+    program.variables = reader.stringTable(header.variables, "variables");
+    program.labels = reader.stringTable(header.labels, "labels");
+    program.text = reader.stringTable(header.text, "text");
+    const ImageArray* arrays = reader.section<ImageArray>(header.arrays, "arrays");
+    program.arrays.reserve(header.arrays.count);
+    for (uint64_t i = 0; i < header.arrays.count; ++i) {
+        program.arrays.push_back(reader.string(arrays[i].name));
+    }
+    const uint32_t* labelTargets = reader.section<uint32_t>(header.labelTargets, "labelTargets");
+    program.labelTargets.assign(labelTargets, labelTargets + header.labelTargets.count);
+    program.maxStackDepth = static_cast<size_t>(header.maxStackDepth);
+    program.loopCounters = static_cast<size_t>(header.loopCounters);
+    program.linked = true;
+    program.prepared = true;
+
+    const ImageConstant* constants = reader.section<ImageConstant>(header.constants, "constants");
+    const ImageInstruction* code = reader.section<ImageInstruction>(header.code, "code");
+    if (header.text.count != header.code.count) {
+        imageError(path, "число записей команд и их текстов различается");
+    }
+    program.code.resize(header.code.count);
+    for (size_t pc = 0; pc < program.code.size(); ++pc) {
+        const ImageInstruction& record = code[pc];
+        if (record.op > static_cast<uint16_t>(LAST_OPCODE) || record.fused > static_cast<uint8_t>(LAST_OPCODE) ||
+            record.type > static_cast<uint8_t>(LAST_TYPE) || record.constant >= header.constants.count) {
+            imageError(path, "повреждена команда " + std::to_string(pc));
+        }
+        const ImageConstant& value = constants[record.constant];
+        Instruction& ins = program.code[pc];
+        ins.op = checkedForm(static_cast<OpCode>(record.op));
+        ins.type = static_cast<DataType>(record.type);
+        ins.fused = static_cast<OpCode>(record.fused);
+        ins.a = record.a;
+        ins.b = record.b;
+        ins.c = record.c;
+        ins.imm = value.tag == 0 ? Value(value.intValue) : Value(value.doubleValue);
+    }
+    for (size_t pc = 0; pc < program.code.size(); ++pc) {
+        checkOperands(program.code[pc], pc, program, path);
+    }
+
+    // Дескрипторы массивов должны совпадать с выделениями памяти в командах
+    std::vector<ImageArray> expected = arrayDescriptors(program);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const ImageArray& stored = arrays[i];
+        if (stored.dimensions != expected[i].dimensions || stored.elementType != expected[i].elementType ||
+            stored.rows != expected[i].rows || stored.cols != expected[i].cols) {
+            imageError(path, "дескриптор массива " + program.arrays[i] + " не совпадает с выделением памяти");
+        }
+    }
+
+    // Стек операндов выделяется по глубине из заголовка: она должна покрывать
+    // глубину, доказанную по графу переходов самой программы
+    OPSLinker linker;
+    if (linker.computeMaxStackDepth(program) > program.maxStackDepth) {
+        imageError(path, "глубина стека в заголовке меньше необходимой");
+    }
+    return program;
+}
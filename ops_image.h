@@ -0,0 +1,48 @@
+#ifndef OPS_IMAGE_H
+#define OPS_IMAGE_H
+
+#include <cstdint>
+#include <string>
+#include "ops_program.h"
+
+// Образ скомпилированной программы ОПС (.opsb): программа после оптимизатора,
+// компоновки, специализации по типам и слияния в плоском двоичном виде.
+// Загрузка не повторяет ни лексического и синтаксического анализа, ни
+// оптимизатора, ни подготовки перед выполнением: файл отображается в память
+// одним mmap, таблицы фиксированного размера копируются в программу как есть.
+//
+// Формат (версия 1, порядок байтов - машины, записавшей образ):
+//   заголовок     - "OPSB", версия, метка порядка байтов, размер файла,
+//                   глубина стека, число счётчиков циклов, таблица разделов
+//   code          - команды: код операции, тип, a, b, c (адреса переходов
+//                   разрешены), номер константы, операция суперкоманды
+//   constants     - пул непосредственных значений (тег, int, double)
+//   variables     - таблица переменных (строки)
+//   arrays        - дескрипторы массивов: имя, размерность, тип элементов и
+//                   размеры из первого выделения памяти
+//   labels        - таблица меток (строки) и labelTargets - их адреса
+//   text          - исходная запись каждой команды (для трассировки)
+//   strings       - байты всех строк; строка - смещение и длина
+// Разделы выровнены на 8 байт. Индексы переменных, массивов, счётчиков и
+// адреса переходов проверяются при загрузке, глубина стека пересчитывается,
+// дескрипторы массивов сверяются с командами выделения памяти. Обращения к
+// массивам без проверки границ загружаются с проверкой: доказательство,
+// что охрана guard_* покрывает их, в образе не хранится
+class OPSImageWriter {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    // Записать образ программы (после оптимизатора, до компоновки) в файл path;
+    // ошибка записи - std::runtime_error
+    void write(const OPSProgram& program, const std::string& path) const;
+};
+
+class OPSImageLoader {
+public:
+    // Программа из образа: скомпонована и подготовлена к выполнению (prepared).
+    // Файл не образ, другая версия или порядок байтов, повреждённые таблицы -
+    // std::runtime_error
+    OPSProgram load(const std::string& path) const;
+};
+
+#endif // OPS_IMAGE_H
@@ -0,0 +1,170 @@
+#include "ops_input.h"
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t BLOCK_SIZE = 1 << 20;  // размер блока чтения потока
+const size_t BATCH_SIZE = 4096;     // сколько чисел разбирается за один проход
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+} // namespace
+
+BulkInputReader::BulkInputReader()
+    : cursor(nullptr), end(nullptr), mapped(nullptr), mappedSize(0),
+      stream(nullptr), ownsStream(false), eof(true), aheadPos(0) {}
+
+BulkInputReader::~BulkInputReader() {
+    close();
+}
+
+void BulkInputReader::open(const std::string& path) {
+    close();
+
+    if (path != "-" && mapFile(path)) {
+        return;
+    }
+
+    // Не удалось отобразить (stdin, канал, пустой файл) - читаем блоками
+    if (path == "-") {
+        stream = stdin;
+        ownsStream = false;
+    } else {
+        stream = std::fopen(path.c_str(), "rb");
+        if (stream == nullptr) {
+            throw std::runtime_error("Не удалось открыть файл входных данных: " + path);
+        }
+        ownsStream = true;
+    }
+    block.resize(BLOCK_SIZE);
+    cursor = end = block.data();
+    eof = false;
+}
+
+bool BulkInputReader::next(double& value) {
+    if (aheadPos == ahead.size()) {
+        refill();
+        if (ahead.empty()) {
+            return false;
+        }
+    }
+    value = ahead[aheadPos++];
+    return true;
+}
+
+void BulkInputReader::close() {
+#ifndef _WIN32
+    if (mapped != nullptr) {
+        munmap(mapped, mappedSize);
+    }
+#endif
+    if (stream != nullptr && ownsStream) {
+        std::fclose(stream);
+    }
+    mapped = nullptr;
+    mappedSize = 0;
+    stream = nullptr;
+    ownsStream = false;
+    eof = true;
+    cursor = end = nullptr;
+    ahead.clear();
+    aheadPos = 0;
+}
+
+bool BulkInputReader::mapFile(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Не удалось открыть файл входных данных: " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* region = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) {
+        return false;
+    }
+    madvise(region, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    mapped = region;
+    mappedSize = static_cast<size_t>(info.st_size);
+    cursor = static_cast<const char*>(region);
+    end = cursor + mappedSize;
+    eof = true;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool BulkInputReader::readBlock() {
+    if (stream == nullptr || eof) {
+        return false;
+    }
+
+    // Недоразобранный хвост переносится в начало буфера
+    size_t offset = static_cast<size_t>(cursor - block.data());
+    size_t tail = static_cast<size_t>(end - cursor);
+    if (tail == block.size()) {
+        block.resize(block.size() * 2);   // слишком длинная лексема
+    }
+    std::memmove(block.data(), block.data() + offset, tail);
+
+    size_t count = std::fread(block.data() + tail, 1, block.size() - tail, stream);
+    if (count == 0) {
+        eof = true;
+    }
+    cursor = block.data();
+    end = cursor + tail + count;
+    return count > 0;
+}
+
+void BulkInputReader::refill() {
+    ahead.clear();
+    aheadPos = 0;
+
+    while (ahead.size() < BATCH_SIZE) {
+        while (cursor != end && isSpace(*cursor)) {
+            ++cursor;
+        }
+
+        // Лексема должна целиком лежать в буфере: у края дочитываем следующий блок
+        const char* tokenEnd = cursor;
+        while (tokenEnd != end && !isSpace(*tokenEnd)) {
+            ++tokenEnd;
+        }
+        if (tokenEnd == end && !eof) {
+            if (readBlock() || cursor != end) {
+                continue;
+            }
+        }
+        if (cursor == end) {
+            break;
+        }
+
+        double value = 0.0;
+        const char* start = (*cursor == '+') ? cursor + 1 : cursor;
+        std::from_chars_result result = std::from_chars(start, tokenEnd, value);
+        if (result.ec != std::errc() || result.ptr != tokenEnd) {
+            throw std::runtime_error("Неверное число во входных данных: " + std::string(cursor, tokenEnd));
+        }
+        ahead.push_back(value);
+        cursor = tokenEnd;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef OPS_INPUT_H
+#define OPS_INPUT_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Источник входных данных для команд r / array_read / array_read_2d
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // Следующее число; false, если данные закончились
+    virtual bool next(double& value) = 0;
+};
+
+// Неинтерактивный источник: файл отображается в память целиком (mmap),
+// поток (stdin) читается большими блоками; числа разбираются std::from_chars
+// пакетами заранее, до того как их запросит интерпретатор
+class BulkInputReader : public InputSource {
+public:
+    BulkInputReader();
+    ~BulkInputReader() override;
+
+    BulkInputReader(const BulkInputReader&) = delete;
+    BulkInputReader& operator=(const BulkInputReader&) = delete;
+
+    // Открыть файл с данными ("-" - стандартный ввод)
+    void open(const std::string& path);
+
+    bool next(double& value) override;
+
+private:
+    const char* cursor;          // текущая позиция разбора
+    const char* end;             // конец доступных данных
+    void* mapped;                // отображённый файл (nullptr, если читаем блоками)
+    size_t mappedSize;
+    std::FILE* stream;           // поток для блочного чтения
+    bool ownsStream;
+    bool eof;                    // поток дочитан до конца
+    std::vector<char> block;     // буфер блочного чтения
+    std::vector<double> ahead;   // разобранные заранее числа
+    size_t aheadPos;
+
+    void close();
+    bool mapFile(const std::string& path);
+    bool readBlock();            // дочитать блок, сохранив недоразобранный хвост
+    void refill();               // разобрать следующий пакет чисел
+};
+
+#endif // OPS_INPUT_H
@@ -1,10 +1,132 @@
 #include "ops_interpreter.h"
+#include "ops_typing.h"
+#include "ops_fusion.h"
+#include "ops_profile.h"
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <cctype>
+#include <cmath>
+#include <algorithm>
 
-OPSInterpreter::OPSInterpreter() : programCounter(0), running(false) {}
+namespace {
+
+// Политики трассировки основного цикла (profile - считать выполнения команд)
+struct TraceOn {
+    static constexpr bool enabled = true;
+    static constexpr bool profile = true;
+};
+
+struct TraceOff {
+    static constexpr bool enabled = false;
+    static constexpr bool profile = false;
+};
+
+struct ProfileOn {
+    static constexpr bool enabled = false;
+    static constexpr bool profile = true;
+};
+
+// Обратных переходов до перевода цикла в машинный код: короткие циклы
+// не платят за компиляцию
+const uint64_t DEFAULT_TIER_THRESHOLD = 1000;
+
+// Вывод трассировки: при выключенной политике вызов исчезает на этапе компиляции
+template <class Trace, class... Args>
+inline void trace(const Args&... args) {
+    if constexpr (Trace::enabled) {
+        (std::cout << ... << args);
+    }
+}
+
+// Число итераций цикла for (i = start; i < bound; i += step) (или i > bound при
+// отрицательном шаге). Вещественная граница сводится к целой: для целого i
+// условие i < 2.5 равносильно i < 3, условие i > 2.5 - условию i > 2
+inline long long tripCount(int start, const Value& bound, int step, OpCode compare) {
+    long long limit;
+    if (bound.isInt()) {
+        limit = bound.asInt();
+    } else {
+        double value = bound.asDouble();
+        if (value != value) return 0;  // сравнение с NaN всегда ложно
+        value = compare == OpCode::LT ? std::ceil(value) : std::floor(value);
+        value = std::max(value, -9.0e15);
+        value = std::min(value, 9.0e15);
+        limit = static_cast<long long>(value);
+    }
+
+    long long distance = compare == OpCode::LT ? limit - start : start - limit;
+    long long stride = step < 0 ? -static_cast<long long>(step) : step;
+    if (distance <= 0) return 0;
+    return (distance + stride - 1) / stride;
+}
+
+// Сравнение внутри слитой команды; специализированные варианты читают поле без проверки тега
+inline bool compareValues(OpCode op, const Value& a, const Value& b) {
+    switch (op) {
+        case OpCode::GT_I32: return a.rawInt() > b.rawInt();
+        case OpCode::LT_I32: return a.rawInt() < b.rawInt();
+        case OpCode::EQ_I32: return a.rawInt() == b.rawInt();
+        case OpCode::GT_F64: return a.rawDouble() > b.rawDouble();
+        case OpCode::LT_F64: return a.rawDouble() < b.rawDouble();
+        case OpCode::EQ_F64: return a.rawDouble() == b.rawDouble();
+        default: break;
+    }
+    bool useDouble = a.isDouble() || b.isDouble();
+    if (op == OpCode::GT) {
+        return useDouble ? a.asDouble() > b.asDouble() : a.asInt() > b.asInt();
+    } else if (op == OpCode::LT) {
+        return useDouble ? a.asDouble() < b.asDouble() : a.asInt() < b.asInt();
+    }
+    return useDouble ? a.asDouble() == b.asDouble() : a.asInt() == b.asInt();
+}
+
+} // namespace
+
+OPSInterpreter::OPSInterpreter()
+    : stackTop(nullptr), programCounter(0), running(false), mode(ExecutionMode::TRACE),
+      dispatch(threadedDispatchAvailable() ? DispatchMode::THREADED : DispatchMode::SWITCH), output(&defaultOutput), input(nullptr),
+      jitEnabled(OPSJit::available()), tierThreshold(DEFAULT_TIER_THRESHOLD), statsEnabled(false) {}
+
+void OPSInterpreter::setExecutionMode(ExecutionMode executionMode) {
+    mode = executionMode;
+}
+
+void OPSInterpreter::setDispatchMode(DispatchMode dispatchMode) {
+    dispatch = threadedDispatchAvailable() ? dispatchMode : DispatchMode::SWITCH;
+}
+
+bool OPSInterpreter::threadedDispatchAvailable() {
+#ifdef OPS_THREADED_DISPATCH
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OPSInterpreter::setJitEnabled(bool enabled) {
+    jitEnabled = enabled && OPSJit::available();
+}
+
+bool OPSInterpreter::jitAvailable() {
+    return OPSJit::available();
+}
+
+void OPSInterpreter::setTierThreshold(uint64_t backEdges) {
+    tierThreshold = backEdges;
+}
+
+void OPSInterpreter::setStatsEnabled(bool enabled) {
+    statsEnabled = enabled;
+}
+
+void OPSInterpreter::setOutputSink(OutputSink* sink) {
+    output = sink != nullptr ? sink : &defaultOutput;
+}
+
+void OPSInterpreter::setInputSource(InputSource* source) {
+    input = source;
+}
 
 void OPSInterpreter::execute(const std::vector<std::string>& opsCommands) {
     if (opsCommands.empty()) {
@@ -12,302 +134,735 @@ void OPSInterpreter::execute(const std::vector<std::string>& opsCommands) {
         return;
     }
     
-    commands = opsCommands;
+    // Фаза загрузки: текст ОПС декодируется один раз, до начала выполнения
+    OPSLoader loader;
+    execute(loader.load(opsCommands));
+}
+
+void OPSInterpreter::execute(const OPSProgram& opsProgram) {
+    // Значения, заданные до выполнения (setVariable), переносятся в новый кадр по имени
+    std::vector<std::string> oldNames = program.variables;
+    std::vector<Value> oldFrame = frame;
+    
+    program = opsProgram;
+    frame.assign(program.variables.size(), Value());
+    for (size_t i = 0; i < oldNames.size(); ++i) {
+        frame[slotFor(oldNames[i])] = oldFrame[i];
+    }
+    
+    // Таблицы дескрипторов массивов: номер массива разрешён загрузчиком
+    arrays.assign(program.arrays.size(), ArrayStorage());
+    arrays2D.assign(program.arrays.size(), ArrayStorage());
+    loopCounters.assign(program.loopCounters, 0);
+    loopRanges.assign(program.loopCounters, LoopRange());
+    
     programCounter = 0;
     running = true;
     
-    // Сначала парсим метки
-    parseLabels();
+    // Сначала разрешаем метки в адреса переходов
+    OPSLinker linker;
+    linker.link(program);
+    
+    // Вывод типов: арифметика и сравнения с доказанными типами операндов
+    // заменяются специализированными командами без проверки тега.
+    // Программа из образа .opsb подготовлена при его записи
+    size_t specialized = 0;
+    size_t superinstructions = 0;
+    if (!program.prepared) {
+        OPSTypeInference typing;
+        specialized = typing.specialize(program, frame);
+        
+        // Слияние типичных последовательностей в суперкоманды
+        OPSFusion fusion;
+        superinstructions = fusion.fuse(program);
+    }
+    
+    // Стек операндов выделяется один раз под глубину, найденную компоновщиком
+    operandStack.assign(program.maxStackDepth, Value());
+    stackTop = operandStack.data();
     
-    std::cout << "\n🔄 ВЫПОЛНЕНИЕ ОПС:" << std::endl;
-    std::cout << "Команды: ";
-    for (size_t i = 0; i < commands.size(); ++i) {
-        std::cout << commands[i];
-        if (i < commands.size() - 1) std::cout << " ";
+    // Циклы переводятся в машинный код только без трассировки и только
+    // горячие: по счётчику обратных переходов
+    bool native = jitEnabled && mode != ExecutionMode::TRACE;
+    if (native) {
+        jit.prepare(program, frame);
+    } else {
+        jit.clear();
     }
-    std::cout << "\n" << std::string(50, '-') << std::endl;
+    profile.prepare(program, native);
+    bool profiled = statsEnabled && mode != ExecutionMode::TRACE;
     
-    // Основной цикл выполнения
-    while (running && programCounter < commands.size()) {
-        const std::string& command = commands[programCounter];
-        
-        std::cout << "PC=" << programCounter << ": " << command;
-        
-        // Пропускаем метки при выполнении
-        if (command.back() == ':') {
-            std::cout << " (метка)" << std::endl;
-            programCounter++;
-            continue;
-        }
-        
-        // Обрабатываем команду
-        if (isNumber(command)) {
-            // Целое число - помещаем в стек
-            int value = std::stoi(command);
-            pushStack(Value(value));
-            std::cout << " → стек: " << value;
-        }
-        else if (isDoubleNumber(command)) {
-            // Число с плавающей точкой - помещаем в стек
-            double value = std::stod(command);
-            pushStack(Value(value));
-            std::cout << " → стек: " << value;
-        }
-        else if (command == ":=") {
-            // Присваивание
-            executeAssignment();
-            std::cout << " → присваивание";
-        }
-        else if (command == "r") {
-            // Операция чтения (read/input)
-            executeRead();
-            std::cout << " → чтение";
-        }
-        else if (command == "w") {
-            // Операция записи (write/output)
-            executeWrite();
-            std::cout << " → запись";
-        }
-        else if (command == "alloc_array") {
-            // Выделение памяти для массива
-            executeArrayAlloc();
-            std::cout << " → выделение памяти массива";
-        }
-        else if (command == "array_get") {
-            // Получение элемента массива
-            executeArrayGet();
-            std::cout << " → получение элемента массива";
+    if (mode != ExecutionMode::QUIET) {
+        std::cout << "\n🔄 ВЫПОЛНЕНИЕ ОПС:" << std::endl;
+        std::cout << "Команды: ";
+        for (size_t i = 0; i < program.text.size(); ++i) {
+            std::cout << program.text[i];
+            if (i < program.text.size() - 1) std::cout << " ";
         }
-        else if (command == "array_set") {
-            // Установка элемента массива
-            executeArraySet();
-            std::cout << " → установка элемента массива";
-        }
-        else if (command == "array_read") {
-            // Чтение в элемент массива
-            executeArrayRead();
-            std::cout << " → чтение в элемент массива";
-        }
-        else if (command == "array_read_2d") {
-            // Чтение в элемент двумерного массива
-            executeArrayRead2D();
-            std::cout << " → чтение в элемент 2D массива";
+        if (program.prepared) {
+            std::cout << "\nПрограмма из образа: специализирована и слита при компиляции";
+        } else {
+            std::cout << "\nСпециализировано по типам: " << specialized << " команд, суперкоманд: " << superinstructions;
         }
-        else if (command == "alloc_array_2d") {
-            // Выделение памяти для двумерного массива
-            executeArrayAlloc2D();
-            std::cout << " → выделение памяти 2D массива";
+        std::cout << "\nЯдро: " << (mode == ExecutionMode::TRACE || profiled || dispatch == DispatchMode::SWITCH ? "switch" : "threaded");
+        std::cout << ", JIT: " << (native ? "x86-64" : "выключен");
+        std::cout << "\n" << std::string(50, '-') << std::endl;
+    }
+    
+    // Политика трассировки выбирается один раз: в режимах без трассировки
+    // основной цикл компилируется без единой ветки вывода
+    try {
+        if (mode == ExecutionMode::TRACE) {
+            run<TraceOn>();
+        } else if (profiled) {
+            run<ProfileOn>();
         }
-        else if (command == "array_get_2d") {
-            // Получение элемента двумерного массива
-            executeArrayGet2D();
-            std::cout << " → получение элемента 2D массива";
+#ifdef OPS_THREADED_DISPATCH
+        else if (dispatch == DispatchMode::THREADED) {
+            runThreaded();
         }
-        else if (command == "array_set_2d") {
-            // Установка элемента двумерного массива
-            executeArraySet2D();
-            std::cout << " → установка элемента 2D массива";
+#endif
+        else {
+            run<TraceOff>();
         }
-        else if (command == "declare") {
-            // Объявление переменной
-            executeDeclare();
-            std::cout << " → объявление переменной";
+    }
+    catch (...) {
+        // Вывод, накопленный до ошибки, не должен теряться
+        output->flush();
+        throw;
+    }
+    output->flush();
+    
+    if (mode != ExecutionMode::QUIET) {
+        std::cout << std::string(50, '-') << std::endl;
+        std::cout << "✅ Выполнение завершено!" << std::endl;
+        if (native) {
+            std::cout << "JIT: скомпилировано циклов - " << jit.compiledLoops()
+                      << ", байт машинного кода - " << jit.compiledBytes() << std::endl;
         }
-        else if (command == "declare_assign") {
-            // Объявление переменной с типизированным присваиванием
-            executeDeclareAssign();
-            std::cout << " → объявление с присваиванием";
+        printState();
+    }
+    if (statsEnabled) {
+        profile.print(program, tierThreshold, native, std::cout);
+    }
+}
+
+template <class Trace>
+void OPSInterpreter::run() {
+    // Основной цикл выполнения: выбор обработчика только по коду операции
+    while (running && programCounter < program.code.size()) {
+        const Instruction& ins = program.code[programCounter];
+        
+        trace<Trace>("PC=", programCounter, ": ", program.text[programCounter]);
+        if constexpr (Trace::profile) {
+            profile.countInstruction(programCounter);
         }
-        else if (command == "jf") {
-            // Условный переход - метка должна быть предыдущей командой
-            if (programCounter > 0) {
-                std::string label = commands[programCounter - 1];
+        
+        switch (ins.op) {
+            case OpCode::LABEL:
+                // После компоновки меток в потоке команд нет
+                break;
+            case OpCode::POP: {
+                Value value = popStack();
+                trace<Trace>(" → снято со стека: ", value);
+                break;
+            }
+            case OpCode::TEE:
+                frame[ins.a] = stackTop[-1];
+                trace<Trace>(" (", program.variables[ins.a], " = ", frame[ins.a], ")");
+                break;
+            case OpCode::PUSH_CONST:
+                pushStack(ins.imm);
+                trace<Trace>(" → стек: ", ins.imm);
+                break;
+            case OpCode::PUSH_VAR: {
+                const Value& value = frame[ins.a];
+                pushStack(value);
+                trace<Trace>(" → стек: ", program.variables[ins.a], "=", value);
+                break;
+            }
+            case OpCode::STORE:
+                executeAssignment<Trace>(ins);
+                trace<Trace>(" → присваивание");
+                break;
+            case OpCode::DECLARE:
+                executeDeclare<Trace>(ins);
+                trace<Trace>(" → объявление переменной");
+                break;
+            case OpCode::DECLARE_ASSIGN:
+                executeDeclareAssign<Trace>(ins);
+                trace<Trace>(" → объявление с присваиванием");
+                break;
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV:
+                executeArithmetic(ins.op);
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::GT:
+            case OpCode::LT:
+            case OpCode::EQ:
+                executeComparison(ins.op);
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::ADD_I32:
+                applyInt([](int a, int b) { return a + b; });
+                trace<Trace>(" → результат в стеке (int)");
+                break;
+            case OpCode::SUB_I32:
+                applyInt([](int a, int b) { return a - b; });
+                trace<Trace>(" → результат в стеке (int)");
+                break;
+            case OpCode::MUL_I32:
+                applyInt([](int a, int b) { return a * b; });
+                trace<Trace>(" → результат в стеке (int)");
+                break;
+            case OpCode::DIV_I32:
+                if (stackTop[-1].rawInt() == 0) {
+                    error("Деление на ноль");
+                }
+                applyInt([](int a, int b) { return a / b; });
+                trace<Trace>(" → результат в стеке (int)");
+                break;
+            case OpCode::ADD_F64:
+                applyDouble([](double a, double b) { return a + b; });
+                trace<Trace>(" → результат в стеке (double)");
+                break;
+            case OpCode::SUB_F64:
+                applyDouble([](double a, double b) { return a - b; });
+                trace<Trace>(" → результат в стеке (double)");
+                break;
+            case OpCode::MUL_F64:
+                applyDouble([](double a, double b) { return a * b; });
+                trace<Trace>(" → результат в стеке (double)");
+                break;
+            case OpCode::DIV_F64:
+                if (stackTop[-1].rawDouble() == 0.0) {
+                    error("Деление на ноль");
+                }
+                applyDouble([](double a, double b) { return a / b; });
+                trace<Trace>(" → результат в стеке (double)");
+                break;
+            case OpCode::GT_I32:
+                compareInt([](int a, int b) { return a > b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::LT_I32:
+                compareInt([](int a, int b) { return a < b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::EQ_I32:
+                compareInt([](int a, int b) { return a == b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::GT_F64:
+                compareDouble([](double a, double b) { return a > b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::LT_F64:
+                compareDouble([](double a, double b) { return a < b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::EQ_F64:
+                compareDouble([](double a, double b) { return a == b; });
+                trace<Trace>(" → результат в стеке");
+                break;
+            case OpCode::JUMP: {
+                size_t from = programCounter;
+                executeJump(ins);
+                trace<Trace>(" → безусловный переход к PC=", ins.a, '\n');
+                if (programCounter <= from) {
+                    programCounter = backEdge(programCounter);
+                }
+                continue; // programCounter уже изменен в executeJump
+            }
+            case OpCode::JUMP_FALSE: {
                 size_t oldPC = programCounter;
-                executeConditionalJump(label);
-                std::cout << " → условный переход к " << label;
+                executeConditionalJump<Trace>(ins);
+                trace<Trace>(" → условный переход к PC=", ins.a);
                 
                 // Если programCounter изменился, значит произошел переход
                 if (programCounter != oldPC) {
-                    continue; // Переход выполнен, не увеличиваем programCounter
+                    trace<Trace>('\n');
+                    if (programCounter < oldPC) {
+                        programCounter = backEdge(programCounter);
+                    }
+                    continue;
                 }
-                // Иначе продолжаем обычное выполнение (programCounter будет увеличен)
-            } else {
-                std::cout << " (нет метки)";
-            }
-        }
-        else if (command == "j") {
-            // Безусловный переход - метка должна быть предыдущей командой
-            if (programCounter > 0) {
-                std::string label = commands[programCounter - 1];
-                executeJump(label);
-                std::cout << " → безусловный переход к " << label;
-                continue; // programCounter уже изменен в executeJump
-            } else {
-                std::cout << " (нет метки)";
-            }
-        }
-        else if (isOperator(command)) {
-            // Арифметическая операция или сравнение
-            if (command == "+" || command == "-" || command == "*" || command == "/") {
-                executeArithmetic(command);
+                break;
             }
-            else if (command == ">" || command == "<" || command == "==") {
-                executeComparison(command);
-            }
-            std::cout << " → результат в стеке";
-        }
-        // Проверяем, является ли это аргументом для команды перехода
-        else if (programCounter + 1 < commands.size() && 
-                 (commands[programCounter + 1] == "jf" || commands[programCounter + 1] == "j")) {
-            // Это аргумент для команды перехода, просто пропускаем
-            std::cout << " (аргумент для " << commands[programCounter + 1] << ")";
-        }
-        else if (isVariable(command)) {
-            // Проверяем, следует ли за переменной команда присваивания или ввода/вывода
-            bool isAssignmentTarget = false;
-            bool isTypeKeyword = false;
-            
-            // Проверяем, является ли это ключевым словом типа
-            if (command == "int" || command == "double" || command == "float" || command == "char") {
-                isTypeKeyword = true;
-            }
-            
-            if (programCounter + 1 < commands.size() && 
-                (commands[programCounter + 1] == ":=" || 
-                 commands[programCounter + 1] == "r" ||
-                 commands[programCounter + 1] == "declare_assign")) {
-                isAssignmentTarget = true;
-            }
-            
-            if (isTypeKeyword) {
-                // Ключевые слова типов - не загружаем в стек
-                std::cout << " → тип данных: " << command;
-            } else if (isAssignmentTarget) {
-                // Переменная перед := или r или declare_assign - это цель, не загружаем в стек
-                std::cout << " → цель для " << commands[programCounter + 1] << ": " << command;
-            } else {
-                // Обычная переменная или переменная перед w - помещаем её значение в стек
-                Value value = getVariable(command);
-                pushStack(value);
-                std::cout << " → стек: " << command << "=" << value;
-            }
-        }
-        else {
-            // Проверяем, является ли это меткой для команды перехода
-            if (programCounter > 0 && 
-                (commands[programCounter - 1] == "jf" || commands[programCounter - 1] == "j")) {
-                // Это метка после команды перехода, пропускаем её
-                std::cout << " (аргумент для " << commands[programCounter - 1] << ")";
-            }
-            else if (command.back() == ':') {
-                // Метка в коде
-                std::cout << " (метка)";
+            case OpCode::LOOP_INIT:
+                if (!executeLoopInit<Trace>(ins)) {
+                    programCounter = static_cast<size_t>(ins.a);
+                    trace<Trace>(" → цикл не выполняется, переход к PC=", ins.a, '\n');
+                    continue;
+                }
+                trace<Trace>(" → вход в цикл");
+                break;
+            case OpCode::LOOP_NEXT:
+                if (executeLoopNext<Trace>(ins)) {
+                    programCounter = static_cast<size_t>(ins.a);
+                    trace<Trace>(" → следующая итерация, переход к PC=", ins.a, '\n');
+                    programCounter = backEdge(programCounter);
+                    continue;
+                }
+                trace<Trace>(" → выход из цикла");
+                break;
+            case OpCode::GUARD_INDEX:
+            case OpCode::GUARD_ROW:
+            case OpCode::GUARD_COL:
+                if (!executeGuard<Trace>(ins)) {
+                    programCounter = static_cast<size_t>(ins.a);
+                    trace<Trace>(" → границы не доказаны, переход к проверяемой копии PC=", ins.a, '\n');
+                    continue;
+                }
+                trace<Trace>(" → границы доказаны");
+                break;
+            case OpCode::INC_VAR:
+                executeIncrement<Trace>(ins);
+                trace<Trace>(" → приращение переменной");
+                break;
+            case OpCode::CMP_VAR_VAR_JF:
+            case OpCode::CMP_VAR_CONST_JF: {
+                const Value& rhs = ins.op == OpCode::CMP_VAR_VAR_JF ? frame[ins.c] : ins.imm;
+                bool condition = compareValues(ins.fused, frame[ins.b], rhs);
+                trace<Trace>(" (", program.variables[ins.b], "=", frame[ins.b], ", ", rhs, " → ", condition ? 1 : 0, ")");
+                if (!condition) {
+                    size_t from = programCounter;
+                    programCounter = static_cast<size_t>(ins.a);
+                    trace<Trace>(" → условный переход к PC=", ins.a, '\n');
+                    if (programCounter <= from) {
+                        programCounter = backEdge(programCounter);
+                    }
+                    continue;
+                }
+                break;
             }
-            else {
+            case OpCode::LOAD_ELEM_VAR_INDEX:
+                loadElement<Trace>(ins.a, frame[ins.b].asInt());
+                trace<Trace>(" → получение элемента массива");
+                break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+                loadElement<Trace>(ins.a, frame[ins.b].asInt());
+                frame[ins.c] = stackTop[-1];
+                trace<Trace>(" → получение элемента массива (", program.variables[ins.c], ")");
+                break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+                loadElementUnchecked<Trace>(ins.a, frame[ins.b].rawInt());
+                trace<Trace>(" → получение элемента массива без проверки границ");
+                break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+                loadElementUnchecked<Trace>(ins.a, frame[ins.b].rawInt());
+                frame[ins.c] = stackTop[-1];
+                trace<Trace>(" → получение элемента массива без проверки границ (", program.variables[ins.c], ")");
+                break;
+            case OpCode::READ:
+                executeRead<Trace>(ins);
+                trace<Trace>(" → чтение");
+                break;
+            case OpCode::WRITE:
+                executeWrite<Trace>();
+                trace<Trace>(" → запись");
+                break;
+            case OpCode::ALLOC_ARRAY:
+                executeArrayAlloc<Trace>(ins);
+                trace<Trace>(" → выделение памяти массива");
+                break;
+            case OpCode::ARRAY_GET:
+                executeArrayGet<Trace>(ins);
+                trace<Trace>(" → получение элемента массива");
+                break;
+            case OpCode::ARRAY_SET:
+                executeArraySet<Trace>(ins);
+                trace<Trace>(" → установка элемента массива");
+                break;
+            case OpCode::ARRAY_READ:
+                executeArrayRead<Trace>(ins);
+                trace<Trace>(" → чтение в элемент массива");
+                break;
+            case OpCode::ALLOC_ARRAY_2D:
+                executeArrayAlloc2D<Trace>(ins);
+                trace<Trace>(" → выделение памяти 2D массива");
+                break;
+            case OpCode::ARRAY_GET_2D:
+                executeArrayGet2D<Trace>(ins);
+                trace<Trace>(" → получение элемента 2D массива");
+                break;
+            case OpCode::ARRAY_SET_2D:
+                executeArraySet2D<Trace>(ins);
+                trace<Trace>(" → установка элемента 2D массива");
+                break;
+            case OpCode::ARRAY_READ_2D:
+                executeArrayRead2D<Trace>(ins);
+                trace<Trace>(" → чтение в элемент 2D массива");
+                break;
+            case OpCode::ARRAY_GET_UNCHECKED:
+                loadElementUnchecked<Trace>(ins.a, popStack().rawInt());
+                trace<Trace>(" → получение элемента массива без проверки границ");
+                break;
+            case OpCode::ARRAY_SET_UNCHECKED:
+                executeArraySetUnchecked<Trace>(ins);
+                trace<Trace>(" → установка элемента массива без проверки границ");
+                break;
+            case OpCode::ARRAY_GET_2D_UNCHECKED:
+                executeArrayGet2DUnchecked<Trace>(ins);
+                trace<Trace>(" → получение элемента 2D массива без проверки границ");
+                break;
+            case OpCode::ARRAY_SET_2D_UNCHECKED:
+                executeArraySet2DUnchecked<Trace>(ins);
+                trace<Trace>(" → установка элемента 2D массива без проверки границ");
+                break;
+            case OpCode::NOP:
                 // Неизвестная команда
-                std::cout << " (неизвестная команда: " << command << ")";
-            }
+                trace<Trace>(" (неизвестная команда: ", program.text[programCounter], ")");
+                break;
         }
         
-        std::cout << std::endl;
+        trace<Trace>('\n');
         programCounter++;
     }
     
-    std::cout << std::string(50, '-') << std::endl;
-    std::cout << "✅ Выполнение завершено!" << std::endl;
-    printState();
 }
 
-void OPSInterpreter::parseLabels() {
-    labels.clear();
-    for (size_t i = 0; i < commands.size(); ++i) {
-        const std::string& command = commands[i];
-        if (command.back() == ':') {
-            // Это метка
-            std::string labelName = command.substr(0, command.length() - 1);
-            labels[labelName] = i;
+#ifdef OPS_THREADED_DISPATCH
+void OPSInterpreter::runThreaded() {
+    const Instruction* code = program.code.data();
+    const size_t count = program.code.size();
+    
+    // Шитый код: адрес обработчика для каждой команды; последний элемент -
+    // выход, на него попадает и переход за конец программы
+    std::vector<const void*> threaded(count + 1);
+    for (size_t i = 0; i < count; ++i) {
+        switch (code[i].op) {
+            case OpCode::NOP:
+            case OpCode::LABEL:               threaded[i] = &&op_nop; break;
+            case OpCode::POP:                 threaded[i] = &&op_pop; break;
+            case OpCode::TEE:                 threaded[i] = &&op_tee; break;
+            case OpCode::PUSH_CONST:          threaded[i] = &&op_push_const; break;
+            case OpCode::PUSH_VAR:            threaded[i] = &&op_push_var; break;
+            case OpCode::STORE:               threaded[i] = &&op_store; break;
+            case OpCode::DECLARE:             threaded[i] = &&op_declare; break;
+            case OpCode::DECLARE_ASSIGN:      threaded[i] = &&op_declare_assign; break;
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV:                 threaded[i] = &&op_arithmetic; break;
+            case OpCode::GT:
+            case OpCode::LT:
+            case OpCode::EQ:                  threaded[i] = &&op_comparison; break;
+            case OpCode::ADD_I32:             threaded[i] = &&op_add_i32; break;
+            case OpCode::SUB_I32:             threaded[i] = &&op_sub_i32; break;
+            case OpCode::MUL_I32:             threaded[i] = &&op_mul_i32; break;
+            case OpCode::DIV_I32:             threaded[i] = &&op_div_i32; break;
+            case OpCode::ADD_F64:             threaded[i] = &&op_add_f64; break;
+            case OpCode::SUB_F64:             threaded[i] = &&op_sub_f64; break;
+            case OpCode::MUL_F64:             threaded[i] = &&op_mul_f64; break;
+            case OpCode::DIV_F64:             threaded[i] = &&op_div_f64; break;
+            case OpCode::GT_I32:              threaded[i] = &&op_gt_i32; break;
+            case OpCode::LT_I32:              threaded[i] = &&op_lt_i32; break;
+            case OpCode::EQ_I32:              threaded[i] = &&op_eq_i32; break;
+            case OpCode::GT_F64:              threaded[i] = &&op_gt_f64; break;
+            case OpCode::LT_F64:              threaded[i] = &&op_lt_f64; break;
+            case OpCode::EQ_F64:              threaded[i] = &&op_eq_f64; break;
+            case OpCode::JUMP:                threaded[i] = &&op_jump; break;
+            case OpCode::JUMP_FALSE:          threaded[i] = &&op_jump_false; break;
+            case OpCode::READ:                threaded[i] = &&op_read; break;
+            case OpCode::WRITE:               threaded[i] = &&op_write; break;
+            case OpCode::ALLOC_ARRAY:         threaded[i] = &&op_alloc_array; break;
+            case OpCode::ARRAY_GET:           threaded[i] = &&op_array_get; break;
+            case OpCode::ARRAY_SET:           threaded[i] = &&op_array_set; break;
+            case OpCode::ARRAY_READ:          threaded[i] = &&op_array_read; break;
+            case OpCode::ALLOC_ARRAY_2D:      threaded[i] = &&op_alloc_array_2d; break;
+            case OpCode::ARRAY_GET_2D:        threaded[i] = &&op_array_get_2d; break;
+            case OpCode::ARRAY_SET_2D:        threaded[i] = &&op_array_set_2d; break;
+            case OpCode::ARRAY_READ_2D:       threaded[i] = &&op_array_read_2d; break;
+            case OpCode::INC_VAR:             threaded[i] = &&op_inc_var; break;
+            case OpCode::LOOP_INIT:           threaded[i] = &&op_loop_init; break;
+            case OpCode::LOOP_NEXT:           threaded[i] = &&op_loop_next; break;
+            case OpCode::CMP_VAR_VAR_JF:      threaded[i] = &&op_cmp_var_var_jf; break;
+            case OpCode::CMP_VAR_CONST_JF:    threaded[i] = &&op_cmp_var_const_jf; break;
+            case OpCode::LOAD_ELEM_VAR_INDEX: threaded[i] = &&op_load_elem_var_index; break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE: threaded[i] = &&op_load_elem_var_index_tee; break;
+            case OpCode::ARRAY_GET_UNCHECKED: threaded[i] = &&op_array_get_unchecked; break;
+            case OpCode::ARRAY_SET_UNCHECKED: threaded[i] = &&op_array_set_unchecked; break;
+            case OpCode::ARRAY_GET_2D_UNCHECKED: threaded[i] = &&op_array_get_2d_unchecked; break;
+            case OpCode::ARRAY_SET_2D_UNCHECKED: threaded[i] = &&op_array_set_2d_unchecked; break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED: threaded[i] = &&op_load_elem_var_index_unchecked; break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED: threaded[i] = &&op_load_elem_var_index_tee_unchecked; break;
+            case OpCode::GUARD_INDEX:
+            case OpCode::GUARD_ROW:
+            case OpCode::GUARD_COL:           threaded[i] = &&op_guard; break;
         }
     }
-}
-
-bool OPSInterpreter::isNumber(const std::string& str) const {
-    if (str.empty()) return false;
-    
-    size_t start = 0;
-    if (str[0] == '-' || str[0] == '+') {
-        start = 1;
-        if (str.length() == 1) return false;
-    }
-    
-    for (size_t i = start; i < str.length(); ++i) {
-        if (!std::isdigit(str[i])) {
-            return false;
-        }
+    threaded[count] = &&op_done;
+    
+    // Счётчик команд живёт в регистре; поле programCounter обновляется
+    // при каждом переходе, чтобы сообщения об ошибках указывали позицию
+    size_t pc = programCounter;
+    
+#define DISPATCH() do { programCounter = pc; goto *threaded[pc]; } while (0)
+#define NEXT() do { ++pc; DISPATCH(); } while (0)
+    
+    DISPATCH();
+    
+op_nop:
+    NEXT();
+op_pop:
+    --stackTop;
+    NEXT();
+op_tee:
+    frame[code[pc].a] = stackTop[-1];
+    NEXT();
+op_push_const:
+    pushStack(code[pc].imm);
+    NEXT();
+op_push_var:
+    pushStack(frame[code[pc].a]);
+    NEXT();
+op_store:
+    executeAssignment<TraceOff>(code[pc]);
+    NEXT();
+op_declare:
+    executeDeclare<TraceOff>(code[pc]);
+    NEXT();
+op_declare_assign:
+    executeDeclareAssign<TraceOff>(code[pc]);
+    NEXT();
+op_arithmetic:
+    executeArithmetic(code[pc].op);
+    NEXT();
+op_comparison:
+    executeComparison(code[pc].op);
+    NEXT();
+op_add_i32:
+    applyInt([](int a, int b) { return a + b; });
+    NEXT();
+op_sub_i32:
+    applyInt([](int a, int b) { return a - b; });
+    NEXT();
+op_mul_i32:
+    applyInt([](int a, int b) { return a * b; });
+    NEXT();
+op_div_i32:
+    if (stackTop[-1].rawInt() == 0) {
+        error("Деление на ноль");
+    }
+    applyInt([](int a, int b) { return a / b; });
+    NEXT();
+op_add_f64:
+    applyDouble([](double a, double b) { return a + b; });
+    NEXT();
+op_sub_f64:
+    applyDouble([](double a, double b) { return a - b; });
+    NEXT();
+op_mul_f64:
+    applyDouble([](double a, double b) { return a * b; });
+    NEXT();
+op_div_f64:
+    if (stackTop[-1].rawDouble() == 0.0) {
+        error("Деление на ноль");
+    }
+    applyDouble([](double a, double b) { return a / b; });
+    NEXT();
+op_gt_i32:
+    compareInt([](int a, int b) { return a > b; });
+    NEXT();
+op_lt_i32:
+    compareInt([](int a, int b) { return a < b; });
+    NEXT();
+op_eq_i32:
+    compareInt([](int a, int b) { return a == b; });
+    NEXT();
+op_gt_f64:
+    compareDouble([](double a, double b) { return a > b; });
+    NEXT();
+op_lt_f64:
+    compareDouble([](double a, double b) { return a < b; });
+    NEXT();
+op_eq_f64:
+    compareDouble([](double a, double b) { return a == b; });
+    NEXT();
+op_jump:
+    pc = static_cast<size_t>(code[pc].a) <= pc ? backEdge(static_cast<size_t>(code[pc].a)) : static_cast<size_t>(code[pc].a);
+    DISPATCH();
+op_jump_false: {
+    Value condition = popStack();
+    if ((condition.isInt() && condition.asInt() == 0) || (condition.isDouble() && condition.asDouble() == 0.0)) {
+        pc = static_cast<size_t>(code[pc].a) <= pc ? backEdge(static_cast<size_t>(code[pc].a)) : static_cast<size_t>(code[pc].a);
+        DISPATCH();
     }
-    return true;
+    NEXT();
 }
-
-bool OPSInterpreter::isDoubleNumber(const std::string& str) const {
-    if (str.empty()) return false;
-    
-    size_t start = 0;
-    if (str[0] == '-' || str[0] == '+') {
-        start = 1;
-        if (str.length() == 1) return false;
-    }
-    
-    bool hasDot = false;
-    for (size_t i = start; i < str.length(); ++i) {
-        if (str[i] == '.') {
-            if (hasDot) return false; // Вторая точка
-            hasDot = true;
-        } else if (!std::isdigit(str[i])) {
-            return false;
-        }
-    }
-    return hasDot; // Должна быть точка для double
+op_read:
+    executeRead<TraceOff>(code[pc]);
+    NEXT();
+op_write:
+    executeWrite<TraceOff>();
+    NEXT();
+op_alloc_array:
+    executeArrayAlloc<TraceOff>(code[pc]);
+    NEXT();
+op_array_get:
+    executeArrayGet<TraceOff>(code[pc]);
+    NEXT();
+op_array_set:
+    executeArraySet<TraceOff>(code[pc]);
+    NEXT();
+op_array_read:
+    executeArrayRead<TraceOff>(code[pc]);
+    NEXT();
+op_alloc_array_2d:
+    executeArrayAlloc2D<TraceOff>(code[pc]);
+    NEXT();
+op_array_get_2d:
+    executeArrayGet2D<TraceOff>(code[pc]);
+    NEXT();
+op_array_set_2d:
+    executeArraySet2D<TraceOff>(code[pc]);
+    NEXT();
+op_array_read_2d:
+    executeArrayRead2D<TraceOff>(code[pc]);
+    NEXT();
+op_inc_var:
+    executeIncrement<TraceOff>(code[pc]);
+    NEXT();
+op_loop_init:
+    if (!executeLoopInit<TraceOff>(code[pc])) {
+        pc = static_cast<size_t>(code[pc].a);
+        DISPATCH();
+    }
+    NEXT();
+op_loop_next:
+    if (executeLoopNext<TraceOff>(code[pc])) {
+        pc = backEdge(static_cast<size_t>(code[pc].a));
+        DISPATCH();
+    }
+    NEXT();
+op_cmp_var_var_jf: {
+    const Instruction& ins = code[pc];
+    if (!compareValues(ins.fused, frame[ins.b], frame[ins.c])) {
+        pc = static_cast<size_t>(ins.a) <= pc ? backEdge(static_cast<size_t>(ins.a)) : static_cast<size_t>(ins.a);
+        DISPATCH();
+    }
+    NEXT();
 }
-
-bool OPSInterpreter::isVariable(const std::string& str) const {
-    if (str.empty()) return false;
-    if (!std::isalpha(str[0]) && str[0] != '_') return false;
-    
-    for (size_t i = 1; i < str.length(); ++i) {
-        if (!std::isalnum(str[i]) && str[i] != '_') {
-            return false;
-        }
+op_cmp_var_const_jf: {
+    const Instruction& ins = code[pc];
+    if (!compareValues(ins.fused, frame[ins.b], ins.imm)) {
+        pc = static_cast<size_t>(ins.a) <= pc ? backEdge(static_cast<size_t>(ins.a)) : static_cast<size_t>(ins.a);
+        DISPATCH();
     }
-    return true;
+    NEXT();
 }
-
-bool OPSInterpreter::isOperator(const std::string& str) const {
-    return str == "+" || str == "-" || str == "*" || str == "/" ||
-           str == ">" || str == "<" || str == "==";
+op_load_elem_var_index:
+    loadElement<TraceOff>(code[pc].a, frame[code[pc].b].asInt());
+    NEXT();
+op_load_elem_var_index_tee:
+    loadElement<TraceOff>(code[pc].a, frame[code[pc].b].asInt());
+    frame[code[pc].c] = stackTop[-1];
+    NEXT();
+op_array_get_unchecked:
+    loadElementUnchecked<TraceOff>(code[pc].a, popStack().rawInt());
+    NEXT();
+op_array_set_unchecked:
+    executeArraySetUnchecked<TraceOff>(code[pc]);
+    NEXT();
+op_array_get_2d_unchecked:
+    executeArrayGet2DUnchecked<TraceOff>(code[pc]);
+    NEXT();
+op_array_set_2d_unchecked:
+    executeArraySet2DUnchecked<TraceOff>(code[pc]);
+    NEXT();
+op_load_elem_var_index_unchecked:
+    loadElementUnchecked<TraceOff>(code[pc].a, frame[code[pc].b].rawInt());
+    NEXT();
+op_load_elem_var_index_tee_unchecked:
+    loadElementUnchecked<TraceOff>(code[pc].a, frame[code[pc].b].rawInt());
+    frame[code[pc].c] = stackTop[-1];
+    NEXT();
+op_guard:
+    if (!executeGuard<TraceOff>(code[pc])) {
+        pc = static_cast<size_t>(code[pc].a);
+        DISPATCH();
+    }
+    NEXT();
+op_done:
+    return;
+    
+#undef NEXT
+#undef DISPATCH
 }
+#endif
 
-bool OPSInterpreter::isCommand(const std::string& str) const {
-    return str == ":=" || str == "jf" || str == "j" || str == "r" || str == "w" ||
-           str == "alloc_array" || str == "array_get" || str == "array_set" || str == "array_read" ||
-           str == "alloc_array_2d" || str == "array_get_2d" || str == "array_set_2d" || str == "array_read_2d" || 
-           str == "declare" || str == "declare_assign";
+size_t OPSInterpreter::backEdge(size_t header) {
+    // Условный переход назад может вести не на начало цикла j / loop_next
+    size_t index = profile.loopAt(header);
+    if (index == OPSProfile::NO_LOOP) return header;
+    LoopProfile& loop = profile.loop(index);
+    loop.backEdges++;
+    if (loop.tier == ExecutionTier::NATIVE) return enterNative(loop);
+    if (!loop.promotable || loop.backEdges < tierThreshold) return header;
+    
+    // Цикл стал горячим: одна попытка компиляции, при неудаче он навсегда
+    // остаётся интерпретатору
+    loop.promotable = false;
+    loop.promotionAttempt = loop.backEdges;
+    if (jit.compile(loop.header, loop.latch, arrays, arrays2D) == nullptr) return header;
+    profile.recordTransition(loop, ExecutionTier::NATIVE);
+    return enterNative(loop);
 }
 
-void OPSInterpreter::executeArithmetic(const std::string& op) {
-    if (operandStack.size() < 2) {
-        error("Недостаточно операндов для операции " + op);
+size_t OPSInterpreter::enterNative(LoopProfile& profiled) {
+    const size_t header = profiled.header;
+    const JitLoop* loop = jit.compiled(header);
+    
+    // Машинный код читает буферы того типа элементов, с которым компилировался
+    nativeArrays.resize(loop->arrays.size());
+    for (size_t i = 0; i < loop->arrays.size(); ++i) {
+        const JitArrayUse& use = loop->arrays[i];
+        ArrayStorage& array = use.twoDimensional ? arrays2D[use.index] : arrays[use.index];
+        if (!array.allocated || array.elementType != use.elementType) {
+            profiled.refusedEntries++;
+            return header;
+        }
+        JitArray& native = nativeArrays[i];
+        if (array.elementType == DataType::INT) {
+            native.data = array.ints.data();
+        } else if (array.elementType == DataType::CHAR) {
+            native.data = array.chars.data();
+        } else {
+            native.data = array.doubles.data();
+        }
+        native.size = static_cast<int64_t>(array.size());
+        native.rows = array.rows;
+        native.cols = array.cols;
     }
     
+    JitContext context{frame.data(), operandStack.data(), loopCounters.data(), loopRanges.data(),
+                       nativeArrays.data(), header, 0};
+    profiled.nativeEntries++;
+    loop->entry(&context);
+    if (context.resumePc >= header && context.resumePc <= profiled.latch) {
+        profiled.sideExits++;
+    }
+    stackTop = operandStack.data() + context.stackDepth;
+    programCounter = context.resumePc;
+    return context.resumePc;
+}
+
+void OPSInterpreter::executeArithmetic(OpCode op) {
     Value b = popStack(); // Второй операнд
     Value a = popStack(); // Первый операнд
     Value result;
     
-    if (op == "+") {
+    if (op == OpCode::ADD) {
         result = a + b;
-    } else if (op == "-") {
+    } else if (op == OpCode::SUB) {
         result = a - b;
-    } else if (op == "*") {
+    } else if (op == OpCode::MUL) {
         result = a * b;
-    } else if (op == "/") {
+    } else if (op == OpCode::DIV) {
         if ((b.isInt() && b.asInt() == 0) || (b.isDouble() && b.asDouble() == 0.0)) {
             error("Деление на ноль");
         }
@@ -317,28 +872,24 @@ void OPSInterpreter::executeArithmetic(const std::string& op) {
     pushStack(result);
 }
 
-void OPSInterpreter::executeComparison(const std::string& op) {
-    if (operandStack.size() < 2) {
-        error("Недостаточно операндов для сравнения " + op);
-    }
-    
+void OPSInterpreter::executeComparison(OpCode op) {
     Value b = popStack(); // Второй операнд
     Value a = popStack(); // Первый операнд
     Value result;
     
-    if (op == ">") {
+    if (op == OpCode::GT) {
         if (a.isDouble() || b.isDouble()) {
             result = Value(a.asDouble() > b.asDouble() ? 1 : 0);
         } else {
             result = Value(a.asInt() > b.asInt() ? 1 : 0);
         }
-    } else if (op == "<") {
+    } else if (op == OpCode::LT) {
         if (a.isDouble() || b.isDouble()) {
             result = Value(a.asDouble() < b.asDouble() ? 1 : 0);
         } else {
             result = Value(a.asInt() < b.asInt() ? 1 : 0);
         }
-    } else if (op == "==") {
+    } else if (op == OpCode::EQ) {
         if (a.isDouble() || b.isDouble()) {
             result = Value(a.asDouble() == b.asDouble() ? 1 : 0);
         } else {
@@ -349,175 +900,188 @@ void OPSInterpreter::executeComparison(const std::string& op) {
     pushStack(result);
 }
 
-void OPSInterpreter::executeAssignment() {
-    if (operandStack.size() < 1) {
-        error("Недостаточно операндов для присваивания");
-    }
-    
+template <class Trace>
+void OPSInterpreter::executeAssignment(const Instruction& ins) {
     Value value = popStack(); // Значение для присваивания
-    
-    // Имя переменной должно быть прямо перед командой ":="
-    if (programCounter == 0) {
-        error("Не найдена переменная для присваивания");
-    }
-    
-    std::string varName = commands[programCounter - 1];
-    
-    if (!isVariable(varName)) {
-        error("Неверное имя переменной для присваивания: " + varName);
-    }
-    
-    variables[varName] = value;
-    std::cout << " (" << varName << " = " << value << ")";
+    frame[ins.a] = value;
+    trace<Trace>(" (", program.variables[ins.a], " = ", value, ")");
 }
 
-void OPSInterpreter::executeJump(const std::string& label) {
-    auto it = labels.find(label);
-    if (it != labels.end()) {
-        programCounter = it->second;
-    } else {
-        error("Метка не найдена: " + label);
-    }
+void OPSInterpreter::executeJump(const Instruction& ins) {
+    // Адрес перехода разрешён компоновщиком
+    programCounter = static_cast<size_t>(ins.a);
 }
 
-void OPSInterpreter::executeConditionalJump(const std::string& label) {
-    if (operandStack.empty()) {
-        error("Нет условия для условного перехода");
-    }
-    
+template <class Trace>
+void OPSInterpreter::executeConditionalJump(const Instruction& ins) {
     Value condition = popStack();
     
     // jf - jump if false (переход если условие ложно)
     if ((condition.isInt() && condition.asInt() == 0) || (condition.isDouble() && condition.asDouble() == 0.0)) {
-        // Условие ложно - переходим к метке
-        auto it = labels.find(label);
-        if (it != labels.end()) {
-            programCounter = it->second;
-            std::cout << " (переход выполнен: условие = " << condition << ")";
-        } else {
-            error("Метка не найдена: " + label);
-        }
+        // Условие ложно - переходим по адресу метки
+        programCounter = static_cast<size_t>(ins.a);
+        trace<Trace>(" (переход выполнен: условие = ", condition, ")");
     } else {
         // Условие истинно - продолжаем выполнение (programCounter будет увеличен в основном цикле)
-        std::cout << " (переход НЕ выполнен: условие = " << condition << ")";
+        trace<Trace>(" (переход НЕ выполнен: условие = ", condition, ")");
     }
 }
 
+// Глубина стека в каждой команде доказана компоновщиком (опустошение и
+// переполнение невозможны), поэтому проверок границ здесь нет
 Value OPSInterpreter::popStack() {
-    if (operandStack.empty()) {
-        error("Попытка извлечения из пустого стека");
-    }
-    
-    Value value = operandStack.top();
-    operandStack.pop();
-    return value;
+    return *--stackTop;
 }
 
 void OPSInterpreter::pushStack(const Value& value) {
-    operandStack.push(value);
+    *stackTop++ = value;
+}
+
+// Специализированные операции: типы обоих операндов доказаны выводом типов,
+// поэтому поле объединения читается напрямую, без проверки тега
+template <class Op>
+void OPSInterpreter::applyInt(Op op) {
+    Value& a = stackTop[-2];
+    a.setRawInt(op(a.rawInt(), stackTop[-1].rawInt()));
+    --stackTop;
+}
+
+template <class Op>
+void OPSInterpreter::applyDouble(Op op) {
+    Value& a = stackTop[-2];
+    a.setRawDouble(op(a.rawDouble(), stackTop[-1].rawDouble()));
+    --stackTop;
+}
+
+template <class Op>
+void OPSInterpreter::compareInt(Op op) {
+    Value& a = stackTop[-2];
+    a.setRawInt(op(a.rawInt(), stackTop[-1].rawInt()) ? 1 : 0);
+    --stackTop;
+}
+
+template <class Op>
+void OPSInterpreter::compareDouble(Op op) {
+    Value& a = stackTop[-2];
+    a = Value(op(a.rawDouble(), stackTop[-1].rawDouble()) ? 1 : 0);
+    --stackTop;
 }
 
 void OPSInterpreter::setVariable(const std::string& name, const Value& value) {
-    variables[name] = value;
+    frame[slotFor(name)] = value;
 }
 
 void OPSInterpreter::setVariable(const std::string& name, int value) {
-    variables[name] = Value(value);
+    frame[slotFor(name)] = Value(value);
 }
 
 void OPSInterpreter::setVariable(const std::string& name, double value) {
-    variables[name] = Value(value);
+    frame[slotFor(name)] = Value(value);
 }
 
 Value OPSInterpreter::getVariable(const std::string& name) const {
-    auto it = variables.find(name);
-    if (it != variables.end()) {
-        return it->second;
+    for (size_t i = 0; i < program.variables.size(); ++i) {
+        if (program.variables[i] == name) {
+            return frame[i];
+        }
     }
     return Value(); // Неинициализированные переменные имеют значение 0
 }
 
+size_t OPSInterpreter::slotFor(const std::string& name) {
+    // Поиск по имени нужен только вне основного цикла (API и смена программы)
+    for (size_t i = 0; i < program.variables.size(); ++i) {
+        if (program.variables[i] == name) {
+            return i;
+        }
+    }
+    program.variables.push_back(name);
+    frame.push_back(Value());
+    return program.variables.size() - 1;
+}
+
 void OPSInterpreter::printState() const {
     std::cout << "\n СОСТОЯНИЕ ИНТЕРПРЕТАТОРА:" << std::endl;
     
     std::cout << "Переменные:" << std::endl;
-    if (variables.empty()) {
+    if (frame.empty()) {
         std::cout << "  (нет переменных)" << std::endl;
     } else {
-        for (const auto& var : variables) {
-            std::cout << "  " << var.first << " = " << var.second << std::endl;
+        for (size_t i = 0; i < frame.size(); ++i) {
+            if (isTemporaryName(program.variables[i])) continue;
+            std::cout << "  " << program.variables[i] << " = " << frame[i] << std::endl;
         }
     }
     
     std::cout << "Массивы:" << std::endl;
-    if (arrays.empty()) {
-        std::cout << "  (нет одномерных массивов)" << std::endl;
-    } else {
-        for (const auto& array : arrays) {
-            std::cout << "  " << array.first << "[" << array.second.size() << "] = {";
-            for (size_t i = 0; i < array.second.size(); ++i) {
-                std::cout << array.second[i];
-                if (i < array.second.size() - 1) std::cout << ", ";
-            }
-            std::cout << "}" << std::endl;
+    bool hasArrays = false;
+    for (size_t a = 0; a < arrays.size(); ++a) {
+        const ArrayStorage& array = arrays[a];
+        if (!array.allocated) continue;
+        hasArrays = true;
+        std::cout << "  " << program.arrays[a] << "[" << array.size() << "] = {";
+        for (size_t i = 0; i < array.size(); ++i) {
+            std::cout << array.load(i);
+            if (i < array.size() - 1) std::cout << ", ";
         }
+        std::cout << "}" << std::endl;
+    }
+    if (!hasArrays) {
+        std::cout << "  (нет одномерных массивов)" << std::endl;
     }
     
     std::cout << "Двумерные массивы:" << std::endl;
-    if (arrays2D.empty()) {
-        std::cout << "  (нет двумерных массивов)" << std::endl;
-    } else {
-        for (const auto& array : arrays2D) {
-            std::cout << "  " << array.first << "[" << array.second.size() << "][" 
-                      << (array.second.empty() ? 0 : array.second[0].size()) << "] = {" << std::endl;
-            for (size_t i = 0; i < array.second.size(); ++i) {
-                std::cout << "    {";
-                for (size_t j = 0; j < array.second[i].size(); ++j) {
-                    std::cout << array.second[i][j];
-                    if (j < array.second[i].size() - 1) std::cout << ", ";
-                }
-                std::cout << "}";
-                if (i < array.second.size() - 1) std::cout << ",";
-                std::cout << std::endl;
+    bool hasArrays2D = false;
+    for (size_t a = 0; a < arrays2D.size(); ++a) {
+        const ArrayStorage& array = arrays2D[a];
+        if (!array.allocated) continue;
+        hasArrays2D = true;
+        std::cout << "  " << program.arrays[a] << "[" << array.rows << "][" << array.cols << "] = {" << std::endl;
+        for (int i = 0; i < array.rows; ++i) {
+            std::cout << "    {";
+            for (int j = 0; j < array.cols; ++j) {
+                std::cout << array.load(static_cast<size_t>(i) * array.cols + j);
+                if (j < array.cols - 1) std::cout << ", ";
             }
-            std::cout << "  }" << std::endl;
+            std::cout << "}";
+            if (i < array.rows - 1) std::cout << ",";
+            std::cout << std::endl;
         }
+        std::cout << "  }" << std::endl;
+    }
+    if (!hasArrays2D) {
+        std::cout << "  (нет двумерных массивов)" << std::endl;
     }
     
     std::cout << "Стек операндов:" << std::endl;
-    if (operandStack.empty()) {
+    const Value* stackBase = operandStack.data();
+    if (stackTop == stackBase) {
         std::cout << "  (пустой)" << std::endl;
     } else {
-        std::stack<Value> tempStack = operandStack;
-        std::vector<Value> stackContents;
-        while (!tempStack.empty()) {
-            stackContents.push_back(tempStack.top());
-            tempStack.pop();
-        }
         std::cout << "  ";
-        for (int i = static_cast<int>(stackContents.size()) - 1; i >= 0; --i) {
-            std::cout << stackContents[i];
+        for (const Value* slot = stackBase; slot != stackTop; ++slot) {
+            std::cout << *slot;
         }
         std::cout << "(вершина справа)" << std::endl;
     }
     
-    if (!labels.empty()) {
+    if (!program.labels.empty() && program.linked) {
         std::cout << "Метки:" << std::endl;
-        for (const auto& label : labels) {
-            std::cout << "  " << label.first << " -> позиция " << label.second << std::endl;
+        for (size_t i = 0; i < program.labels.size(); ++i) {
+            std::cout << "  " << program.labels[i] << " -> позиция " << program.labelTargets[i] << std::endl;
         }
     }
 }
 
 void OPSInterpreter::reset() {
-    while (!operandStack.empty()) {
-        operandStack.pop();
-    }
-    variables.clear();
+    operandStack.clear();
+    stackTop = operandStack.data();
+    frame.clear();
     arrays.clear();
     arrays2D.clear();
-    labels.clear();
-    commands.clear();
+    jit.clear();
+    profile.clear();
+    program = OPSProgram();
     programCounter = 0;
     running = false;
 }
@@ -527,401 +1091,348 @@ void OPSInterpreter::error(const std::string& message) const {
                               " (позиция " + std::to_string(programCounter) + ")");
 }
 
-void OPSInterpreter::executeRead() {
+template <class Trace>
+void OPSInterpreter::executeRead(const Instruction& ins) {
     // Операция чтения - запрашиваем значение у пользователя
-    std::cout << "\n  Введите значение: ";
-    double value;
-    std::cin >> value;
-    
-    // Проверяем, была ли перед командой r операция индексации i
-    if (programCounter >= 1 && commands[programCounter - 1] == "i") {
-        // Записываем в массив M[index]
-        // Нужно найти имя массива и индекс в предыдущих командах
-        if (programCounter >= 3) {
-            std::string arrayName = commands[programCounter - 3]; // M
-            std::string indexVar = commands[programCounter - 2];   // a
-            
-            int index = getVariable(indexVar).asInt();
-            
-            if (arrays.find(arrayName) == arrays.end()) {
-                // Автоматически создаем массив если его нет
-                arrays[arrayName] = std::vector<Value>(10, Value(0)); // размер по умолчанию
-            }
-            
-            if (index >= 0 && index < static_cast<int>(arrays[arrayName].size())) {
-                arrays[arrayName][index] = Value(value);
-                std::cout << "  Прочитано в " << arrayName << "[" << index << "] = " << value;
-            } else {
-                error("Индекс массива вне границ при записи: " + std::to_string(index));
-            }
-        } else {
-            error("Недостаточно информации для записи в массив");
+    double value = 0.0;
+    if (input != nullptr) {
+        // Неинтерактивный режим: без приглашения
+        if (!input->next(value)) {
+            error("Входные данные исчерпаны");
         }
     } else {
-        // Обычная запись в переменную
-        if (programCounter == 0) {
-            error("Не найдена переменная для чтения");
-        }
-        
-        std::string varName = commands[programCounter - 1];
-        
-        if (!isVariable(varName)) {
-            error("Неверное имя переменной для чтения: " + varName);
-        }
-        
-        variables[varName] = Value(value);
-        std::cout << "  Прочитано: " << varName << " = " << value;
+        output->flush();
+        std::cout << "\n  Введите значение: ";
+        std::cin >> value;
     }
+    
+    frame[ins.a] = Value(value);
+    trace<Trace>("  Прочитано: ", program.variables[ins.a], " = ", value);
 }
 
+template <class Trace>
 void OPSInterpreter::executeWrite() {
     // Операция записи - выводим значение из стека
-    if (operandStack.empty()) {
-        error("Нет значения для вывода");
-    }
-    
     Value value = popStack();
-    std::cout << "\n  ВЫВОД: " << value;
+    output->write(value);
+    if constexpr (Trace::enabled) {
+        // При трассировке вывод сбрасывается сразу, чтобы не перемешаться с трассой
+        std::cout << std::endl;
+        output->flush();
+    }
 }
 
-void OPSInterpreter::executeArrayAlloc() {
+template <class Trace>
+void OPSInterpreter::executeArrayAlloc(const Instruction& ins) {
     // Формат: type arrayName size alloc_array → выделяет память для массива arrayName размером size
+    // Тип, имя и размер разобраны при загрузке
+    ArrayStorage& array = arrays[ins.a];
+    int size = ins.b;
     
-    // Размер должен быть в стеке (последний элемент перед командой)
-    // Имя массива и тип - в командах перед alloc_array
-    if (programCounter < 3) {
-        error("Недостаточно аргументов для выделения памяти массива");
-    }
-    
-    std::string arraySize = commands[programCounter - 1]; // размер массива
-    std::string arrayName = commands[programCounter - 2]; // имя массива
-    std::string arrayType = commands[programCounter - 3]; // тип массива
-    
-    if (!isNumber(arraySize)) {
-        error("Неверный размер массива: " + arraySize);
-    }
+    // Выделяем память для массива размером size (без +1) в буфере объявленного типа
+    array.allocate(ins.type, size);
+    array.rows = size;
+    array.cols = 1;
     
-    int size = std::stoi(arraySize);
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива для выделения памяти: " + arrayName);
-    }
-    
-    if (size < 0) {
-        error("Неверный размер массива: " + std::to_string(size));
-    }
-    
-    // Выделяем память для массива размером size (без +1)
-    arrays[arrayName] = std::vector<Value>(size, Value(0));
-    
-    std::cout << " (выделен массив " << arrayType << " " << arrayName << "[" << size << "], индексы 0-" << (size - 1) << ")";
+    trace<Trace>(" (выделен массив ", program.arrays[ins.a], "[", size, "], индексы 0-", (size - 1), ")");
 }
 
-void OPSInterpreter::executeArrayGet() {
+template <class Trace>
+void OPSInterpreter::executeArrayGet(const Instruction& ins) {
     // Формат: arrayName index array_get → значение arrayName[index]
-    if (operandStack.size() < 1) {
-        error("Недостаточно операндов для получения элемента массива");
-    }
-    
     int index = popStack().asInt();  // Индекс массива
-    
-    // Имя массива должно быть перед индексом (за 2 позиции назад)
-    if (programCounter < 2) {
-        error("Не найдено имя массива для получения элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 2]; // имя массива перед индексом
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    loadElement<Trace>(ins.a, index);
+}
+
+template <class Trace>
+void OPSInterpreter::loadElement(int arrayIndex, int index) {
+    const ArrayStorage& array = arrays[arrayIndex];
     
     // Проверяем границы массива
-    if (arrays.find(arrayName) == arrays.end()) {
-        error("Массив не инициализирован: " + arrayName);
+    if (!array.allocated) {
+        error("Массив не инициализирован: " + program.arrays[arrayIndex]);
     }
     
-    if (index < 0 || index >= static_cast<int>(arrays[arrayName].size())) {
+    if (index < 0 || index >= static_cast<int>(array.size())) {
         error("Индекс массива вне границ: " + std::to_string(index));
     }
     
     // Помещаем значение массива в стек (для чтения)
-    pushStack(arrays[arrayName][index]);
-    std::cout << " (" << arrayName << "[" << index << "] = " << arrays[arrayName][index] << ")";
+    pushStack(array.load(index));
+    trace<Trace>(" (", program.arrays[arrayIndex], "[", index, "] = ", array.load(index), ")");
 }
 
-void OPSInterpreter::executeArraySet() {
-    // Формат: arrayName index value array_set → устанавливает arrayName[index] = value
-    if (operandStack.size() < 2) {
-        error("Недостаточно операндов для установки элемента массива");
+template <class Trace>
+bool OPSInterpreter::executeLoopInit(const Instruction& ins) {
+    // Граница инвариантна в цикле - число итераций считается один раз
+    Value bound = popStack();
+    int start = frame[ins.b].asInt();
+    long long count = tripCount(start, bound, ins.imm.asInt(), ins.fused);
+    loopCounters[ins.c] = count;
+    if (count > 0) {
+        long long last = start + (count - 1) * ins.imm.asInt();
+        loopRanges[ins.c].low = std::min<long long>(start, last);
+        loopRanges[ins.c].high = std::max<long long>(start, last);
+    }
+    trace<Trace>(" (", program.variables[ins.b], " = ", frame[ins.b], ", граница ", bound, ", итераций: ", count, ")");
+    return count > 0;
+}
+
+template <class Trace>
+bool OPSInterpreter::executeLoopNext(const Instruction& ins) {
+    // Переменная цикла - int (объявлена как int, в теле не меняется)
+    Value& variable = frame[ins.b];
+    variable = Value(variable.asInt() + ins.imm.asInt());
+    trace<Trace>(" (", program.variables[ins.b], " = ", variable, ")");
+    return --loopCounters[ins.c] > 0;
+}
+
+template <class Trace>
+bool OPSInterpreter::executeGuard(const Instruction& ins) {
+    // Все значения индекса i + imm за цикл против текущего размера массива;
+    // невыделенный массив охрану не проходит - ошибку выдаст проверяемая копия
+    const ArrayStorage& array = ins.op == OpCode::GUARD_INDEX ? arrays[ins.b] : arrays2D[ins.b];
+    long long extent = 0;
+    if (array.allocated) {
+        if (ins.op == OpCode::GUARD_INDEX) {
+            extent = static_cast<long long>(array.size());
+        } else {
+            extent = ins.op == OpCode::GUARD_ROW ? array.rows : array.cols;
+        }
     }
-    
+    const LoopRange& range = loopRanges[ins.c];
+    long long low = range.low + ins.imm.asInt();
+    long long high = range.high + ins.imm.asInt();
+    trace<Trace>(" (", program.arrays[ins.b], ": индексы ", low, "..", high, ", размер ", extent, ")");
+    return low >= 0 && high < extent;
+}
+
+// Варианты без проверки: индекс доказан охраной цикла, массив выделен
+template <class Trace>
+void OPSInterpreter::loadElementUnchecked(int arrayIndex, int index) {
+    const ArrayStorage& array = arrays[arrayIndex];
+    pushStack(array.load(static_cast<size_t>(index)));
+    trace<Trace>(" (", program.arrays[arrayIndex], "[", index, "] = ", stackTop[-1], ")");
+}
+
+template <class Trace>
+void OPSInterpreter::executeArraySetUnchecked(const Instruction& ins) {
+    Value value = popStack();
+    int index = popStack().rawInt();
+    arrays[ins.a].store(static_cast<size_t>(index), value);
+    trace<Trace>(" (", program.arrays[ins.a], "[", index, "] = ", value, ")");
+}
+
+template <class Trace>
+void OPSInterpreter::executeArrayGet2DUnchecked(const Instruction& ins) {
+    int col = popStack().rawInt();
+    int row = popStack().rawInt();
+    const ArrayStorage& array = arrays2D[ins.a];
+    pushStack(array.load(static_cast<size_t>(row) * array.cols + col));
+    trace<Trace>(" (", program.arrays[ins.a], "[", row, "][", col, "] = ", stackTop[-1], ")");
+}
+
+template <class Trace>
+void OPSInterpreter::executeArraySet2DUnchecked(const Instruction& ins) {
+    Value value = popStack();
+    int col = popStack().rawInt();
+    int row = popStack().rawInt();
+    ArrayStorage& array = arrays2D[ins.a];
+    array.store(static_cast<size_t>(row) * array.cols + col, value);
+    trace<Trace>(" (", program.arrays[ins.a], "[", row, "][", col, "] = ", value, ")");
+}
+
+template <class Trace>
+void OPSInterpreter::executeIncrement(const Instruction& ins) {
+    // Суперкоманда x c + x := (или x c - x :=); типизированный вариант без проверки тега
+    Value& variable = frame[ins.a];
+    switch (ins.fused) {
+        case OpCode::ADD_I32: variable.setRawInt(variable.rawInt() + ins.imm.rawInt()); break;
+        case OpCode::SUB_I32: variable.setRawInt(variable.rawInt() - ins.imm.rawInt()); break;
+        case OpCode::ADD_F64: variable.setRawDouble(variable.rawDouble() + ins.imm.rawDouble()); break;
+        case OpCode::SUB_F64: variable.setRawDouble(variable.rawDouble() - ins.imm.rawDouble()); break;
+        case OpCode::SUB:     variable = variable - ins.imm; break;
+        default:              variable = variable + ins.imm; break;
+    }
+    trace<Trace>(" (", program.variables[ins.a], " = ", variable, ")");
+}
+
+template <class Trace>
+void OPSInterpreter::executeArraySet(const Instruction& ins) {
+    // Формат: arrayName index value array_set → устанавливает arrayName[index] = value
     Value value = popStack();  // Значение для установки (последнее в стеке)
     int index = popStack().asInt();   // Индекс массива (предпоследнее в стеке)
-    
-    // Имя массива должно быть за 3 позиции назад (arrayName index value array_set)
-    if (programCounter < 3) {
-        error("Не найдено имя массива для установки элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 3]; // имя массива перед индексом и значением
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    ArrayStorage& array = arrays[ins.a];
     
     // Проверяем границы массива
-    if (arrays.find(arrayName) == arrays.end()) {
-        error("Массив не инициализирован: " + arrayName);
+    if (!array.allocated) {
+        error("Массив не инициализирован: " + program.arrays[ins.a]);
     }
     
-    if (index < 0 || index >= static_cast<int>(arrays[arrayName].size())) {
+    if (index < 0 || index >= static_cast<int>(array.size())) {
         error("Индекс массива вне границ: " + std::to_string(index));
     }
     
-    arrays[arrayName][index] = value;
-    std::cout << " (" << arrayName << "[" << index << "] = " << value << ")";
+    array.store(index, value);
+    trace<Trace>(" (", program.arrays[ins.a], "[", index, "] = ", value, ")");
 }
 
-void OPSInterpreter::executeArrayRead() {
+template <class Trace>
+void OPSInterpreter::executeArrayRead(const Instruction& ins) {
     // Формат: arrayName index array_read → считывает значение в arrayName[index]
-    if (operandStack.size() < 1) {
-        error("Недостаточно операндов для чтения элемента массива");
-    }
-    
     int index = popStack().asInt();  // Индекс массива
-    
-    // Имя массива должно быть перед индексом (за 2 позиции назад)
-    if (programCounter < 2) {
-        error("Не найдено имя массива для чтения элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 2]; // имя массива перед индексом
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    ArrayStorage& array = arrays[ins.a];
+    const std::string& arrayName = program.arrays[ins.a];
     
     // Проверяем границы массива
-    if (arrays.find(arrayName) == arrays.end()) {
+    if (!array.allocated) {
         error("Массив не инициализирован: " + arrayName);
     }
     
-    if (index < 0 || index >= static_cast<int>(arrays[arrayName].size())) {
+    if (index < 0 || index >= static_cast<int>(array.size())) {
         error("Индекс массива вне границ: " + std::to_string(index));
     }
     
     // Запрашиваем ввод от пользователя
-    std::cout << "\n  Введите значение для " << arrayName << "[" << index << "]: ";
-    double value;
-    std::cin >> value;
+    double value = 0.0;
+    if (input != nullptr) {
+        // Неинтерактивный режим: без приглашения
+        if (!input->next(value)) {
+            error("Входные данные исчерпаны");
+        }
+    } else {
+        output->flush();
+        std::cout << "\n  Введите значение для " << arrayName << "[" << index << "]: ";
+        std::cin >> value;
+    }
     
     // Записываем значение в массив
-    arrays[arrayName][index] = Value(value);
-    std::cout << "  Прочитано в " << arrayName << "[" << index << "] = " << value;
+    array.store(index, Value(value));
+    trace<Trace>("  Прочитано в ", arrayName, "[", index, "] = ", value);
 }
 
-void OPSInterpreter::executeDeclare() {
-    // Формат: M a declare → объявляет переменную M с начальным значением a
-    if (operandStack.size() < 1) {
-        error("Недостаточно операндов для объявления переменной");
-    }
-    
-    int value = popStack().asInt();  // Начальное значение переменной
-    
-    if (programCounter < 2) {
-        error("Не найдено имя переменной для объявления");
-    }
-    
-    std::string varName = commands[programCounter - 2];
-    
-    if (!isVariable(varName)) {
-        error("Неверное имя переменной для объявления: " + varName);
+template <class Trace>
+void OPSInterpreter::executeDeclare(const Instruction& ins) {
+    // Формат: type varName declare → объявляет переменную varName с нулевым значением типа type
+    Value typedValue;
+    if (ins.type == DataType::DOUBLE || ins.type == DataType::FLOAT) {
+        typedValue = Value(0.0);
+    } else {
+        typedValue = Value(0);
     }
     
-    variables[varName] = Value(value);
-    std::cout << " (" << varName << " = " << value << ")";
+    frame[ins.a] = typedValue;
+    trace<Trace>(" (", program.variables[ins.a], " = ", typedValue, ")");
 }
 
-void OPSInterpreter::executeDeclareAssign() {
+template <class Trace>
+void OPSInterpreter::executeDeclareAssign(const Instruction& ins) {
     // Формат: value type varName declare_assign → объявляет типизированную переменную
-    if (operandStack.size() < 1) {
-        error("Недостаточно операндов для типизированного объявления");
-    }
-    
     Value value = popStack();  // Значение для присваивания
     
-    if (programCounter < 2) {
-        error("Не найдено имя переменной для типизированного объявления");
-    }
-    
-    std::string varName = commands[programCounter - 1]; // имя переменной
-    std::string varType = commands[programCounter - 2]; // тип переменной
-    
-    if (!isVariable(varName)) {
-        error("Неверное имя переменной для объявления: " + varName);
-    }
-    
     // Приводим значение к нужному типу
     Value typedValue;
-    if (varType == "int") {
+    if (ins.type == DataType::INT) {
         typedValue = Value(value.asInt()); // принудительно int
-    } else if (varType == "double" || varType == "float") {
+    } else if (ins.type == DataType::DOUBLE || ins.type == DataType::FLOAT) {
         typedValue = Value(value.asDouble()); // принудительно double
     } else {
         typedValue = value; // для char и других типов оставляем как есть
     }
     
-    variables[varName] = typedValue;
-    std::cout << " (" << varType << " " << varName << " = " << typedValue << ")";
-}
-
-bool OPSInterpreter::isArrayName(const std::string& name) const {
-    // Проверяем, является ли имя именем массива
-    return arrays.find(name) != arrays.end() || 
-           (isVariable(name) && name.length() == 1 && std::isupper(name[0]));
+    frame[ins.a] = typedValue;
+    trace<Trace>(" (", program.variables[ins.a], " = ", typedValue, ")");
 }
 
-void OPSInterpreter::executeArrayAlloc2D() {
+template <class Trace>
+void OPSInterpreter::executeArrayAlloc2D(const Instruction& ins) {
     // Формат: type arrayName rows cols alloc_array_2d → выделяет память для двумерного массива arrayName размером rows x cols
+    // Элементы хранятся в одном непрерывном буфере объявленного типа по строкам: [row][col] → элемент row * cols + col
+    ArrayStorage& array = arrays2D[ins.a];
+    int rows = ins.b;
+    int cols = ins.c;
     
-    // Размеры должны быть в командах перед alloc_array_2d
-    if (programCounter < 4) {
-        error("Недостаточно аргументов для выделения памяти двумерного массива");
-    }
+    array.allocate(ins.type, static_cast<size_t>(rows) * cols);
+    array.rows = rows;
+    array.cols = cols;
     
-    std::string colsStr = commands[programCounter - 1]; // количество столбцов
-    std::string rowsStr = commands[programCounter - 2]; // количество строк
-    std::string arrayName = commands[programCounter - 3]; // имя массива
-    std::string arrayType = commands[programCounter - 4]; // тип массива
-    
-    if (!isNumber(rowsStr) || !isNumber(colsStr)) {
-        error("Неверные размеры массива: " + rowsStr + " x " + colsStr);
-    }
-    
-    int rows = std::stoi(rowsStr);
-    int cols = std::stoi(colsStr);
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива для выделения памяти: " + arrayName);
-    }
-    
-    if (rows < 0 || cols < 0) {
-        error("Неверные размеры массива: " + std::to_string(rows) + " x " + std::to_string(cols));
-    }
-    
-    // Выделяем память для двумерного массива
-    arrays2D[arrayName] = std::vector<std::vector<Value>>(rows, std::vector<Value>(cols, Value(0)));
-    
-    std::cout << " (выделен двумерный массив " << arrayType << " " << arrayName << "[" << rows << "][" << cols << "])";
+    trace<Trace>(" (выделен двумерный массив ", program.arrays[ins.a], "[", rows, "][", cols, "])");
 }
 
-void OPSInterpreter::executeArrayGet2D() {
+template <class Trace>
+void OPSInterpreter::executeArrayGet2D(const Instruction& ins) {
     // Формат: arrayName row col array_get_2d → значение arrayName[row][col]
-    if (operandStack.size() < 2) {
-        error("Недостаточно операндов для получения элемента двумерного массива");
-    }
-    
     int col = popStack().asInt();  // Индекс столбца
     int row = popStack().asInt();  // Индекс строки
-    
-    // Имя массива должно быть за 3 позиции назад (arrayName row col array_get_2d)
-    if (programCounter < 3) {
-        error("Не найдено имя массива для получения элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 3]; // имя массива перед индексами
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    const ArrayStorage& array = arrays2D[ins.a];
     
     // Проверяем границы массива
-    if (arrays2D.find(arrayName) == arrays2D.end()) {
-        error("Двумерный массив не инициализирован: " + arrayName);
+    if (!array.allocated) {
+        error("Двумерный массив не инициализирован: " + program.arrays[ins.a]);
     }
     
-    if (row < 0 || row >= static_cast<int>(arrays2D[arrayName].size()) ||
-        col < 0 || col >= static_cast<int>(arrays2D[arrayName][row].size())) {
+    if (row < 0 || row >= array.rows || col < 0 || col >= array.cols) {
         error("Индексы массива вне границ: " + std::to_string(row) + ", " + std::to_string(col));
     }
     
     // Помещаем значение массива в стек (для чтения)
-    pushStack(arrays2D[arrayName][row][col]);
-    std::cout << " (" << arrayName << "[" << row << "][" << col << "] = " << arrays2D[arrayName][row][col] << ")";
+    Value value = array.load(static_cast<size_t>(row) * array.cols + col);
+    pushStack(value);
+    trace<Trace>(" (", program.arrays[ins.a], "[", row, "][", col, "] = ", value, ")");
 }
 
-void OPSInterpreter::executeArraySet2D() {
+template <class Trace>
+void OPSInterpreter::executeArraySet2D(const Instruction& ins) {
     // Формат: arrayName row col value array_set_2d → устанавливает arrayName[row][col] = value
-    if (operandStack.size() < 3) {
-        error("Недостаточно операндов для установки элемента двумерного массива");
-    }
-    
     Value value = popStack();  // Значение для установки (последнее в стеке)
     int col = popStack().asInt();    // Индекс столбца (предпоследнее в стеке)
     int row = popStack().asInt();    // Индекс строки (первое в стеке)
-    
-    // Имя массива должно быть за 4 позиции назад (arrayName row col value array_set_2d)
-    if (programCounter < 4) {
-        error("Не найдено имя массива для установки элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 4]; // имя массива перед всеми аргументами
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    ArrayStorage& array = arrays2D[ins.a];
     
     // Проверяем границы массива
-    if (arrays2D.find(arrayName) == arrays2D.end()) {
-        error("Двумерный массив не инициализирован: " + arrayName);
+    if (!array.allocated) {
+        error("Двумерный массив не инициализирован: " + program.arrays[ins.a]);
     }
     
-    if (row < 0 || row >= static_cast<int>(arrays2D[arrayName].size()) ||
-        col < 0 || col >= static_cast<int>(arrays2D[arrayName][row].size())) {
+    if (row < 0 || row >= array.rows || col < 0 || col >= array.cols) {
         error("Индексы массива вне границ: " + std::to_string(row) + ", " + std::to_string(col));
     }
     
-    arrays2D[arrayName][row][col] = value;
-    std::cout << " (" << arrayName << "[" << row << "][" << col << "] = " << value << ")";
+    array.store(static_cast<size_t>(row) * array.cols + col, value);
+    trace<Trace>(" (", program.arrays[ins.a], "[", row, "][", col, "] = ", value, ")");
 }
 
-void OPSInterpreter::executeArrayRead2D() {
+template <class Trace>
+void OPSInterpreter::executeArrayRead2D(const Instruction& ins) {
     // Формат: arrayName row col array_read_2d → считывает значение в arrayName[row][col]
-    if (operandStack.size() < 2) {
-        error("Недостаточно операндов для чтения элемента двумерного массива");
-    }
-    
     int col = popStack().asInt();  // Индекс столбца
     int row = popStack().asInt();  // Индекс строки
-    
-    // Имя массива должно быть за 3 позиции назад (arrayName row col array_read_2d)
-    if (programCounter < 3) {
-        error("Не найдено имя массива для чтения элемента");
-    }
-    
-    std::string arrayName = commands[programCounter - 3]; // имя массива перед индексами
-    
-    if (!isVariable(arrayName)) {
-        error("Неверное имя массива: " + arrayName);
-    }
+    ArrayStorage& array = arrays2D[ins.a];
+    const std::string& arrayName = program.arrays[ins.a];
     
     // Проверяем границы массива
-    if (arrays2D.find(arrayName) == arrays2D.end()) {
+    if (!array.allocated) {
         error("Двумерный массив не инициализирован: " + arrayName);
     }
     
-    if (row < 0 || row >= static_cast<int>(arrays2D[arrayName].size()) ||
-        col < 0 || col >= static_cast<int>(arrays2D[arrayName][row].size())) {
+    if (row < 0 || row >= array.rows || col < 0 || col >= array.cols) {
         error("Индексы массива вне границ: " + std::to_string(row) + ", " + std::to_string(col));
     }
     
     // Запрашиваем ввод от пользователя
-    std::cout << "\n  Введите значение для " << arrayName << "[" << row << "][" << col << "]: ";
-    double value;
-    std::cin >> value;
+    double value = 0.0;
+    if (input != nullptr) {
+        // Неинтерактивный режим: без приглашения
+        if (!input->next(value)) {
+            error("Входные данные исчерпаны");
+        }
+    } else {
+        output->flush();
+        std::cout << "\n  Введите значение для " << arrayName << "[" << row << "][" << col << "]: ";
+        std::cin >> value;
+    }
     
     // Записываем значение в массив
-    arrays2D[arrayName][row][col] = Value(value);
-    std::cout << "  Прочитано в " << arrayName << "[" << row << "][" << col << "] = " << value;
-} 
\ No newline at end of file
+    array.store(static_cast<size_t>(row) * array.cols + col, Value(value));
+    trace<Trace>("  Прочитано в ", arrayName, "[", row, "][", col, "] = ", value);
+}
@@ -3,93 +3,87 @@
 
 #include <string>
 #include <vector>
-#include <stack>
-#include <unordered_map>
+#include <cstdint>
 #include <iostream>
+#include "ops_value.h"
+#include "ops_program.h"
+#include "ops_output.h"
+#include "ops_input.h"
+#include "ops_jit.h"
+#include "ops_profile.h"
 
-// Тип данных для значений
-enum class ValueType {
-    INT,
-    DOUBLE
+// Режим выполнения интерпретатора
+enum class ExecutionMode {
+    QUIET,    // только вывод программы (w), без трассировки и итогового состояния
+    SUMMARY,  // без трассировки команд, с итоговым состоянием
+    TRACE     // трассировка каждой команды и итоговое состояние
 };
 
-// Структура для хранения значения с типом
-struct Value {
-    ValueType type;
-    union {
-        int intValue;
-        double doubleValue;
-    };
-    
-    Value() : type(ValueType::INT), intValue(0) {}
-    Value(int val) : type(ValueType::INT), intValue(val) {}
-    Value(double val) : type(ValueType::DOUBLE), doubleValue(val) {}
-    
-    // Проверка типа
-    bool isInt() const { return type == ValueType::INT; }
-    bool isDouble() const { return type == ValueType::DOUBLE; }
-    
-    // Преобразование в int (по умолчанию)
-    int asInt() const {
-        return type == ValueType::INT ? intValue : static_cast<int>(doubleValue);
-    }
-    
-    // Преобразование в double
-    double asDouble() const {
-        return type == ValueType::DOUBLE ? doubleValue : static_cast<double>(intValue);
-    }
-    
-    // Строковое представление
-    std::string toString() const {
-        if (type == ValueType::INT) {
-            return std::to_string(intValue);
-        } else {
-            return std::to_string(doubleValue);
-        }
-    }
-    
-    // Арифметические операции
-    Value operator+(const Value& other) const {
-        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
-            return Value(asDouble() + other.asDouble());
+// Ядро основного цикла (трассировка всегда выполняется ядром switch)
+enum class DispatchMode {
+    SWITCH,   // переносимый цикл со switch по коду операции
+    THREADED  // прямая шитая диспетчеризация (computed goto, сборка с OPS_THREADED_DISPATCH)
+};
+
+// Дескриптор массива: размеры и непрерывный буфер элементов в родном типе
+// объявления (int → int32_t, float/double → double, char → uint8_t);
+// в Value и обратно элемент преобразуется только при чтении и записи
+// (двумерный массив хранится по строкам: [row][col] → элемент row * cols + col)
+struct ArrayStorage {
+    bool allocated = false;
+    int rows = 0;                 // число строк (для одномерного - размер)
+    int cols = 1;                 // число столбцов (для одномерного - 1)
+    DataType elementType = DataType::INT;
+    std::vector<int32_t> ints;    // элементы int
+    std::vector<double> doubles;  // элементы float и double
+    std::vector<uint8_t> chars;   // элементы char
+    
+    // Выделить count обнулённых элементов типа type (прежний буфер освобождается)
+    void allocate(DataType type, size_t count) {
+        elementType = type;
+        ints.clear();
+        doubles.clear();
+        chars.clear();
+        ints.shrink_to_fit();
+        doubles.shrink_to_fit();
+        chars.shrink_to_fit();
+        if (type == DataType::INT) {
+            ints.assign(count, 0);
+        } else if (type == DataType::CHAR) {
+            chars.assign(count, 0);
         } else {
-            return Value(intValue + other.intValue);
+            doubles.assign(count, 0.0);
         }
+        allocated = true;
     }
     
-    Value operator-(const Value& other) const {
-        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
-            return Value(asDouble() - other.asDouble());
-        } else {
-            return Value(intValue - other.intValue);
-        }
+    size_t size() const {
+        if (elementType == DataType::INT) return ints.size();
+        if (elementType == DataType::CHAR) return chars.size();
+        return doubles.size();
     }
     
-    Value operator*(const Value& other) const {
-        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
-            return Value(asDouble() * other.asDouble());
-        } else {
-            return Value(intValue * other.intValue);
-        }
+    Value load(size_t index) const {
+        if (elementType == DataType::INT) return Value(static_cast<int>(ints[index]));
+        if (elementType == DataType::CHAR) return Value(static_cast<int>(chars[index]));
+        return Value(doubles[index]);
     }
     
-    Value operator/(const Value& other) const {
-        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
-            return Value(asDouble() / other.asDouble());
+    void store(size_t index, const Value& value) {
+        if (elementType == DataType::INT) {
+            ints[index] = static_cast<int32_t>(value.asInt());
+        } else if (elementType == DataType::CHAR) {
+            chars[index] = static_cast<uint8_t>(value.asInt());
         } else {
-            return Value(intValue / other.intValue);
+            doubles[index] = value.asDouble();
         }
     }
-    
-    // Оператор вывода
-    friend std::ostream& operator<<(std::ostream& os, const Value& val) {
-        if (val.type == ValueType::INT) {
-            os << val.intValue;
-        } else {
-            os << val.doubleValue;
-        }
-        return os;
-    }
+};
+
+// Значения переменной цикла со счётчиком за все итерации (для охраны границ)
+struct LoopRange {
+    long long low = 0;
+    long long high = 0;
 };
 
 // Интерпретатор ОПС (Обратной Польской записи)
@@ -100,6 +94,37 @@ public:
     // Выполнить последовательность команд ОПС
     void execute(const std::vector<std::string>& opsCommands);
     
+    // Выполнить загруженную программу ОПС
+    void execute(const OPSProgram& opsProgram);
+    
+    // Выбрать режим выполнения (по умолчанию TRACE)
+    void setExecutionMode(ExecutionMode executionMode);
+    
+    // Выбрать ядро основного цикла (THREADED без поддержки в сборке - switch)
+    void setDispatchMode(DispatchMode dispatchMode);
+    
+    // Собрано ли ядро с прямой шитой диспетчеризацией
+    static bool threadedDispatchAvailable();
+    
+    // Переводить горячие циклы в машинный код (без поддержки в сборке - только интерпретатор)
+    void setJitEnabled(bool enabled);
+    
+    // Собран ли JIT-компилятор циклов для этой платформы
+    static bool jitAvailable();
+    
+    // Сколько обратных переходов цикл выполняет интерпретатор, прежде чем он
+    // переводится в машинный код (0 - при первом обратном переходе)
+    void setTierThreshold(uint64_t backEdges);
+    
+    // Собирать профиль (выполнения блоков ядром switch) и выводить его после выполнения
+    void setStatsEnabled(bool enabled);
+    
+    // Назначить приёмник вывода команды w (nullptr - буферизованный stdout)
+    void setOutputSink(OutputSink* sink);
+    
+    // Назначить неинтерактивный источник ввода (nullptr - приглашения и std::cin)
+    void setInputSource(InputSource* source);
+    
     // Установить значение переменной (для тестирования)
     void setVariable(const std::string& name, int value);
     void setVariable(const std::string& name, double value);
@@ -115,49 +140,85 @@ public:
     void reset();
 
 private:
-    std::stack<Value> operandStack;                    // Стек операндов (теперь Value)
-    std::unordered_map<std::string, Value> variables;  // Таблица переменных (теперь Value)
-    std::unordered_map<std::string, std::vector<Value>> arrays; // Таблица одномерных массивов
-    std::unordered_map<std::string, std::vector<std::vector<Value>>> arrays2D; // Таблица двумерных массивов
-    std::unordered_map<std::string, size_t> labels;  // Таблица меток
-    std::vector<std::string> commands;               // Команды ОПС
-    size_t programCounter;                           // Счетчик команд
-    bool running;                                    // Флаг выполнения
-    
-    // Вспомогательные методы
-    void parseLabels();                              // Найти все метки в коде
-    bool isNumber(const std::string& str) const;     // Проверка на число
-    bool isDoubleNumber(const std::string& str) const; // Проверка на число с плавающей точкой
-    bool isVariable(const std::string& str) const;   // Проверка на переменную
-    bool isOperator(const std::string& str) const;   // Проверка на оператор
-    bool isCommand(const std::string& str) const;    // Проверка на команду
+    std::vector<Value> operandStack;                                     // Стек операндов: непрерывный буфер на program.maxStackDepth ячеек
+    Value* stackTop;                                                     // Первая свободная ячейка стека
+    std::vector<Value> frame;                                            // Кадр переменных: ячейка = номер в program.variables
+    std::vector<ArrayStorage> arrays;                                    // Одномерные массивы (индекс = номер в program.arrays)
+    std::vector<ArrayStorage> arrays2D;                                  // Двумерные массивы (индекс = номер в program.arrays)
+    std::vector<long long> loopCounters;                                 // Оставшиеся итерации циклов LOOP_INIT / LOOP_NEXT
+    std::vector<LoopRange> loopRanges;                                   // Диапазоны переменных циклов (задаёт LOOP_INIT)
+    OPSProgram program;                                                  // Декодированная программа ОПС
+    size_t programCounter;                                               // Счетчик команд
+    bool running;                                                        // Флаг выполнения
+    ExecutionMode mode;                                                  // Режим выполнения
+    DispatchMode dispatch;                                               // Ядро основного цикла
+    BufferedOutputSink defaultOutput;                                    // Приёмник вывода по умолчанию
+    OutputSink* output;                                                  // Текущий приёмник вывода (w)
+    InputSource* input;                                                  // Источник ввода (nullptr - интерактивный)
+    bool jitEnabled;                                                     // Переводить циклы в машинный код
+    OPSJit jit;                                                          // Машинный код циклов (без трассировки)
+    std::vector<JitArray> nativeArrays;                                  // Таблица массивов для машинного кода цикла
+    OPSProfile profile;                                                  // Счётчики циклов и блоков, уровни циклов
+    uint64_t tierThreshold;                                              // Порог перевода цикла в машинный код
+    bool statsEnabled;                                                   // Собирать и выводить профиль
+    
+    // Основной цикл выполнения с политикой трассировки (TraceOn / TraceOff /
+    // ProfileOn - без трассировки, со счётчиками выполнения команд)
+    template <class Trace> void run();
+    
+#ifdef OPS_THREADED_DISPATCH
+    // Ядро с прямой шитой диспетчеризацией: каждый обработчик сам переходит
+    // по адресу обработчика следующей команды (без трассировки)
+    void runThreaded();
+#endif
+    
+    // Обратный переход на начало цикла header: учесть его и, если цикл
+    // горячий, выполнить машинным кодом (при достижении порога -
+    // скомпилировать). Возвращает команду, с которой продолжает интерпретатор
+    // (header - цикл остаётся интерпретатору)
+    size_t backEdge(size_t header);
+    
+    // Замена интерпретатора машинным кодом на начале скомпилированного цикла
+    // с текущими значениями переменных (header - вход отклонён)
+    size_t enterNative(LoopProfile& loop);
     
     // Выполнение операций
-    void executeArithmetic(const std::string& op);   // Арифметические операции
-    void executeComparison(const std::string& op);   // Операции сравнения
-    void executeAssignment();                        // Присваивание (:=)
-    void executeRead();                              // Чтение (r)
-    void executeWrite();                             // Запись (w)
-    void executeArrayAlloc();                        // Выделение памяти массива (alloc_array)
-    void executeArrayGet();                          // Получение элемента массива (array_get)
-    void executeArraySet();                          // Установка элемента массива (array_set)
-    void executeArrayRead();                         // Чтение в элемент массива (array_read)
-    void executeArrayRead2D();                       // Чтение в элемент 2D массива (array_read_2d)
-    void executeArrayAlloc2D();                      // Выделение памяти 2D массива (alloc_array_2d)
-    void executeArrayGet2D();                        // Получение элемента 2D массива (array_get_2d)
-    void executeArraySet2D();                        // Установка элемента 2D массива (array_set_2d)
-    void executeDeclare();                           // Объявление переменной (declare)
-    void executeDeclareAssign();                     // Объявление переменной с типизированным присваиванием (declare_assign)
-    void executeJump(const std::string& label);      // Безусловный переход (j)
-    void executeConditionalJump(const std::string& label); // Условный переход (jf)
+    void executeArithmetic(OpCode op);                                   // Арифметические операции
+    void executeComparison(OpCode op);                                   // Операции сравнения
+    template <class Op> void applyInt(Op op);                            // Арифметика над доказанно целыми операндами
+    template <class Op> void applyDouble(Op op);                         // Арифметика над доказанно вещественными операндами
+    template <class Op> void compareInt(Op op);                          // Сравнение доказанно целых
+    template <class Op> void compareDouble(Op op);                       // Сравнение доказанно вещественных
+    template <class Trace> void executeAssignment(const Instruction& ins); // Присваивание (:=)
+    template <class Trace> void executeRead(const Instruction& ins);     // Чтение (r)
+    template <class Trace> void executeWrite();                          // Запись (w)
+    template <class Trace> void executeArrayAlloc(const Instruction& ins); // Выделение памяти массива (alloc_array)
+    template <class Trace> void executeArrayGet(const Instruction& ins); // Получение элемента массива (array_get)
+    template <class Trace> void executeArraySet(const Instruction& ins); // Установка элемента массива (array_set)
+    template <class Trace> void loadElement(int arrayIndex, int index);  // Элемент массива в стек (с проверкой границ)
+    template <class Trace> void executeIncrement(const Instruction& ins); // Суперкоманда INC_VAR
+    template <class Trace> bool executeLoopInit(const Instruction& ins);  // Вход в цикл со счётчиком (false - ни одной итерации)
+    template <class Trace> bool executeLoopNext(const Instruction& ins);  // Шаг цикла со счётчиком (true - следующая итерация)
+    template <class Trace> bool executeGuard(const Instruction& ins);     // Охрана границ перед циклом (false - проверяемая копия)
+    template <class Trace> void loadElementUnchecked(int arrayIndex, int index); // Элемент массива в стек (границы доказаны)
+    template <class Trace> void executeArraySetUnchecked(const Instruction& ins); // array_set без проверки границ
+    template <class Trace> void executeArrayGet2DUnchecked(const Instruction& ins); // array_get_2d без проверки границ
+    template <class Trace> void executeArraySet2DUnchecked(const Instruction& ins); // array_set_2d без проверки границ
+    template <class Trace> void executeArrayRead(const Instruction& ins); // Чтение в элемент массива (array_read)
+    template <class Trace> void executeArrayRead2D(const Instruction& ins); // Чтение в элемент 2D массива (array_read_2d)
+    template <class Trace> void executeArrayAlloc2D(const Instruction& ins); // Выделение памяти 2D массива (alloc_array_2d)
+    template <class Trace> void executeArrayGet2D(const Instruction& ins); // Получение элемента 2D массива (array_get_2d)
+    template <class Trace> void executeArraySet2D(const Instruction& ins); // Установка элемента 2D массива (array_set_2d)
+    template <class Trace> void executeDeclare(const Instruction& ins);  // Объявление переменной (declare)
+    template <class Trace> void executeDeclareAssign(const Instruction& ins); // Объявление переменной с типизированным присваиванием (declare_assign)
+    void executeJump(const Instruction& ins);                            // Безусловный переход (j)
+    template <class Trace> void executeConditionalJump(const Instruction& ins); // Условный переход (jf)
     
     // Работа со стеком
-    Value popStack();                                // Извлечь значение из стека
-    void pushStack(const Value& value);              // Поместить значение в стек
-    void error(const std::string& message) const;    // Обработка ошибок
-    
-    // Вспомогательные методы для массивов
-    bool isArrayName(const std::string& name) const; // Проверка на имя массива
+    Value popStack();                                                    // Извлечь значение из стека
+    void pushStack(const Value& value);                                  // Поместить значение в стек
+    void error(const std::string& message) const;                        // Обработка ошибок
+    size_t slotFor(const std::string& name);                             // Номер ячейки переменной (создаётся при отсутствии)
 };
 
 #endif // OPS_INTERPRETER_H 
\ No newline at end of file
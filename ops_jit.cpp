@@ -0,0 +1,1273 @@
+#include "ops_jit.h"
+#include "ops_interpreter.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(OPS_JIT) && defined(__x86_64__) && defined(__linux__)
+#define OPS_JIT_NATIVE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef OPS_JIT_NATIVE
+namespace {
+
+// Регистры общего назначения и xmm нумеруются кодами x86-64 (0-15)
+enum Register {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+const int XMM6 = 6;
+const int XMM7 = 7;
+
+// Условия jcc / setcc (младшие 4 бита кода операции)
+enum Condition : uint8_t {
+    BELOW_EQUAL_UNSIGNED = 0x6,  // jbe
+    ABOVE_EQUAL = 0x3,           // jae (беззнаковое)
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    ABOVE = 0x7,
+    PARITY = 0xA,
+    NOT_PARITY = 0xB,
+    LESS = 0xC,
+    GREATER_EQUAL = 0xD,
+    LESS_EQUAL = 0xE,
+    GREATER = 0xF
+};
+
+// Расширение кода операции в поле reg для групп 0x81 / 0xF7 / 0xFF
+const int EXT_ADD = 0;
+const int EXT_SUB = 5;
+const int EXT_DEC = 1;
+const int EXT_IDIV = 7;
+
+// Операнд в памяти: [base + index * scale + disp]
+struct Mem {
+    int base;
+    int index;
+    int scale;
+    int32_t disp;
+};
+
+Mem at(int base, int32_t disp) {
+    return Mem{base, -1, 1, disp};
+}
+
+Mem at(int base, int index, int scale, int32_t disp) {
+    return Mem{base, index, scale, disp};
+}
+
+// Кодировщик подмножества команд x86-64 (целые 32/64 бита и скалярный SSE2).
+// Адрес в памяти всегда кодируется с 32-битным смещением - проще и без особых
+// случаев для rbp / r13
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    int newLabel() {
+        labels.push_back(-1);
+        return static_cast<int>(labels.size() - 1);
+    }
+
+    void bind(int label) { labels[label] = static_cast<long>(code.size()); }
+
+    void jmp(int label) {
+        byte(0xE9);
+        fixup(label);
+    }
+
+    void jcc(Condition cc, int label) {
+        byte(0x0F);
+        byte(0x80 | cc);
+        fixup(label);
+    }
+
+    // Подставить смещения переходов (false - есть непривязанная метка)
+    bool resolve() {
+        for (const auto& use : fixups) {
+            if (labels[use.second] < 0) return false;
+            int32_t rel = static_cast<int32_t>(labels[use.second] - static_cast<long>(use.first + 4));
+            std::memcpy(&code[use.first], &rel, sizeof(rel));
+        }
+        return true;
+    }
+
+    // Пересылки
+    void mov32(int dst, int src) { rr(0, false, {0x8B}, dst, src); }
+    void mov64(int dst, int src) { rr(0, true, {0x8B}, dst, src); }
+    void load32(int dst, const Mem& m) { rm(0, false, {0x8B}, dst, m); }
+    void load64(int dst, const Mem& m) { rm(0, true, {0x8B}, dst, m); }
+    void store32(const Mem& m, int src) { rm(0, false, {0x89}, src, m); }
+    void store64(const Mem& m, int src) { rm(0, true, {0x89}, src, m); }
+    void storeByte(const Mem& m, int src) { rm(0, false, {0x88}, src, m); }  // только al..bl
+    void loadByte(int dst, const Mem& m) { rm(0, false, {0x0F, 0xB6}, dst, m); }
+    void movzxByte(int dst, int src) { rr(0, false, {0x0F, 0xB6}, dst, src); } // только al..bl
+    void movsxd(int dst, int src) { rr(0, true, {0x63}, dst, src); }
+    void storeImm32(const Mem& m, int32_t imm) { rm(0, false, {0xC7}, 0, m); dword(imm); }
+    void storeImm64(const Mem& m, int32_t imm) { rm(0, true, {0xC7}, 0, m); dword(imm); }
+
+    void movImm32(int dst, int32_t imm) {
+        if (dst & 8) byte(0x41);
+        byte(0xB8 | (dst & 7));
+        dword(imm);
+    }
+
+    void movImm64(int dst, uint64_t imm) {
+        byte(0x48 | ((dst & 8) ? 1 : 0));
+        byte(0xB8 | (dst & 7));
+        for (int i = 0; i < 8; ++i) byte(static_cast<uint8_t>(imm >> (8 * i)));
+    }
+
+    // Целая арифметика
+    void add32(int dst, int src) { rr(0, false, {0x01}, src, dst); }
+    void sub32(int dst, int src) { rr(0, false, {0x29}, src, dst); }
+    void and32(int dst, int src) { rr(0, false, {0x21}, src, dst); }
+    void cmp32(int a, int b) { rr(0, false, {0x39}, b, a); }
+    void test32(int a, int b) { rr(0, false, {0x85}, b, a); }
+    void imul32(int dst, int src) { rr(0, false, {0x0F, 0xAF}, dst, src); }
+    void add64(int dst, int src) { rr(0, true, {0x01}, src, dst); }
+    void sub64(int dst, int src) { rr(0, true, {0x29}, src, dst); }
+    void or64(int dst, int src) { rr(0, true, {0x09}, src, dst); }
+    void test64(int a, int b) { rr(0, true, {0x85}, b, a); }
+    void cmp64(int reg, const Mem& m) { rm(0, true, {0x3B}, reg, m); }
+    void cmp64(int a, int b) { rr(0, true, {0x39}, b, a); }
+    void imul64(int reg, const Mem& m) { rm(0, true, {0x0F, 0xAF}, reg, m); }
+    void imul64(int dst, int src, int32_t imm) { rr(0, true, {0x69}, dst, src); dword(imm); }
+    void aluImm(int ext, bool wide, int dst, int32_t imm) { rr(0, wide, {0x81}, ext, dst); dword(imm); }
+    void aluImm(int ext, bool wide, const Mem& m, int32_t imm) { rm(0, wide, {0x81}, ext, m); dword(imm); }
+    void cmpImm32(int a, int32_t imm) { aluImm(7, false, a, imm); }
+    void decMem64(const Mem& m) { rm(0, true, {0xFF}, EXT_DEC, m); }
+    void cdq() { byte(0x99); }
+    void cqo() { byte(0x48); byte(0x99); }
+    void idiv32(int src) { rr(0, false, {0xF7}, EXT_IDIV, src); }
+    void idiv64(int src) { rr(0, true, {0xF7}, EXT_IDIV, src); }
+    void setcc(Condition cc, int dst) { rr(0, false, {0x0F, static_cast<uint8_t>(0x90 | cc)}, 0, dst); } // только al..bl
+
+    // Скалярный SSE2
+    void movsdLoad(int x, const Mem& m) { rm(0xF2, false, {0x0F, 0x10}, x, m); }
+    void movsdStore(const Mem& m, int x) { rm(0xF2, false, {0x0F, 0x11}, x, m); }
+    void movapd(int dst, int src) { rr(0x66, false, {0x0F, 0x28}, dst, src); }
+    void addsd(int dst, int src) { rr(0xF2, false, {0x0F, 0x58}, dst, src); }
+    void mulsd(int dst, int src) { rr(0xF2, false, {0x0F, 0x59}, dst, src); }
+    void subsd(int dst, int src) { rr(0xF2, false, {0x0F, 0x5C}, dst, src); }
+    void divsd(int dst, int src) { rr(0xF2, false, {0x0F, 0x5E}, dst, src); }
+    void ucomisd(int a, int b) { rr(0x66, false, {0x0F, 0x2E}, a, b); }
+    void cvtsi2sd(int x, int src) { rr(0xF2, false, {0x0F, 0x2A}, x, src); }
+    void cvttsd2si(int dst, int x) { rr(0xF2, false, {0x0F, 0x2C}, dst, x); }
+    void movq(int x, int src) { rr(0x66, true, {0x0F, 0x6E}, x, src); }
+    void xorpd(int x) { rr(0x66, false, {0x0F, 0x57}, x, x); }
+
+    // Пролог и эпилог
+    void push(int r) {
+        if (r & 8) byte(0x41);
+        byte(0x50 | (r & 7));
+    }
+
+    void pop(int r) {
+        if (r & 8) byte(0x41);
+        byte(0x58 | (r & 7));
+    }
+
+    void ret() { byte(0xC3); }
+
+private:
+    std::vector<long> labels;                    // позиция метки в коде (-1 - не привязана)
+    std::vector<std::pair<size_t, int>> fixups;  // место rel32 → метка
+
+    void byte(uint8_t value) { code.push_back(value); }
+
+    void dword(int32_t value) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+    }
+
+    void fixup(int label) {
+        fixups.emplace_back(code.size(), label);
+        dword(0);
+    }
+
+    // [префикс] [REX] код ModRM: регистр - регистр
+    void rr(uint8_t prefix, bool wide, std::initializer_list<uint8_t> opcode, int reg, int rmReg) {
+        if (prefix != 0) byte(prefix);
+        uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rmReg & 8) ? 1 : 0);
+        if (rex != 0x40) byte(rex);
+        for (uint8_t op : opcode) byte(op);
+        byte(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rmReg & 7)));
+    }
+
+    // [префикс] [REX] код ModRM [SIB] disp32: регистр - память
+    void rm(uint8_t prefix, bool wide, std::initializer_list<uint8_t> opcode, int reg, const Mem& m) {
+        if (prefix != 0) byte(prefix);
+        bool hasIndex = m.index >= 0;
+        uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0)
+                    | ((hasIndex && (m.index & 8)) ? 2 : 0) | ((m.base & 8) ? 1 : 0);
+        if (rex != 0x40) byte(rex);
+        for (uint8_t op : opcode) byte(op);
+        bool sib = hasIndex || (m.base & 7) == RSP;
+        byte(static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | (sib ? 4 : (m.base & 7))));
+        if (sib) {
+            int scaleBits = m.scale == 8 ? 3 : m.scale == 4 ? 2 : m.scale == 2 ? 1 : 0;
+            int index = hasIndex ? (m.index & 7) : RSP;
+            byte(static_cast<uint8_t>((scaleBits << 6) | (index << 3) | (m.base & 7)));
+        }
+        dword(m.disp);
+    }
+};
+
+// Раскладка значения в памяти (кадр, стек операндов)
+const int32_t VALUE_SIZE = static_cast<int32_t>(sizeof(Value));
+#ifdef OPS_NAN_BOXING
+const int32_t PAYLOAD = 0;
+#else
+const int32_t TAG = static_cast<int32_t>(offsetof(Value, type));
+const int32_t PAYLOAD = static_cast<int32_t>(offsetof(Value, intValue));
+#endif
+
+const int32_t CONTEXT_FRAME = static_cast<int32_t>(offsetof(JitContext, frame));
+const int32_t CONTEXT_STACK = static_cast<int32_t>(offsetof(JitContext, stack));
+const int32_t CONTEXT_COUNTERS = static_cast<int32_t>(offsetof(JitContext, loopCounters));
+const int32_t CONTEXT_RANGES = static_cast<int32_t>(offsetof(JitContext, loopRanges));
+const int32_t CONTEXT_ARRAYS = static_cast<int32_t>(offsetof(JitContext, arrays));
+const int32_t CONTEXT_RESUME = static_cast<int32_t>(offsetof(JitContext, resumePc));
+const int32_t CONTEXT_DEPTH = static_cast<int32_t>(offsetof(JitContext, stackDepth));
+
+const int32_t ARRAY_SIZE = static_cast<int32_t>(sizeof(JitArray));
+const int32_t ARRAY_DATA = static_cast<int32_t>(offsetof(JitArray, data));
+const int32_t ARRAY_LENGTH = static_cast<int32_t>(offsetof(JitArray, size));
+const int32_t ARRAY_ROWS = static_cast<int32_t>(offsetof(JitArray, rows));
+const int32_t ARRAY_COLS = static_cast<int32_t>(offsetof(JitArray, cols));
+
+const int32_t RANGE_SIZE = static_cast<int32_t>(sizeof(LoopRange));
+const int32_t RANGE_LOW = static_cast<int32_t>(offsetof(LoopRange, low));
+const int32_t RANGE_HIGH = static_cast<int32_t>(offsetof(LoopRange, high));
+
+// Распределение регистров: rbx - кадр, rbp - контекст, rax / rcx / rdx и
+// xmm6 / xmm7 - рабочие; ячейка стека глубины d - INT_STACK[d] или xmm d
+const int FRAME = RBX;
+const int CONTEXT = RBP;
+const int INT_STACK[] = {RSI, RDI, R8, R9, R10, R11};
+const int INT_VARIABLES[] = {R12, R13, R14, R15};
+const int DOUBLE_VARIABLES[] = {8, 9, 10, 11, 12, 13, 14, 15};
+const size_t MAX_DEPTH = sizeof(INT_STACK) / sizeof(INT_STACK[0]);
+const int CALLEE_SAVED[] = {RBX, RBP, R12, R13, R14, R15};
+
+bool typed(StaticType type) {
+    return type == StaticType::INT || type == StaticType::DOUBLE;
+}
+
+StaticType declaredType(DataType type) {
+    return (type == DataType::DOUBLE || type == DataType::FLOAT) ? StaticType::DOUBLE : StaticType::INT;
+}
+
+// Приведение специализированных и обобщённых команд к базовой операции
+OpCode arithmeticBase(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: case OpCode::ADD_I32: case OpCode::ADD_F64: return OpCode::ADD;
+        case OpCode::SUB: case OpCode::SUB_I32: case OpCode::SUB_F64: return OpCode::SUB;
+        case OpCode::MUL: case OpCode::MUL_I32: case OpCode::MUL_F64: return OpCode::MUL;
+        case OpCode::DIV: case OpCode::DIV_I32: case OpCode::DIV_F64: return OpCode::DIV;
+        default: return OpCode::NOP;
+    }
+}
+
+OpCode comparisonBase(OpCode op) {
+    switch (op) {
+        case OpCode::GT: case OpCode::GT_I32: case OpCode::GT_F64: return OpCode::GT;
+        case OpCode::LT: case OpCode::LT_I32: case OpCode::LT_F64: return OpCode::LT;
+        case OpCode::EQ: case OpCode::EQ_I32: case OpCode::EQ_F64: return OpCode::EQ;
+        default: return OpCode::NOP;
+    }
+}
+
+// Перевод одного цикла [begin, end] в машинный код
+class LoopCompiler {
+public:
+    LoopCompiler(const OPSProgram& program, const OPSTypeInference& typing, size_t begin, size_t end,
+                 const std::vector<ArrayStorage>& arrays, const std::vector<ArrayStorage>& arrays2D)
+        : program(program), typing(typing), begin(begin), end(end), arrays(arrays), arrays2D(arrays2D),
+          uses(nullptr), pc(begin) {}
+
+    // false - начало цикла не переводится в машинный код
+    bool compile(JitLoop& loop);
+
+    const std::vector<uint8_t>& code() const { return as.code; }
+
+private:
+    // Выход в интерпретатор: команда продолжения и типы ячеек стека в регистрах
+    struct Exit {
+        int label;
+        size_t pc;
+        std::vector<StaticType> stack;
+    };
+
+    const OPSProgram& program;
+    const OPSTypeInference& typing;
+    size_t begin;
+    size_t end;
+    const std::vector<ArrayStorage>& arrays;
+    const std::vector<ArrayStorage>& arrays2D;
+    std::vector<JitArrayUse>* uses;
+
+    Assembler as;
+    std::vector<StaticType> variableTypes;  // тип переменной во всём цикле (DYNAMIC - меняется)
+    std::vector<int> variableRegisters;     // регистр переменной (-1 - ячейка кадра)
+    std::vector<int> labels;                // метка команды (-1 - команда выполняется интерпретатором)
+    std::vector<int> arraySlots;            // номер в таблице массивов (-1 - не используется)
+    std::vector<int> arraySlots2D;
+    std::vector<Exit> exits;
+    std::vector<StaticType> stack;          // типы ячеек стека в текущей точке кода
+    size_t pc;
+    bool fallsThrough = true;
+
+    void assignVariables();
+    bool enterable(size_t target) const;
+    int target(size_t pc);
+    int exitTo(size_t pc);
+    void transfer(Condition cc, size_t pc);
+    void jumpTo(size_t pc);
+    bool emit(const Instruction& ins);
+
+    // Ячейки стека и переменные
+    int gpr(size_t slot) const { return INT_STACK[slot]; }
+    int xmm(size_t slot) const { return static_cast<int>(slot); }
+    Mem variable(int index, int32_t offset) const { return at(FRAME, index * VALUE_SIZE + offset); }
+    void loadInt(int dst, int index);
+    void loadDouble(int x, int index);
+    void storeInt(int index, int src);
+    void storeDouble(int index, int x);
+    void writeInt(const Mem& value, int src);
+    void writeDouble(const Mem& value, int x);
+    void loadConstant(int x, double value);
+    void toDouble(size_t slot);
+
+    // Массивы
+    int arraySlot(int index, bool twoDimensional);
+    DataType elementType(int slot) const { return (*uses)[slot].elementType; }
+    void indexFromSlot(int dst, size_t slot);
+    bool indexFromVariable(int dst, int index);
+    void address(int slot, bool checked);
+    void address2D(int slot, bool checked);
+    void loadElement(DataType type, size_t slot);
+    void storeElement(DataType type, size_t slot);
+
+    // Команды
+    bool emitArithmetic(OpCode op);
+    bool emitComparison(OpCode op);
+    bool emitCompareJump(const Instruction& ins);
+    bool emitLoopInit(const Instruction& ins);
+    bool emitLoopNext(const Instruction& ins);
+    bool emitGuard(const Instruction& ins);
+    bool emitArrayGet(const Instruction& ins, bool checked);
+    bool emitArraySet(const Instruction& ins, bool checked);
+    bool emitArrayGet2D(const Instruction& ins, bool checked);
+    bool emitArraySet2D(const Instruction& ins, bool checked);
+    bool emitLoadElement(const Instruction& ins, bool checked, bool tee);
+};
+
+// Переменные, к которым обращаются команды цикла: тип должен совпадать во всех
+// достижимых командах цикла; самые используемые получают регистры
+void LoopCompiler::assignVariables() {
+    const size_t count = program.variables.size();
+    variableTypes.assign(count, StaticType::NONE);
+    variableRegisters.assign(count, -1);
+    std::vector<size_t> weight(count, 0);
+
+    for (size_t at = begin; at <= end; ++at) {
+        const Instruction& ins = program.code[at];
+        int used[2] = {-1, -1};
+        switch (ins.op) {
+            case OpCode::PUSH_VAR: case OpCode::STORE: case OpCode::TEE:
+            case OpCode::DECLARE: case OpCode::DECLARE_ASSIGN: case OpCode::INC_VAR:
+                used[0] = ins.a;
+                break;
+            case OpCode::CMP_VAR_VAR_JF:
+                used[0] = ins.b;
+                used[1] = ins.c;
+                break;
+            case OpCode::CMP_VAR_CONST_JF: case OpCode::LOOP_INIT: case OpCode::LOOP_NEXT:
+            case OpCode::LOAD_ELEM_VAR_INDEX: case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+                used[0] = ins.b;
+                break;
+            case OpCode::LOAD_ELEM_VAR_INDEX_TEE: case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+                used[0] = ins.b;
+                used[1] = ins.c;
+                break;
+            default:
+                break;
+        }
+        for (int index : used) {
+            if (index < 0) continue;
+            weight[index]++;
+            variableTypes[index] = StaticType::DYNAMIC;
+        }
+    }
+
+    for (size_t v = 0; v < count; ++v) {
+        if (variableTypes[v] == StaticType::NONE) continue;
+        StaticType type = StaticType::NONE;
+        for (size_t at = begin; at <= end && type != StaticType::DYNAMIC; ++at) {
+            if (!typing.reached(at)) continue;
+            StaticType here = typing.variableTypes(at)[v];
+            type = (type == StaticType::NONE || type == here) ? here : StaticType::DYNAMIC;
+        }
+        variableTypes[v] = typed(type) ? type : StaticType::DYNAMIC;
+    }
+
+    std::vector<int> order;
+    for (size_t v = 0; v < count; ++v) {
+        if (typed(variableTypes[v])) order.push_back(static_cast<int>(v));
+    }
+    std::stable_sort(order.begin(), order.end(), [&weight](int a, int b) { return weight[a] > weight[b]; });
+    size_t ints = 0;
+    size_t doubles = 0;
+    for (int v : order) {
+        if (variableTypes[v] == StaticType::INT && ints < sizeof(INT_VARIABLES) / sizeof(int)) {
+            variableRegisters[v] = INT_VARIABLES[ints++];
+        } else if (variableTypes[v] == StaticType::DOUBLE && doubles < sizeof(DOUBLE_VARIABLES) / sizeof(int)) {
+            variableRegisters[v] = DOUBLE_VARIABLES[doubles++];
+        }
+    }
+}
+
+// В команду можно войти машинным кодом: она в цикле, достижима и все ячейки
+// стека на входе имеют доказанный тип
+bool LoopCompiler::enterable(size_t at) const {
+    if (at < begin || at > end || !typing.reached(at)) return false;
+    const std::vector<StaticType>& types = typing.stackTypes(at);
+    if (types.size() > MAX_DEPTH) return false;
+    return std::all_of(types.begin(), types.end(), typed);
+}
+
+// Метка перехода на команду at из текущей точки: код команды, если типы стека
+// совпадают, иначе выход в интерпретатор
+int LoopCompiler::target(size_t at) {
+    if (at >= begin && at <= end && labels[at - begin] >= 0 && typing.stackTypes(at) == stack) {
+        return labels[at - begin];
+    }
+    return exitTo(at);
+}
+
+int LoopCompiler::exitTo(size_t at) {
+    exits.push_back(Exit{as.newLabel(), at, stack});
+    return exits.back().label;
+}
+
+void LoopCompiler::transfer(Condition cc, size_t at) {
+    as.jcc(cc, target(at));
+}
+
+void LoopCompiler::jumpTo(size_t at) {
+    as.jmp(target(at));
+}
+
+void LoopCompiler::loadInt(int dst, int index) {
+    int reg = variableRegisters[index];
+    if (reg < 0) {
+        as.load32(dst, variable(index, PAYLOAD));
+    } else if (reg != dst) {
+        as.mov32(dst, reg);
+    }
+}
+
+void LoopCompiler::loadDouble(int x, int index) {
+    int reg = variableRegisters[index];
+    if (reg < 0) {
+        as.movsdLoad(x, variable(index, PAYLOAD));
+    } else if (reg != x) {
+        as.movapd(x, reg);
+    }
+}
+
+void LoopCompiler::storeInt(int index, int src) {
+    int reg = variableRegisters[index];
+    if (reg < 0) {
+        writeInt(variable(index, 0), src);
+    } else if (reg != src) {
+        as.mov32(reg, src);
+    }
+}
+
+void LoopCompiler::storeDouble(int index, int x) {
+    int reg = variableRegisters[index];
+    if (reg < 0) {
+        writeDouble(variable(index, 0), x);
+    } else if (reg != x) {
+        as.movapd(reg, x);
+    }
+}
+
+// Запись целого в Value по адресу value (портит rax и rdx)
+void LoopCompiler::writeInt(const Mem& value, int src) {
+#ifdef OPS_NAN_BOXING
+    as.mov32(RAX, src);
+    as.movImm64(RDX, Value::INT_TAG);
+    as.or64(RAX, RDX);
+    as.store64(value, RAX);
+#else
+    as.storeImm32(at(value.base, value.disp + TAG), static_cast<int32_t>(ValueType::INT));
+    as.store32(at(value.base, value.disp + PAYLOAD), src);
+#endif
+}
+
+void LoopCompiler::writeDouble(const Mem& value, int x) {
+#ifdef OPS_NAN_BOXING
+    as.movsdStore(value, x);
+#else
+    as.storeImm32(at(value.base, value.disp + TAG), static_cast<int32_t>(ValueType::DOUBLE));
+    as.movsdStore(at(value.base, value.disp + PAYLOAD), x);
+#endif
+}
+
+void LoopCompiler::loadConstant(int x, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0) {
+        as.xorpd(x);
+    } else {
+        as.movImm64(RAX, bits);
+        as.movq(x, RAX);
+    }
+}
+
+// Целая ячейка стека → вещественная той же глубины
+void LoopCompiler::toDouble(size_t slot) {
+    if (stack[slot] == StaticType::INT) {
+        as.cvtsi2sd(xmm(slot), gpr(slot));
+        stack[slot] = StaticType::DOUBLE;
+    }
+}
+
+// Номер массива в таблице машинного кода; тип элементов фиксируется по
+// текущему буферу (-1 - массив ещё не выделен, тип неизвестен)
+int LoopCompiler::arraySlot(int index, bool twoDimensional) {
+    std::vector<int>& slots = twoDimensional ? arraySlots2D : arraySlots;
+    if (slots[index] >= 0) return slots[index];
+    const ArrayStorage& array = twoDimensional ? arrays2D[index] : arrays[index];
+    if (!array.allocated) return -1;
+    JitArrayUse use;
+    use.index = index;
+    use.twoDimensional = twoDimensional;
+    use.elementType = array.elementType;
+    uses->push_back(use);
+    slots[index] = static_cast<int>(uses->size() - 1);
+    return slots[index];
+}
+
+// Индекс из ячейки стека в 64-битный регистр (asInt: double усекается)
+void LoopCompiler::indexFromSlot(int dst, size_t slot) {
+    if (stack[slot] == StaticType::INT) {
+        as.movsxd(dst, gpr(slot));
+    } else {
+        as.cvttsd2si(dst, xmm(slot));
+        as.movsxd(dst, dst);
+    }
+}
+
+bool LoopCompiler::indexFromVariable(int dst, int index) {
+    if (variableTypes[index] == StaticType::INT) {
+        loadInt(dst, index);
+    } else if (variableTypes[index] == StaticType::DOUBLE) {
+        loadDouble(XMM7, index);
+        as.cvttsd2si(dst, XMM7);
+    } else {
+        return false;
+    }
+    as.movsxd(dst, dst);
+    return true;
+}
+
+// Адрес элемента: индекс в rcx, буфер - в rdx. Проверка границ беззнаковым
+// сравнением (отрицательный индекс тоже вне границ); при выходе за границы -
+// выход в интерпретатор до команды, ошибку выдаст он
+void LoopCompiler::address(int slot, bool checked) {
+    as.load64(RDX, at(CONTEXT, CONTEXT_ARRAYS));
+    if (checked) {
+        as.cmp64(RCX, at(RDX, slot * ARRAY_SIZE + ARRAY_LENGTH));
+        as.jcc(ABOVE_EQUAL, exitTo(pc));
+    }
+    as.load64(RDX, at(RDX, slot * ARRAY_SIZE + ARRAY_DATA));
+}
+
+// Строка в rcx, столбец в rax; rcx становится номером элемента row * cols + col
+void LoopCompiler::address2D(int slot, bool checked) {
+    as.load64(RDX, at(CONTEXT, CONTEXT_ARRAYS));
+    if (checked) {
+        int outside = exitTo(pc);
+        as.cmp64(RCX, at(RDX, slot * ARRAY_SIZE + ARRAY_ROWS));
+        as.jcc(ABOVE_EQUAL, outside);
+        as.cmp64(RAX, at(RDX, slot * ARRAY_SIZE + ARRAY_COLS));
+        as.jcc(ABOVE_EQUAL, outside);
+    }
+    as.imul64(RCX, at(RDX, slot * ARRAY_SIZE + ARRAY_COLS));
+    as.add64(RCX, RAX);
+    as.load64(RDX, at(RDX, slot * ARRAY_SIZE + ARRAY_DATA));
+}
+
+// Элемент [rdx + rcx * размер] в ячейку slot (тип ячейки задаёт тип элементов)
+void LoopCompiler::loadElement(DataType type, size_t slot) {
+    if (type == DataType::INT) {
+        as.load32(gpr(slot), at(RDX, RCX, 4, 0));
+        stack[slot] = StaticType::INT;
+    } else if (type == DataType::CHAR) {
+        as.loadByte(gpr(slot), at(RDX, RCX, 1, 0));
+        stack[slot] = StaticType::INT;
+    } else {
+        as.movsdLoad(xmm(slot), at(RDX, RCX, 8, 0));
+        stack[slot] = StaticType::DOUBLE;
+    }
+}
+
+// Значение ячейки slot в элемент [rdx + rcx * размер] с приведением к типу элементов
+void LoopCompiler::storeElement(DataType type, size_t slot) {
+    bool isInt = stack[slot] == StaticType::INT;
+    if (type == DataType::INT || type == DataType::CHAR) {
+        int value = gpr(slot);
+        if (!isInt) {
+            as.cvttsd2si(RAX, xmm(slot));
+            value = RAX;
+        }
+        if (type == DataType::INT) {
+            as.store32(at(RDX, RCX, 4, 0), value);
+        } else {
+            as.mov32(RAX, value);
+            as.storeByte(at(RDX, RCX, 1, 0), RAX);
+        }
+    } else {
+        int value = xmm(slot);
+        if (isInt) {
+            as.cvtsi2sd(XMM7, gpr(slot));
+            value = XMM7;
+        }
+        as.movsdStore(at(RDX, RCX, 8, 0), value);
+    }
+}
+
+bool LoopCompiler::emitArithmetic(OpCode op) {
+    size_t depth = stack.size();
+    size_t left = depth - 2;
+    size_t right = depth - 1;
+
+    if (stack[left] == StaticType::INT && stack[right] == StaticType::INT) {
+        switch (op) {
+            case OpCode::ADD: as.add32(gpr(left), gpr(right)); break;
+            case OpCode::SUB: as.sub32(gpr(left), gpr(right)); break;
+            case OpCode::MUL: as.imul32(gpr(left), gpr(right)); break;
+            default:
+                // Деление на ноль - сообщение об ошибке выдаст интерпретатор
+                as.test32(gpr(right), gpr(right));
+                as.jcc(EQUAL, exitTo(pc));
+                as.mov32(RAX, gpr(left));
+                as.cdq();
+                as.idiv32(gpr(right));
+                as.mov32(gpr(left), RAX);
+                break;
+        }
+        stack.pop_back();
+        return true;
+    }
+
+    // Хотя бы один double - операция в double
+    if (op == OpCode::DIV) {
+        if (stack[right] == StaticType::INT) {
+            as.test32(gpr(right), gpr(right));
+            as.jcc(EQUAL, exitTo(pc));
+        } else {
+            int nonZero = as.newLabel();
+            as.xorpd(XMM7);
+            as.ucomisd(xmm(right), XMM7);
+            as.jcc(PARITY, nonZero);
+            as.jcc(EQUAL, exitTo(pc));
+            as.bind(nonZero);
+        }
+    }
+    toDouble(left);
+    toDouble(right);
+    switch (op) {
+        case OpCode::ADD: as.addsd(xmm(left), xmm(right)); break;
+        case OpCode::SUB: as.subsd(xmm(left), xmm(right)); break;
+        case OpCode::MUL: as.mulsd(xmm(left), xmm(right)); break;
+        default:          as.divsd(xmm(left), xmm(right)); break;
+    }
+    stack.pop_back();
+    return true;
+}
+
+bool LoopCompiler::emitComparison(OpCode op) {
+    size_t depth = stack.size();
+    size_t left = depth - 2;
+    size_t right = depth - 1;
+
+    if (stack[left] == StaticType::INT && stack[right] == StaticType::INT) {
+        as.cmp32(gpr(left), gpr(right));
+        as.setcc(op == OpCode::GT ? GREATER : op == OpCode::LT ? LESS : EQUAL, RAX);
+    } else {
+        // Сравнения с NaN ложны: a > b ⇔ CF = 0 и ZF = 0, a == b ⇔ ZF = 1 и PF = 0
+        toDouble(left);
+        toDouble(right);
+        if (op == OpCode::GT) {
+            as.ucomisd(xmm(left), xmm(right));
+            as.setcc(ABOVE, RAX);
+        } else if (op == OpCode::LT) {
+            as.ucomisd(xmm(right), xmm(left));
+            as.setcc(ABOVE, RAX);
+        } else {
+            as.ucomisd(xmm(left), xmm(right));
+            as.setcc(EQUAL, RAX);
+            as.setcc(NOT_PARITY, RCX);
+            as.and32(RAX, RCX);
+        }
+    }
+    as.movzxByte(gpr(left), RAX);
+    stack.pop_back();
+    stack.back() = StaticType::INT;
+    return true;
+}
+
+// x y < mN jf / x c < mN jf: переход, если сравнение ложно
+bool LoopCompiler::emitCompareJump(const Instruction& ins) {
+    OpCode op = comparisonBase(ins.fused);
+    StaticType left = variableTypes[ins.b];
+    bool constant = ins.op == OpCode::CMP_VAR_CONST_JF;
+    StaticType right = constant ? (ins.imm.isInt() ? StaticType::INT : StaticType::DOUBLE) : variableTypes[ins.c];
+    if (op == OpCode::NOP || !typed(left) || !typed(right)) return false;
+
+    if (left == StaticType::INT && right == StaticType::INT) {
+        loadInt(RAX, ins.b);
+        if (constant) {
+            as.cmpImm32(RAX, ins.imm.asInt());
+        } else {
+            loadInt(RCX, ins.c);
+            as.cmp32(RAX, RCX);
+        }
+        transfer(op == OpCode::GT ? LESS_EQUAL : op == OpCode::LT ? GREATER_EQUAL : NOT_EQUAL, ins.a);
+        return true;
+    }
+
+    if (left == StaticType::INT) {
+        loadInt(RAX, ins.b);
+        as.cvtsi2sd(XMM6, RAX);
+    } else {
+        loadDouble(XMM6, ins.b);
+    }
+    if (constant) {
+        loadConstant(XMM7, ins.imm.asDouble());
+    } else if (right == StaticType::INT) {
+        loadInt(RAX, ins.c);
+        as.cvtsi2sd(XMM7, RAX);
+    } else {
+        loadDouble(XMM7, ins.c);
+    }
+    if (op == OpCode::GT) {
+        as.ucomisd(XMM6, XMM7);
+        transfer(BELOW_EQUAL_UNSIGNED, ins.a);
+    } else if (op == OpCode::LT) {
+        as.ucomisd(XMM7, XMM6);
+        transfer(BELOW_EQUAL_UNSIGNED, ins.a);
+    } else {
+        int otherwise = target(ins.a);
+        as.ucomisd(XMM6, XMM7);
+        as.jcc(NOT_EQUAL, otherwise);
+        as.jcc(PARITY, otherwise);
+    }
+    return true;
+}
+
+// Вход в цикл со счётчиком с целой границей: число итераций и диапазон
+// переменной цикла, как в tripCount интерпретатора
+bool LoopCompiler::emitLoopInit(const Instruction& ins) {
+    size_t bound = stack.size() - 1;
+    int step = ins.imm.asInt();
+    if (stack[bound] != StaticType::INT || variableTypes[ins.b] != StaticType::INT || step == 0
+        || (ins.fused != OpCode::LT && ins.fused != OpCode::GT)) {
+        return false;
+    }
+    long long stride = step < 0 ? -static_cast<long long>(step) : step;
+
+    // Расстояние до границы (64 бита: разность двух int не переполняется)
+    as.movsxd(RAX, gpr(bound));
+    loadInt(RCX, ins.b);
+    as.movsxd(RCX, RCX);
+    if (ins.fused == OpCode::LT) {
+        as.sub64(RAX, RCX);
+    } else {
+        as.sub64(RCX, RAX);
+        as.mov64(RAX, RCX);
+    }
+    stack.pop_back();
+
+    int empty = as.newLabel();
+    int done = as.newLabel();
+    as.test64(RAX, RAX);
+    as.jcc(LESS_EQUAL, empty);
+    if (stride != 1) {
+        as.aluImm(EXT_ADD, true, RAX, static_cast<int32_t>(stride - 1));
+        as.cqo();
+        as.movImm32(RCX, static_cast<int32_t>(stride));
+        as.idiv64(RCX);
+    }
+    as.load64(RDX, at(CONTEXT, CONTEXT_COUNTERS));
+    as.store64(at(RDX, ins.c * 8), RAX);
+
+    // Последнее значение переменной: start + (count - 1) * step
+    as.aluImm(EXT_SUB, true, RAX, 1);
+    as.imul64(RAX, RAX, step);
+    loadInt(RCX, ins.b);
+    as.movsxd(RCX, RCX);
+    as.add64(RAX, RCX);
+    as.load64(RDX, at(CONTEXT, CONTEXT_RANGES));
+    int low = step > 0 ? RCX : RAX;
+    int high = step > 0 ? RAX : RCX;
+    as.store64(at(RDX, ins.c * RANGE_SIZE + RANGE_LOW), low);
+    as.store64(at(RDX, ins.c * RANGE_SIZE + RANGE_HIGH), high);
+    as.jmp(done);
+
+    as.bind(empty);
+    as.load64(RDX, at(CONTEXT, CONTEXT_COUNTERS));
+    as.storeImm64(at(RDX, ins.c * 8), 0);
+    jumpTo(static_cast<size_t>(ins.a));
+    as.bind(done);
+    return true;
+}
+
+bool LoopCompiler::emitLoopNext(const Instruction& ins) {
+    if (variableTypes[ins.b] != StaticType::INT) return false;
+    int reg = variableRegisters[ins.b];
+    if (reg >= 0) {
+        as.aluImm(EXT_ADD, false, reg, ins.imm.asInt());
+    } else {
+        as.aluImm(EXT_ADD, false, variable(ins.b, PAYLOAD), ins.imm.asInt());
+    }
+    as.load64(RAX, at(CONTEXT, CONTEXT_COUNTERS));
+    as.decMem64(at(RAX, ins.c * 8));
+    transfer(GREATER, static_cast<size_t>(ins.a));
+    return true;
+}
+
+// Охрана цикла: range.low + imm >= 0 и range.high + imm < размера, иначе -
+// переход на проверяемую копию
+bool LoopCompiler::emitGuard(const Instruction& ins) {
+    int slot = arraySlot(ins.b, ins.op != OpCode::GUARD_INDEX);
+    if (slot < 0) return false;
+    int32_t extent = ins.op == OpCode::GUARD_INDEX ? ARRAY_LENGTH : ins.op == OpCode::GUARD_ROW ? ARRAY_ROWS : ARRAY_COLS;
+    int32_t offset = ins.imm.asInt();
+
+    as.load64(RDX, at(CONTEXT, CONTEXT_RANGES));
+    as.load64(RAX, at(RDX, ins.c * RANGE_SIZE + RANGE_LOW));
+    as.load64(RCX, at(RDX, ins.c * RANGE_SIZE + RANGE_HIGH));
+    if (offset != 0) {
+        as.aluImm(EXT_ADD, true, RAX, offset);
+        as.aluImm(EXT_ADD, true, RCX, offset);
+    }
+    as.test64(RAX, RAX);
+    transfer(LESS, static_cast<size_t>(ins.a));
+    as.load64(RDX, at(CONTEXT, CONTEXT_ARRAYS));
+    as.cmp64(RCX, at(RDX, slot * ARRAY_SIZE + extent));
+    transfer(GREATER_EQUAL, static_cast<size_t>(ins.a));
+    return true;
+}
+
+bool LoopCompiler::emitArrayGet(const Instruction& ins, bool checked) {
+    size_t index = stack.size() - 1;
+    int slot = arraySlot(ins.a, false);
+    if (slot < 0 || (!checked && stack[index] != StaticType::INT)) return false;
+    indexFromSlot(RCX, index);
+    address(slot, checked);
+    loadElement(elementType(slot), index);
+    return true;
+}
+
+bool LoopCompiler::emitArraySet(const Instruction& ins, bool checked) {
+    size_t value = stack.size() - 1;
+    size_t index = value - 1;
+    int slot = arraySlot(ins.a, false);
+    if (slot < 0 || (!checked && stack[index] != StaticType::INT)) return false;
+    indexFromSlot(RCX, index);
+    address(slot, checked);
+    storeElement(elementType(slot), value);
+    stack.pop_back();
+    stack.pop_back();
+    return true;
+}
+
+bool LoopCompiler::emitArrayGet2D(const Instruction& ins, bool checked) {
+    size_t col = stack.size() - 1;
+    size_t row = col - 1;
+    int slot = arraySlot(ins.a, true);
+    if (slot < 0 || (!checked && (stack[row] != StaticType::INT || stack[col] != StaticType::INT))) return false;
+    indexFromSlot(RCX, row);
+    indexFromSlot(RAX, col);
+    address2D(slot, checked);
+    stack.pop_back();
+    loadElement(elementType(slot), row);
+    return true;
+}
+
+bool LoopCompiler::emitArraySet2D(const Instruction& ins, bool checked) {
+    size_t value = stack.size() - 1;
+    size_t col = value - 1;
+    size_t row = col - 1;
+    int slot = arraySlot(ins.a, true);
+    if (slot < 0 || (!checked && (stack[row] != StaticType::INT || stack[col] != StaticType::INT))) return false;
+    indexFromSlot(RCX, row);
+    indexFromSlot(RAX, col);
+    address2D(slot, checked);
+    storeElement(elementType(slot), value);
+    stack.resize(row);
+    return true;
+}
+
+// i arr array_get (и вариант с tee во временную переменную)
+bool LoopCompiler::emitLoadElement(const Instruction& ins, bool checked, bool tee) {
+    size_t depth = stack.size();
+    int slot = arraySlot(ins.a, false);
+    if (slot < 0 || depth + 1 > MAX_DEPTH || !typed(variableTypes[ins.b])) return false;
+    if (!checked && variableTypes[ins.b] != StaticType::INT) return false;
+    StaticType element = declaredType(elementType(slot));
+    if (tee && variableTypes[ins.c] != element) return false;
+
+    indexFromVariable(RCX, ins.b);
+    address(slot, checked);
+    stack.push_back(element);
+    loadElement(elementType(slot), depth);
+    if (tee) {
+        if (element == StaticType::INT) {
+            storeInt(ins.c, gpr(depth));
+        } else {
+            storeDouble(ins.c, xmm(depth));
+        }
+    }
+    return true;
+}
+
+// Команда цикла в машинный код. false - команда не поддерживается или её типы
+// не доказаны (до этого ничего не выдано): на её месте будет выход
+bool LoopCompiler::emit(const Instruction& ins) {
+    size_t depth = stack.size();
+    fallsThrough = true;
+
+    switch (ins.op) {
+        case OpCode::NOP:
+        case OpCode::LABEL:
+            return true;
+        case OpCode::POP:
+            stack.pop_back();
+            return true;
+        case OpCode::PUSH_CONST:
+            if (depth + 1 > MAX_DEPTH) return false;
+            if (ins.imm.isInt()) {
+                as.movImm32(gpr(depth), ins.imm.asInt());
+                stack.push_back(StaticType::INT);
+            } else {
+                loadConstant(xmm(depth), ins.imm.asDouble());
+                stack.push_back(StaticType::DOUBLE);
+            }
+            return true;
+        case OpCode::PUSH_VAR: {
+            StaticType type = variableTypes[ins.a];
+            if (depth + 1 > MAX_DEPTH || !typed(type)) return false;
+            if (type == StaticType::INT) {
+                loadInt(gpr(depth), ins.a);
+            } else {
+                loadDouble(xmm(depth), ins.a);
+            }
+            stack.push_back(type);
+            return true;
+        }
+        case OpCode::STORE:
+        case OpCode::TEE: {
+            StaticType type = stack.back();
+            if (variableTypes[ins.a] != type) return false;
+            if (type == StaticType::INT) {
+                storeInt(ins.a, gpr(depth - 1));
+            } else {
+                storeDouble(ins.a, xmm(depth - 1));
+            }
+            if (ins.op == OpCode::STORE) stack.pop_back();
+            return true;
+        }
+        case OpCode::DECLARE: {
+            StaticType type = declaredType(ins.type);
+            if (variableTypes[ins.a] != type) return false;
+            if (type == StaticType::INT) {
+                as.movImm32(RCX, 0);
+                storeInt(ins.a, RCX);
+            } else {
+                as.xorpd(XMM7);
+                storeDouble(ins.a, XMM7);
+            }
+            return true;
+        }
+        case OpCode::DECLARE_ASSIGN: {
+            // int - усечение, float / double - преобразование, char - как есть
+            StaticType value = stack.back();
+            StaticType type = ins.type == DataType::CHAR ? value : declaredType(ins.type);
+            if (variableTypes[ins.a] != type) return false;
+            if (type == StaticType::INT) {
+                int src = gpr(depth - 1);
+                if (value == StaticType::DOUBLE) {
+                    as.cvttsd2si(RCX, xmm(depth - 1));
+                    src = RCX;
+                }
+                storeInt(ins.a, src);
+            } else {
+                int src = xmm(depth - 1);
+                if (value == StaticType::INT) {
+                    as.cvtsi2sd(XMM7, gpr(depth - 1));
+                    src = XMM7;
+                }
+                storeDouble(ins.a, src);
+            }
+            stack.pop_back();
+            return true;
+        }
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV:
+        case OpCode::ADD_I32: case OpCode::SUB_I32: case OpCode::MUL_I32: case OpCode::DIV_I32:
+        case OpCode::ADD_F64: case OpCode::SUB_F64: case OpCode::MUL_F64: case OpCode::DIV_F64:
+            return emitArithmetic(arithmeticBase(ins.op));
+        case OpCode::GT: case OpCode::LT: case OpCode::EQ:
+        case OpCode::GT_I32: case OpCode::LT_I32: case OpCode::EQ_I32:
+        case OpCode::GT_F64: case OpCode::LT_F64: case OpCode::EQ_F64:
+            return emitComparison(comparisonBase(ins.op));
+        case OpCode::JUMP:
+            jumpTo(static_cast<size_t>(ins.a));
+            fallsThrough = false;
+            return true;
+        case OpCode::JUMP_FALSE: {
+            // Ложь - целый 0 или вещественный 0.0 (NaN - истина)
+            StaticType type = stack.back();
+            stack.pop_back();
+            if (type == StaticType::INT) {
+                as.test32(gpr(depth - 1), gpr(depth - 1));
+                transfer(EQUAL, static_cast<size_t>(ins.a));
+            } else {
+                int isTrue = as.newLabel();
+                as.xorpd(XMM7);
+                as.ucomisd(xmm(depth - 1), XMM7);
+                as.jcc(PARITY, isTrue);
+                transfer(EQUAL, static_cast<size_t>(ins.a));
+                as.bind(isTrue);
+            }
+            return true;
+        }
+        case OpCode::INC_VAR: {
+            StaticType type = variableTypes[ins.a];
+            bool subtract = ins.fused == OpCode::SUB || ins.fused == OpCode::SUB_I32 || ins.fused == OpCode::SUB_F64;
+            int reg = variableRegisters[ins.a];
+            if (type == StaticType::INT && ins.imm.isInt()) {
+                int ext = subtract ? EXT_SUB : EXT_ADD;
+                if (reg >= 0) {
+                    as.aluImm(ext, false, reg, ins.imm.asInt());
+                } else {
+                    as.aluImm(ext, false, variable(ins.a, PAYLOAD), ins.imm.asInt());
+                }
+                return true;
+            }
+            if (type != StaticType::DOUBLE) return false;
+            loadConstant(XMM7, ins.imm.asDouble());
+            int value = reg >= 0 ? reg : XMM6;
+            if (reg < 0) loadDouble(XMM6, ins.a);
+            if (subtract) {
+                as.subsd(value, XMM7);
+            } else {
+                as.addsd(value, XMM7);
+            }
+            if (reg < 0) storeDouble(ins.a, XMM6);
+            return true;
+        }
+        case OpCode::CMP_VAR_VAR_JF:
+        case OpCode::CMP_VAR_CONST_JF:
+            return emitCompareJump(ins);
+        case OpCode::LOOP_INIT:
+            return emitLoopInit(ins);
+        case OpCode::LOOP_NEXT:
+            return emitLoopNext(ins);
+        case OpCode::GUARD_INDEX:
+        case OpCode::GUARD_ROW:
+        case OpCode::GUARD_COL:
+            return emitGuard(ins);
+        case OpCode::ARRAY_GET:
+        case OpCode::ARRAY_GET_UNCHECKED:
+            return emitArrayGet(ins, ins.op == OpCode::ARRAY_GET);
+        case OpCode::ARRAY_SET:
+        case OpCode::ARRAY_SET_UNCHECKED:
+            return emitArraySet(ins, ins.op == OpCode::ARRAY_SET);
+        case OpCode::ARRAY_GET_2D:
+        case OpCode::ARRAY_GET_2D_UNCHECKED:
+            return emitArrayGet2D(ins, ins.op == OpCode::ARRAY_GET_2D);
+        case OpCode::ARRAY_SET_2D:
+        case OpCode::ARRAY_SET_2D_UNCHECKED:
+            return emitArraySet2D(ins, ins.op == OpCode::ARRAY_SET_2D);
+        case OpCode::LOAD_ELEM_VAR_INDEX:
+            return emitLoadElement(ins, true, false);
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+            return emitLoadElement(ins, true, true);
+        case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            return emitLoadElement(ins, false, false);
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+            return emitLoadElement(ins, false, true);
+        default:
+            // Ввод, вывод и выделение памяти выполняет интерпретатор
+            return false;
+    }
+}
+
+bool LoopCompiler::compile(JitLoop& loop) {
+    uses = &loop.arrays;
+    if (!enterable(begin) || !typing.stackTypes(begin).empty()) return false;
+
+    assignVariables();
+    arraySlots.assign(program.arrays.size(), -1);
+    arraySlots2D.assign(program.arrays.size(), -1);
+    labels.assign(end - begin + 1, -1);
+    for (size_t at = begin; at <= end; ++at) {
+        if (enterable(at)) labels[at - begin] = as.newLabel();
+    }
+
+    // Пролог: сохранить регистры вызывающего, загрузить переменные в регистры
+    for (int reg : CALLEE_SAVED) as.push(reg);
+    as.mov64(CONTEXT, RDI);
+    as.load64(FRAME, at(RDI, CONTEXT_FRAME));
+    for (size_t v = 0; v < variableRegisters.size(); ++v) {
+        int reg = variableRegisters[v];
+        if (reg < 0) continue;
+        if (variableTypes[v] == StaticType::INT) {
+            as.load32(reg, variable(static_cast<int>(v), PAYLOAD));
+        } else {
+            as.movsdLoad(reg, variable(static_cast<int>(v), PAYLOAD));
+        }
+    }
+
+    for (pc = begin; pc <= end; ++pc) {
+        if (labels[pc - begin] < 0) continue;
+        as.bind(labels[pc - begin]);
+        stack = typing.stackTypes(pc);
+        if (!emit(program.code[pc])) {
+            // Начало цикла интерпретатор выполнил бы сразу после входа - смысла в коде нет
+            if (pc == begin) return false;
+            stack = typing.stackTypes(pc);
+            as.jmp(exitTo(pc));
+            continue;
+        }
+        if (!fallsThrough) continue;
+        size_t next = pc + 1;
+        bool adjacent = next <= end && labels[next - begin] >= 0 && typing.stackTypes(next) == stack;
+        if (!adjacent) jumpTo(next);
+    }
+
+    // Выходы: ячейки стека из регистров в стек операндов интерпретатора
+    int epilogue = as.newLabel();
+    for (const Exit& exit : exits) {
+        as.bind(exit.label);
+        if (!exit.stack.empty()) {
+            as.load64(RCX, at(CONTEXT, CONTEXT_STACK));
+            for (size_t slot = 0; slot < exit.stack.size(); ++slot) {
+                Mem value = at(RCX, static_cast<int32_t>(slot) * VALUE_SIZE);
+                if (exit.stack[slot] == StaticType::INT) {
+                    writeInt(value, gpr(slot));
+                } else {
+                    writeDouble(value, xmm(slot));
+                }
+            }
+        }
+        as.storeImm64(at(CONTEXT, CONTEXT_RESUME), static_cast<int32_t>(exit.pc));
+        as.storeImm64(at(CONTEXT, CONTEXT_DEPTH), static_cast<int32_t>(exit.stack.size()));
+        as.jmp(epilogue);
+    }
+
+    // Эпилог: переменные из регистров в кадр
+    as.bind(epilogue);
+    for (size_t v = 0; v < variableRegisters.size(); ++v) {
+        int reg = variableRegisters[v];
+        if (reg < 0) continue;
+        if (variableTypes[v] == StaticType::INT) {
+            writeInt(variable(static_cast<int>(v), 0), reg);
+        } else {
+            writeDouble(variable(static_cast<int>(v), 0), reg);
+        }
+    }
+    for (size_t i = sizeof(CALLEE_SAVED) / sizeof(int); i > 0; --i) as.pop(CALLEE_SAVED[i - 1]);
+    as.ret();
+
+    return as.resolve();
+}
+
+// Код в отдельные страницы: запись, затем только чтение и выполнение (W^X)
+bool install(JitLoop& loop, const std::vector<uint8_t>& code) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return false;
+    }
+    loop.memory = memory;
+    loop.mappedSize = size;
+    loop.codeSize = code.size();
+    loop.entry = reinterpret_cast<void (*)(JitContext*)>(memory);
+    return true;
+}
+
+} // namespace
+#endif // OPS_JIT_NATIVE
+
+JitLoop::~JitLoop() {
+#ifdef OPS_JIT_NATIVE
+    if (memory != nullptr) {
+        munmap(memory, mappedSize);
+    }
+#endif
+}
+
+OPSJit::OPSJit() : program(nullptr), typesKnown(false), compiledCount(0), compiledSize(0) {}
+
+OPSJit::~OPSJit() = default;
+
+bool OPSJit::available() {
+#ifdef OPS_JIT_NATIVE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OPSJit::prepare(const OPSProgram& opsProgram, const std::vector<Value>& initialFrame) {
+    clear();
+    if (!available()) return;
+
+    // Типы нужны по слитой программе - той, что выполняет интерпретатор
+    program = &opsProgram;
+    typesKnown = typing.analyze(opsProgram, initialFrame);
+    if (!typesKnown) return;
+    loops.resize(opsProgram.code.size());
+}
+
+void OPSJit::clear() {
+    program = nullptr;
+    typesKnown = false;
+    loops.clear();
+    compiledCount = 0;
+    compiledSize = 0;
+}
+
+const JitLoop* OPSJit::compile(size_t header, size_t latch, const std::vector<ArrayStorage>& arrays,
+                               const std::vector<ArrayStorage>& arrays2D) {
+    if (!typesKnown || header >= loops.size() || latch >= loops.size()) return nullptr;
+    if (loops[header]) return loops[header].get();
+#ifdef OPS_JIT_NATIVE
+    std::unique_ptr<JitLoop> loop(new JitLoop());
+    LoopCompiler compiler(*program, typing, header, latch, arrays, arrays2D);
+    if (compiler.compile(*loop) && install(*loop, compiler.code())) {
+        compiledCount++;
+        compiledSize += loop->codeSize;
+        loops[header] = std::move(loop);
+        return loops[header].get();
+    }
+#else
+    (void)arrays;
+    (void)arrays2D;
+#endif
+    return nullptr;
+}
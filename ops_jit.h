@@ -0,0 +1,106 @@
+#ifndef OPS_JIT_H
+#define OPS_JIT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ops_value.h"
+#include "ops_program.h"
+#include "ops_typing.h"
+
+struct ArrayStorage;
+struct LoopRange;
+
+// Массив в таблице машинного кода: буфер элементов и размеры
+// (для одномерного rows = size, cols = 1)
+struct JitArray {
+    void* data = nullptr;
+    int64_t size = 0;
+    int64_t rows = 0;
+    int64_t cols = 0;
+};
+
+// Состояние интерпретатора, которое получает машинный код цикла. На входе стек
+// операндов пуст; на выходе код сохраняет переменные из регистров в кадр,
+// оставшиеся значения - в стек и сообщает, с какой команды продолжать
+struct JitContext {
+    Value* frame;                 // кадр переменных
+    Value* stack;                 // начало стека операндов
+    long long* loopCounters;      // счётчики LOOP_INIT / LOOP_NEXT
+    LoopRange* loopRanges;        // диапазоны переменных циклов (для охраны границ)
+    const JitArray* arrays;       // массивы цикла в порядке JitLoop::arrays
+    size_t resumePc;              // выход: команда, с которой продолжает интерпретатор
+    size_t stackDepth;            // выход: глубина стека операндов
+};
+
+// Массив, к которому обращается машинный код, и тип его элементов на момент
+// компиляции (код читает буфер этого типа; при другом типе цикл выполняет интерпретатор)
+struct JitArrayUse {
+    int index = 0;
+    bool twoDimensional = false;
+    DataType elementType = DataType::INT;
+};
+
+// Цикл, переведённый в машинный код x86-64
+struct JitLoop {
+    void (*entry)(JitContext*) = nullptr;
+    std::vector<JitArrayUse> arrays;
+    size_t codeSize = 0;          // байт машинного кода
+    void* memory = nullptr;       // исполняемые страницы (mmap)
+    size_t mappedSize = 0;
+
+    JitLoop() = default;
+    JitLoop(const JitLoop&) = delete;
+    JitLoop& operator=(const JitLoop&) = delete;
+    ~JitLoop();
+};
+
+// JIT-компилятор горячих циклов: область от начала цикла (цель обратного
+// перехода j или loop_next) до обратного перехода переводится в машинный код
+// x86-64 в буфере mmap. Когда компилировать, решает интерпретатор по
+// счётчикам обратных переходов (OPSProfile).
+// Типы значений берутся из вывода типов; переменные с постоянным типом
+// держатся в регистрах (int - r12-r15, double - xmm8-xmm15), стек операндов -
+// в регистрах по глубине. Команда, которую код не поддерживает (или тип которой
+// не доказан), становится выходом: регистры сохраняются в кадр и стек, и с
+// этой команды продолжает интерпретатор. Без x86-64 Linux (или при сборке с
+// OPS_JIT=OFF) компилятор недоступен и все циклы выполняет интерпретатор
+class OPSJit {
+public:
+    OPSJit();
+    ~OPSJit();
+
+    // Собран ли генератор машинного кода для этой платформы
+    static bool available();
+
+    // Вывести типы скомпонованной программы (initialFrame - значения
+    // переменных на момент запуска). Программа должна жить и не меняться,
+    // пока выполняется её машинный код
+    void prepare(const OPSProgram& program, const std::vector<Value>& initialFrame);
+
+    // Забыть программу и освободить машинный код
+    void clear();
+
+    // Машинный код цикла с началом в pc (nullptr - ещё не компилировался)
+    const JitLoop* compiled(size_t pc) const { return pc < loops.size() ? loops[pc].get() : nullptr; }
+
+    // Скомпилировать цикл header..latch (latch - обратный переход) по текущим
+    // массивам интерпретатора (тип их элементов). nullptr - цикл не
+    // компилируется и остаётся интерпретатору
+    const JitLoop* compile(size_t header, size_t latch, const std::vector<ArrayStorage>& arrays,
+                           const std::vector<ArrayStorage>& arrays2D);
+
+    // Число скомпилированных циклов и байт машинного кода
+    size_t compiledLoops() const { return compiledCount; }
+    size_t compiledBytes() const { return compiledSize; }
+
+private:
+    const OPSProgram* program;
+    OPSTypeInference typing;
+    bool typesKnown;
+    std::vector<std::unique_ptr<JitLoop>> loops;  // машинный код по началу цикла
+    size_t compiledCount;
+    size_t compiledSize;
+};
+
+#endif // OPS_JIT_H
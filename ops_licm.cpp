@@ -0,0 +1,173 @@
+#include "ops_licm.h"
+#include <charconv>
+#include <unordered_map>
+
+namespace {
+
+bool isHoistable(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL || op == OpCode::DIV ||
+           op == OpCode::GT || op == OpCode::LT || op == OpCode::EQ;
+}
+
+bool definesVariable(OpCode op) {
+    return op == OpCode::STORE || op == OpCode::TEE || op == OpCode::DECLARE_ASSIGN ||
+           op == OpCode::DECLARE || op == OpCode::READ;
+}
+
+std::string operandKey(const Instruction& ins) {
+    if (ins.op == OpCode::PUSH_VAR) return "v" + std::to_string(ins.a);
+    if (ins.imm.isInt()) return "i" + std::to_string(ins.imm.asInt());
+    char buffer[64];
+    auto converted = std::to_chars(buffer, buffer + sizeof(buffer), ins.imm.asDouble());
+    return "d" + std::string(buffer, converted.ptr);
+}
+
+// Деление, которое не может завершиться ошибкой ни при каком делимом
+bool safeDivisor(const Instruction& ins) {
+    if (ins.op != OpCode::PUSH_CONST) return false;
+    if (ins.imm.isInt()) return ins.imm.asInt() != 0 && ins.imm.asInt() != -1;
+    return ins.imm.asDouble() != 0.0;
+}
+
+struct Hoisted {
+    size_t start;
+    size_t end;
+    int temporary;
+};
+
+} // namespace
+
+size_t OPSLoopInvariantMotion::optimize(OPSProgram& program) const {
+    if (program.linked) return 0;
+
+    // После выноса граф перестраивается; вынесенное из внутреннего цикла
+    // может оказаться инвариантом и внешнего
+    size_t total = 0;
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        ControlFlowGraph graph = ControlFlowGraph::build(program);
+        for (const ControlFlowGraph::Loop& loop : graph.loops()) {
+            if (!graph.enteredByFallthrough(program, loop)) continue;
+            size_t count = hoist(program, graph, loop);
+            if (count > 0) {
+                total += count;
+                moved = true;
+                break;
+            }
+        }
+    }
+    return total;
+}
+
+bool OPSLoopInvariantMotion::invariant(const OPSProgram& program, size_t blockBegin, size_t end,
+                                       const std::vector<bool>& changed, size_t& start,
+                                       std::string& key) const {
+    const std::vector<Instruction>& code = program.code;
+    const Instruction& ins = code[end];
+    if (!isHoistable(ins.op) || end < blockBegin + 2) return false;
+
+    const Instruction& left = code[end - 2];
+    const Instruction& right = code[end - 1];
+    bool constants = true;
+    for (const Instruction* operand : {&left, &right}) {
+        if (operand->op == OpCode::PUSH_VAR) {
+            if (changed[operand->a]) return false;
+            constants = false;
+        } else if (operand->op != OpCode::PUSH_CONST) {
+            return false;
+        }
+    }
+    // Две константы свёртка оставила только из-за ошибки или переполнения
+    if (constants) return false;
+    if (ins.op == OpCode::DIV && !safeDivisor(right)) return false;
+
+    start = end - 2;
+    key = std::to_string(static_cast<int>(ins.op)) + " " + operandKey(left) + " " + operandKey(right);
+    return true;
+}
+
+size_t OPSLoopInvariantMotion::hoist(OPSProgram& program, const ControlFlowGraph& graph,
+                                     const ControlFlowGraph::Loop& loop) const {
+    const std::vector<Instruction>& code = program.code;
+
+    // Переменные, которые меняются внутри цикла
+    std::vector<bool> changed(program.variables.size(), false);
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (!loop.body[b]) continue;
+        for (size_t i = graph.blocks[b].begin; i < graph.blocks[b].end; ++i) {
+            if (definesVariable(code[i].op)) changed[code[i].a] = true;
+        }
+    }
+
+    // Одинаковые инварианты вычисляются в предзаголовке один раз
+    std::vector<Hoisted> occurrences;
+    std::vector<Hoisted> preheader;
+    std::unordered_map<std::string, int> temporaryFor;
+    size_t temporaries = 0;
+    for (const std::string& name : program.variables) {
+        if (isTemporaryName(name)) temporaries++;
+    }
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (!loop.body[b]) continue;
+        for (size_t i = graph.blocks[b].begin; i < graph.blocks[b].end; ++i) {
+            size_t start;
+            std::string key;
+            if (!invariant(program, graph.blocks[b].begin, i, changed, start, key)) continue;
+
+            auto found = temporaryFor.find(key);
+            if (found == temporaryFor.end()) {
+                int slot = static_cast<int>(program.variables.size());
+                program.variables.push_back(temporaryName(temporaries++));
+                found = temporaryFor.emplace(key, slot).first;
+                preheader.push_back({start, i, slot});
+            }
+            occurrences.push_back({start, i, found->second});
+        }
+    }
+    if (occurrences.empty()) return 0;
+
+    std::vector<long> occurrenceFrom(code.size(), -1);
+    for (size_t k = 0; k < occurrences.size(); ++k) {
+        occurrenceFrom[occurrences[k].start] = static_cast<long>(k);
+    }
+
+    std::vector<Instruction> rewritten;
+    std::vector<std::string> text;
+    rewritten.reserve(code.size() + 3 * preheader.size());
+    text.reserve(code.size() + 3 * preheader.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (i == graph.blocks[loop.header].begin) {
+            // Предзаголовок: x y op $tN := перед меткой начала цикла
+            for (const Hoisted& hoisted : preheader) {
+                for (size_t k = hoisted.start; k <= hoisted.end; ++k) {
+                    rewritten.push_back(code[k]);
+                    text.push_back(program.text[k]);
+                }
+                Instruction store;
+                store.op = OpCode::STORE;
+                store.a = hoisted.temporary;
+                rewritten.push_back(store);
+                text.push_back(program.variables[hoisted.temporary] + " :=");
+            }
+        }
+
+        if (occurrenceFrom[i] >= 0) {
+            const Hoisted& hoisted = occurrences[static_cast<size_t>(occurrenceFrom[i])];
+            Instruction load;
+            load.op = OpCode::PUSH_VAR;
+            load.a = hoisted.temporary;
+            rewritten.push_back(load);
+            text.push_back(program.variables[hoisted.temporary]);
+            i = hoisted.end;
+            continue;
+        }
+
+        rewritten.push_back(code[i]);
+        text.push_back(program.text[i]);
+    }
+
+    program.code = std::move(rewritten);
+    program.text = std::move(text);
+    return occurrences.size();
+}
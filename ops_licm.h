@@ -0,0 +1,31 @@
+#ifndef OPS_LICM_H
+#define OPS_LICM_H
+
+#include <string>
+#include <vector>
+#include "ops_cfg.h"
+
+// Вынос инвариантов из циклов for/while. Цикл - метка начала mN:, условие,
+// тело и обратный переход mN j. Инвариант - арифметика или сравнение над
+// константами и переменными, которые в цикле не меняются (len 1 -, n m *).
+// Он вычисляется один раз в предзаголовке - перед меткой начала цикла - и
+// сохраняется во временной переменной $tN, а в цикле читается из неё.
+// Деление выносится только на ненулевую константу: предзаголовок выполняется
+// и тогда, когда тело цикла не выполняется ни разу.
+// Работает по нескомпонованной программе
+class OPSLoopInvariantMotion {
+public:
+    // Возвращает число вынесенных вычислений
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    // Выносит инварианты одного цикла; 0 - выносить нечего
+    size_t hoist(OPSProgram& program, const ControlFlowGraph& graph,
+                 const ControlFlowGraph::Loop& loop) const;
+
+    // Инвариантное выражение, заканчивающееся командой end
+    bool invariant(const OPSProgram& program, size_t blockBegin, size_t end,
+                   const std::vector<bool>& changed, size_t& start, std::string& key) const;
+};
+
+#endif // OPS_LICM_H
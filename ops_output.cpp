@@ -0,0 +1,58 @@
+#include "ops_output.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+const char PREFIX[] = "  ВЫВОД: ";
+
+// Самое длинное представление: double в кратчайшей обратимой форме (~24 символа)
+const size_t MAX_VALUE_CHARS = 32;
+
+} // namespace
+
+BufferedOutputSink::BufferedOutputSink(std::FILE* stream, size_t capacity)
+    : stream(stream), buffer(capacity < 64 ? 64 : capacity), used(0), raw(false) {}
+
+BufferedOutputSink::~BufferedOutputSink() {
+    flush();
+}
+
+void BufferedOutputSink::setRaw(bool rawMode) {
+    raw = rawMode;
+}
+
+void BufferedOutputSink::write(const Value& value) {
+    if (!raw) {
+        append(PREFIX, sizeof(PREFIX) - 1);
+    }
+
+    if (buffer.size() - used < MAX_VALUE_CHARS + 1) {
+        flush();
+    }
+
+    // Форматируем прямо в буфер: целые - как есть, double - кратчайшая обратимая запись
+    char* begin = buffer.data() + used;
+    char* end = buffer.data() + buffer.size();
+    std::to_chars_result result = value.isInt()
+        ? std::to_chars(begin, end, value.asInt())
+        : std::to_chars(begin, end, value.asDouble());
+    used = static_cast<size_t>(result.ptr - buffer.data());
+    buffer[used++] = '\n';
+}
+
+void BufferedOutputSink::flush() {
+    if (used > 0) {
+        std::fwrite(buffer.data(), 1, used, stream);
+        used = 0;
+    }
+    std::fflush(stream);
+}
+
+void BufferedOutputSink::append(const char* data, size_t length) {
+    if (buffer.size() - used < length) {
+        flush();
+    }
+    std::memcpy(buffer.data() + used, data, length);
+    used += length;
+}
@@ -0,0 +1,43 @@
+#ifndef OPS_OUTPUT_H
+#define OPS_OUTPUT_H
+
+#include <cstdio>
+#include <vector>
+#include "ops_value.h"
+
+// Приёмник вывода команды w
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    // Записать одно значение
+    virtual void write(const Value& value) = 0;
+
+    // Сбросить накопленный вывод
+    virtual void flush() = 0;
+};
+
+// Буферизованный приёмник: значения форматируются через std::to_chars
+// в буфер пользовательского пространства и сбрасываются в поток только
+// при заполнении буфера или по явному flush()
+class BufferedOutputSink : public OutputSink {
+public:
+    explicit BufferedOutputSink(std::FILE* stream = stdout, size_t capacity = 1 << 16);
+    ~BufferedOutputSink() override;
+
+    void write(const Value& value) override;
+    void flush() override;
+
+    // Сырой режим: только значения, по одному в строке (без префикса "ВЫВОД:")
+    void setRaw(bool rawMode);
+
+private:
+    std::FILE* stream;
+    std::vector<char> buffer;
+    size_t used;
+    bool raw;
+
+    void append(const char* data, size_t length);
+};
+
+#endif // OPS_OUTPUT_H
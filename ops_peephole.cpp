@@ -0,0 +1,223 @@
+#include "ops_peephole.h"
+
+namespace {
+
+size_t countInstructions(const OPSProgram& program) {
+    size_t count = 0;
+    for (const Instruction& ins : program.code) {
+        if (ins.op != OpCode::LABEL) count++;
+    }
+    return count;
+}
+
+bool isPush(OpCode op) {
+    return op == OpCode::PUSH_CONST || op == OpCode::PUSH_VAR;
+}
+
+bool isIntConstant(const Instruction& ins, int value) {
+    return ins.op == OpCode::PUSH_CONST && ins.imm.isInt() && ins.imm.asInt() == value;
+}
+
+// Двухместная операция без побочных эффектов (деление может вызвать ошибку)
+bool isPureBinary(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL ||
+           op == OpCode::GT || op == OpCode::LT || op == OpCode::EQ;
+}
+
+// Пересборка потока команд без помеченных к удалению
+void compact(OPSProgram& program, const std::vector<bool>& removed) {
+    std::vector<Instruction> code;
+    std::vector<std::string> text;
+    code.reserve(program.code.size());
+    text.reserve(program.text.size());
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        if (removed[i]) continue;
+        code.push_back(program.code[i]);
+        text.push_back(program.text[i]);
+    }
+    program.code = std::move(code);
+    program.text = std::move(text);
+}
+
+} // namespace
+
+OPSPeephole::OPSPeephole(const PeepholeConfig& peepholeConfig) : config(peepholeConfig) {}
+
+size_t OPSPeephole::optimize(OPSProgram& program) const {
+    // После компоновки меток уже нет - окна правил могли бы пересечь точку входа
+    if (program.linked) return 0;
+
+    size_t before = countInstructions(program);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        if (config.threadJumps) changed |= threadJumps(program);
+        if (config.removeRedundantJumps) changed |= removeRedundantJumps(program);
+        if (config.dropIdentities) changed |= dropIdentities(program);
+        if (config.removePushPop) changed |= removePushPop(program);
+    }
+    return before - countInstructions(program);
+}
+
+bool OPSPeephole::removeRedundantJumps(OPSProgram& program) const {
+    std::vector<Instruction>& code = program.code;
+    std::vector<bool> removed(code.size(), false);
+    bool changed = false;
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        Instruction& ins = code[i];
+        if (ins.op != OpCode::JUMP && ins.op != OpCode::JUMP_FALSE) continue;
+
+        // Цель - одна из меток, стоящих сразу за переходом
+        bool toNext = false;
+        for (size_t k = i + 1; k < code.size() && code[k].op == OpCode::LABEL; ++k) {
+            if (code[k].a == ins.a) {
+                toNext = true;
+                break;
+            }
+        }
+        if (!toNext) continue;
+
+        if (ins.op == OpCode::JUMP) {
+            removed[i] = true;
+        } else {
+            // Условие всё равно вычислено - его нужно снять со стека
+            ins = Instruction();
+            ins.op = OpCode::POP;
+            program.text[i] = "pop";
+        }
+        changed = true;
+    }
+
+    compact(program, removed);
+    return changed;
+}
+
+bool OPSPeephole::threadJumps(OPSProgram& program) const {
+    std::vector<Instruction>& code = program.code;
+
+    // Позиция каждой метки в потоке команд
+    std::vector<long> labelAt(program.labels.size(), -1);
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].op == OpCode::LABEL) {
+            labelAt[code[i].a] = static_cast<long>(i);
+        }
+    }
+
+    // Первая обычная команда после метки
+    auto landing = [&](int label) -> const Instruction* {
+        if (labelAt[label] < 0) return nullptr;
+        size_t k = static_cast<size_t>(labelAt[label]);
+        while (k < code.size() && code[k].op == OpCode::LABEL) ++k;
+        return k < code.size() ? &code[k] : nullptr;
+    };
+
+    bool changed = false;
+    for (size_t i = 0; i < code.size(); ++i) {
+        Instruction& ins = code[i];
+        if (ins.op != OpCode::JUMP && ins.op != OpCode::JUMP_FALSE) continue;
+
+        // Идём по цепочке mA: mB j, mB: mC j ...; замкнутую цепочку (пустой
+        // бесконечный цикл) не трогаем
+        std::vector<bool> visited(program.labels.size(), false);
+        int target = ins.a;
+        bool cycle = false;
+        while (true) {
+            visited[target] = true;
+            const Instruction* next = landing(target);
+            if (next == nullptr || next->op != OpCode::JUMP) break;
+            if (visited[next->a]) {
+                cycle = true;
+                break;
+            }
+            target = next->a;
+        }
+        if (!cycle && target != ins.a) {
+            ins.a = target;
+            program.text[i] = program.labels[target] + (ins.op == OpCode::JUMP ? " j" : " jf");
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool OPSPeephole::dropIdentities(OPSProgram& program) const {
+    std::vector<Instruction>& code = program.code;
+    std::vector<bool> removed(code.size(), false);
+    bool changed = false;
+
+    for (size_t i = 0; i + 1 < code.size(); ++i) {
+        if (removed[i]) continue;
+        OpCode op = code[i + 1].op;
+
+        // Правый нейтральный элемент: x 0 -, x 1 *, x 1 /. Только целые
+        // константы: x + 0.0 превратил бы целое x в double. x 0 + не
+        // тождество для вещественного x: -0.0 + 0 = +0.0
+        if ((op == OpCode::SUB && isIntConstant(code[i], 0)) ||
+            ((op == OpCode::MUL || op == OpCode::DIV) && isIntConstant(code[i], 1))) {
+            removed[i] = removed[i + 1] = true;
+            changed = true;
+            i++;
+            continue;
+        }
+
+        // Левый нейтральный элемент для перестановочной операции: 1 x *
+        if (i + 2 < code.size() && isPush(code[i + 1].op)) {
+            OpCode binary = code[i + 2].op;
+            if (binary == OpCode::MUL && isIntConstant(code[i], 1)) {
+                removed[i] = removed[i + 2] = true;
+                changed = true;
+                i += 2;
+            }
+        }
+    }
+
+    compact(program, removed);
+    return changed;
+}
+
+bool OPSPeephole::removePushPop(OPSProgram& program) const {
+    std::vector<Instruction>& code = program.code;
+    std::vector<bool> removed(code.size(), false);
+    bool changed = false;
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (removed[i]) continue;
+
+        // Нераспознанная лексема на стек не влияет
+        if (code[i].op == OpCode::NOP) {
+            removed[i] = true;
+            changed = true;
+            continue;
+        }
+        if (i + 1 >= code.size()) continue;
+        const Instruction& next = code[i + 1];
+
+        // Значение кладётся и сразу снимается
+        if (isPush(code[i].op) && next.op == OpCode::POP) {
+            removed[i] = removed[i + 1] = true;
+            changed = true;
+            i++;
+            continue;
+        }
+
+        // Присваивание переменной самой себе: x x :=
+        if (code[i].op == OpCode::PUSH_VAR && next.op == OpCode::STORE && next.a == code[i].a) {
+            removed[i] = removed[i + 1] = true;
+            changed = true;
+            i++;
+            continue;
+        }
+
+        // Результат чистой операции не нужен - снимаются оба операнда
+        if (isPureBinary(code[i].op) && next.op == OpCode::POP) {
+            code[i] = Instruction();
+            code[i].op = OpCode::POP;
+            program.text[i] = "pop";
+            changed = true;
+        }
+    }
+
+    compact(program, removed);
+    return changed;
+}
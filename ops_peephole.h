@@ -0,0 +1,43 @@
+#ifndef OPS_PEEPHOLE_H
+#define OPS_PEEPHOLE_H
+
+#include "ops_program.h"
+
+// Набор правил оконной оптимизации
+struct PeepholeConfig {
+    bool removeRedundantJumps = true;  // mN j / mN jf сразу перед меткой mN:
+    bool threadJumps = true;           // переход на метку, за которой стоит mK j, - сразу на mK
+    bool dropIdentities = true;        // x 0 -, x 1 *, x 1 /, 1 x *
+    bool removePushPop = true;         // значение кладётся и сразу снимается; x x :=; пустые команды
+
+    // Все правила выключены
+    static PeepholeConfig none() {
+        PeepholeConfig config;
+        config.removeRedundantJumps = false;
+        config.threadJumps = false;
+        config.dropIdentities = false;
+        config.removePushPop = false;
+        return config;
+    }
+};
+
+// Оконная оптимизация ОПС между синтаксическим анализом и выполнением.
+// Работает по загруженной, но ещё не скомпонованной программе: метки - это
+// отдельные команды LABEL, поэтому окно правила никогда не пересекает точку входа
+class OPSPeephole {
+public:
+    explicit OPSPeephole(const PeepholeConfig& peepholeConfig = PeepholeConfig());
+
+    // Применяет правила до неподвижной точки; возвращает число удалённых команд
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    PeepholeConfig config;
+
+    bool removeRedundantJumps(OPSProgram& program) const;
+    bool threadJumps(OPSProgram& program) const;
+    bool dropIdentities(OPSProgram& program) const;
+    bool removePushPop(OPSProgram& program) const;
+};
+
+#endif // OPS_PEEPHOLE_H
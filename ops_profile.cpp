@@ -0,0 +1,117 @@
+#include "ops_profile.h"
+
+namespace {
+
+const char* tierName(ExecutionTier tier) {
+    return tier == ExecutionTier::NATIVE ? "машинный код" : "интерпретатор";
+}
+
+} // namespace
+
+void OPSProfile::prepare(const OPSProgram& program, bool promotable) {
+    clear();
+    const std::vector<Instruction>& code = program.code;
+    const size_t count = code.size();
+    executions.assign(count, 0);
+    if (count == 0) return;
+
+    // Цикл - цель обратного перехода (j или loop_next) до самого дальнего из них
+    std::vector<size_t> latches(count, NO_LOOP);
+    for (size_t pc = 0; pc < count; ++pc) {
+        const Instruction& ins = code[pc];
+        if (ins.op != OpCode::JUMP && ins.op != OpCode::LOOP_NEXT) continue;
+        size_t target = static_cast<size_t>(ins.a);
+        if (target > pc) continue;
+        if (latches[target] == NO_LOOP || latches[target] < pc) {
+            latches[target] = pc;
+        }
+    }
+    loopIndex.assign(count, NO_LOOP);
+    for (size_t pc = 0; pc < count; ++pc) {
+        if (latches[pc] == NO_LOOP) continue;
+        LoopProfile loop;
+        loop.header = pc;
+        loop.latch = latches[pc];
+        loop.promotable = promotable;
+        loopIndex[pc] = loopProfiles.size();
+        loopProfiles.push_back(loop);
+    }
+
+    // Начало блока: первая команда, цель перехода, команда после перехода
+    std::vector<bool> leader(count, false);
+    leader[0] = true;
+    for (size_t pc = 0; pc < count; ++pc) {
+        const Instruction& ins = code[pc];
+        if (ins.op != OpCode::JUMP && !isConditionalJump(ins.op)) continue;
+        if (static_cast<size_t>(ins.a) < count) leader[ins.a] = true;
+        if (pc + 1 < count) leader[pc + 1] = true;
+    }
+    for (size_t pc = 0; pc < count; ++pc) {
+        if (leader[pc]) blockStarts.push_back(pc);
+    }
+}
+
+void OPSProfile::clear() {
+    loopIndex.clear();
+    loopProfiles.clear();
+    blockStarts.clear();
+    executions.clear();
+    transitions.clear();
+}
+
+void OPSProfile::recordTransition(LoopProfile& loop, ExecutionTier to) {
+    TierTransition transition;
+    transition.header = loop.header;
+    transition.backEdge = loop.backEdges;
+    transition.from = loop.tier;
+    transition.to = to;
+    transitions.push_back(transition);
+    loop.tier = to;
+}
+
+void OPSProfile::print(const OPSProgram& program, uint64_t threshold, bool native, std::ostream& out) const {
+    out << "\n📊 ПРОФИЛЬ ВЫПОЛНЕНИЯ:" << std::endl;
+    if (native) {
+        out << "Порог перевода цикла в машинный код: " << threshold << " обратных переходов" << std::endl;
+    } else {
+        out << "JIT выключен: все циклы выполняет интерпретатор" << std::endl;
+    }
+
+    out << "Циклы:" << std::endl;
+    if (loopProfiles.empty()) {
+        out << "  (нет циклов)" << std::endl;
+    }
+    for (const LoopProfile& loop : loopProfiles) {
+        out << "  PC=" << loop.header << ".." << loop.latch
+            << ": обратных переходов в интерпретаторе - " << loop.backEdges
+            << ", уровень - " << tierName(loop.tier);
+        if (loop.tier == ExecutionTier::NATIVE) {
+            out << ", входов в машинный код - " << loop.nativeEntries
+                << ", выходов внутри цикла - " << loop.sideExits;
+            if (loop.refusedEntries > 0) {
+                out << ", отклонено входов - " << loop.refusedEntries;
+            }
+        } else if (loop.promotionAttempt > 0) {
+            out << " (не компилируется, попытка на " << loop.promotionAttempt << "-м переходе)";
+        }
+        out << std::endl;
+    }
+
+    out << "Переходы между уровнями:" << std::endl;
+    if (transitions.empty()) {
+        out << "  (нет)" << std::endl;
+    }
+    for (const TierTransition& transition : transitions) {
+        out << "  PC=" << transition.header << ": " << tierName(transition.from) << " → "
+            << tierName(transition.to) << " на " << transition.backEdge << "-м обратном переходе" << std::endl;
+    }
+
+    // Выполнения блока - выполнения его первой команды; команды машинного кода
+    // интерпретатор не видит, поэтому блоки горячего цикла считаются до перехода
+    out << "Базовые блоки (выполнений интерпретатором):" << std::endl;
+    for (size_t b = 0; b < blockStarts.size(); ++b) {
+        size_t begin = blockStarts[b];
+        size_t end = b + 1 < blockStarts.size() ? blockStarts[b + 1] : program.code.size();
+        out << "  PC=" << begin << ".." << end - 1 << ": " << executions[begin] << std::endl;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef OPS_PROFILE_H
+#define OPS_PROFILE_H
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "ops_program.h"
+
+// Уровень выполнения цикла
+enum class ExecutionTier {
+    INTERPRETER,  // команды ОПС (специализированные по типам и слитые при загрузке)
+    NATIVE        // машинный код x86-64 (OPSJit)
+};
+
+// Счётчики цикла скомпонованной программы: начало - цель обратного перехода
+// (j или loop_next), конец - самый дальний обратный переход на это начало
+struct LoopProfile {
+    size_t header = 0;
+    size_t latch = 0;
+    uint64_t backEdges = 0;        // обратных переходов, выполненных интерпретатором
+    ExecutionTier tier = ExecutionTier::INTERPRETER;
+    bool promotable = false;       // цикл ещё может перейти в машинный код
+    uint64_t promotionAttempt = 0; // на каком обратном переходе компилировался (0 - не компилировался)
+    uint64_t nativeEntries = 0;    // входов в машинный код в начале цикла
+    uint64_t sideExits = 0;        // выходов из машинного кода внутри цикла
+    uint64_t refusedEntries = 0;   // входов отклонено: тип элементов массива изменился
+};
+
+// Переход цикла на другой уровень выполнения
+struct TierTransition {
+    size_t header = 0;
+    uint64_t backEdge = 0;         // номер обратного перехода, на котором он случился
+    ExecutionTier from = ExecutionTier::INTERPRETER;
+    ExecutionTier to = ExecutionTier::INTERPRETER;
+};
+
+// Профиль выполнения: счётчики обратных переходов по циклам, выполнения
+// базовых блоков интерпретатором и переходы циклов между уровнями. По
+// счётчикам интерпретатор решает, когда цикл становится горячим
+class OPSProfile {
+public:
+    static constexpr size_t NO_LOOP = static_cast<size_t>(-1);
+
+    // Найти циклы и базовые блоки скомпонованной программы и обнулить счётчики
+    // (promotable - циклы могут переходить в машинный код)
+    void prepare(const OPSProgram& program, bool promotable);
+
+    // Забыть программу и счётчики
+    void clear();
+
+    // Номер цикла с началом в pc (NO_LOOP - pc не начало цикла)
+    size_t loopAt(size_t pc) const { return pc < loopIndex.size() ? loopIndex[pc] : NO_LOOP; }
+
+    LoopProfile& loop(size_t index) { return loopProfiles[index]; }
+    const std::vector<LoopProfile>& loops() const { return loopProfiles; }
+
+    // Команда pc выполнена интерпретатором (только ядро с профилем)
+    void countInstruction(size_t pc) { executions[pc]++; }
+
+    // Цикл перешёл на уровень to
+    void recordTransition(LoopProfile& loop, ExecutionTier to);
+
+    // Отчёт: циклы, переходы между уровнями и выполнения блоков
+    // (threshold - порог перевода цикла в машинный код)
+    void print(const OPSProgram& program, uint64_t threshold, bool native, std::ostream& out) const;
+
+private:
+    std::vector<size_t> loopIndex;           // номер цикла по его началу
+    std::vector<LoopProfile> loopProfiles;   // циклы в порядке начала
+    std::vector<size_t> blockStarts;         // первые команды базовых блоков
+    std::vector<uint64_t> executions;        // выполнений интерпретатором по командам
+    std::vector<TierTransition> transitions; // переходы между уровнями по времени
+};
+
+#endif // OPS_PROFILE_H
@@ -0,0 +1,452 @@
+#include "ops_program.h"
+#include <stdexcept>
+#include <cctype>
+#include <algorithm>
+
+OPSProgram OPSLoader::load(const std::vector<std::string>& commands) {
+    program = OPSProgram();
+    arrayNames.clear();
+    labelNames.clear();
+    variableSlots.clear();
+    arraySlots.clear();
+    labelSlots.clear();
+
+    // Первый проход: имена массивов и меток, чтобы различать роли идентификаторов
+    collectNames(commands);
+
+    // Стек ссылок на массивы: имя массива стоит перед индексами и разрешается
+    // в операнд ближайшей команды array_get/array_set/array_read
+    std::vector<int> pendingArrays;
+    const std::string none;
+
+    size_t i = 0;
+    while (i < commands.size()) {
+        const std::string& command = commands[i];
+        auto next = [&](size_t k) -> const std::string& {
+            return i + k < commands.size() ? commands[i + k] : none;
+        };
+        Instruction ins;
+
+        if (!command.empty() && command.back() == ':') {
+            // Метка в коде
+            ins.op = OpCode::LABEL;
+            ins.a = labelIndex(command.substr(0, command.length() - 1));
+            emit(ins, command);
+            i++;
+        }
+        else if (isTypeKeyword(command)) {
+            // Тип данных открывает объявление: type x declare(_assign) или type M n alloc_array
+            ins.type = parseType(command);
+            if (next(3) == "alloc_array") {
+                if (!isVariable(next(1))) {
+                    error("Неверное имя массива для выделения памяти: " + next(1), i);
+                }
+                if (!isNumber(next(2))) {
+                    error("Неверный размер массива: " + next(2), i);
+                }
+                ins.op = OpCode::ALLOC_ARRAY;
+                ins.a = arrayIndex(next(1));
+                ins.b = std::stoi(next(2));
+                if (ins.b < 0) {
+                    error("Неверный размер массива: " + next(2), i);
+                }
+                emit(ins, command + " " + next(1) + " " + next(2) + " alloc_array");
+                i += 4;
+            }
+            else if (next(4) == "alloc_array_2d") {
+                if (!isVariable(next(1))) {
+                    error("Неверное имя массива для выделения памяти: " + next(1), i);
+                }
+                if (!isNumber(next(2)) || !isNumber(next(3))) {
+                    error("Неверные размеры массива: " + next(2) + " x " + next(3), i);
+                }
+                ins.op = OpCode::ALLOC_ARRAY_2D;
+                ins.a = arrayIndex(next(1));
+                ins.b = std::stoi(next(2));
+                ins.c = std::stoi(next(3));
+                if (ins.b < 0 || ins.c < 0) {
+                    error("Неверные размеры массива: " + next(2) + " x " + next(3), i);
+                }
+                emit(ins, command + " " + next(1) + " " + next(2) + " " + next(3) + " alloc_array_2d");
+                i += 5;
+            }
+            else if (next(2) == "declare_assign" || next(2) == "declare") {
+                if (!isVariable(next(1))) {
+                    error("Неверное имя переменной для объявления: " + next(1), i);
+                }
+                ins.op = next(2) == "declare" ? OpCode::DECLARE : OpCode::DECLARE_ASSIGN;
+                ins.a = variableIndex(next(1));
+                emit(ins, command + " " + next(1) + " " + next(2));
+                i += 3;
+            }
+            else {
+                // Ключевое слово типа вне объявления - в стек не загружается
+                i++;
+            }
+        }
+        else if (isNumber(command)) {
+            // Целое число - непосредственное значение
+            ins.op = OpCode::PUSH_CONST;
+            ins.imm = Value(std::stoi(command));
+            emit(ins, command);
+            i++;
+        }
+        else if (isDoubleNumber(command)) {
+            // Число с плавающей точкой - непосредственное значение
+            ins.op = OpCode::PUSH_CONST;
+            ins.imm = Value(std::stod(command));
+            emit(ins, command);
+            i++;
+        }
+        else if (command == "+" || command == "-" || command == "*" || command == "/" ||
+                 command == ">" || command == "<" || command == "==") {
+            // Арифметическая операция или сравнение
+            if (command == "+") ins.op = OpCode::ADD;
+            else if (command == "-") ins.op = OpCode::SUB;
+            else if (command == "*") ins.op = OpCode::MUL;
+            else if (command == "/") ins.op = OpCode::DIV;
+            else if (command == ">") ins.op = OpCode::GT;
+            else if (command == "<") ins.op = OpCode::LT;
+            else ins.op = OpCode::EQ;
+            emit(ins, command);
+            i++;
+        }
+        else if (command == "w") {
+            ins.op = OpCode::WRITE;
+            emit(ins, command);
+            i++;
+        }
+        else if (command == "array_get" || command == "array_set" || command == "array_read" ||
+                 command == "array_get_2d" || command == "array_set_2d" || command == "array_read_2d") {
+            if (pendingArrays.empty()) {
+                error("Не найдено имя массива для команды " + command, i);
+            }
+            if (command == "array_get") ins.op = OpCode::ARRAY_GET;
+            else if (command == "array_set") ins.op = OpCode::ARRAY_SET;
+            else if (command == "array_read") ins.op = OpCode::ARRAY_READ;
+            else if (command == "array_get_2d") ins.op = OpCode::ARRAY_GET_2D;
+            else if (command == "array_set_2d") ins.op = OpCode::ARRAY_SET_2D;
+            else ins.op = OpCode::ARRAY_READ_2D;
+            ins.a = pendingArrays.back();
+            pendingArrays.pop_back();
+            emit(ins, program.arrays[ins.a] + " " + command);
+            i++;
+        }
+        else if (command == ":=" || command == "declare" || command == "declare_assign" ||
+                 command == "alloc_array" || command == "alloc_array_2d") {
+            // Цель команды должна была быть поглощена вместе с ней
+            error("Не найден операнд для команды " + command, i);
+        }
+        else if (isVariable(command)) {
+            if ((next(1) == "jf" || next(1) == "j") && labelNames.count(command)) {
+                // Метка - аргумент команды перехода
+                ins.op = next(1) == "jf" ? OpCode::JUMP_FALSE : OpCode::JUMP;
+                ins.a = labelIndex(command);
+                emit(ins, command + " " + next(1));
+                i += 2;
+            }
+            else if (next(1) == ":=") {
+                // Переменная перед := - цель присваивания
+                ins.op = OpCode::STORE;
+                ins.a = variableIndex(command);
+                emit(ins, command + " :=");
+                i += 2;
+            }
+            else if (next(1) == "r") {
+                // Переменная перед r - цель чтения
+                ins.op = OpCode::READ;
+                ins.a = variableIndex(command);
+                emit(ins, command + " r");
+                i += 2;
+            }
+            else if (arrayNames.count(command)) {
+                // Имя массива - операнд последующей команды доступа к элементу
+                pendingArrays.push_back(arrayIndex(command));
+                i++;
+            }
+            else {
+                // Обычная переменная - её значение помещается в стек
+                ins.op = OpCode::PUSH_VAR;
+                ins.a = variableIndex(command);
+                emit(ins, command);
+                i++;
+            }
+        }
+        else {
+            // Неизвестная команда сохраняется как пустая для трассировки
+            emit(ins, command);
+            i++;
+        }
+    }
+
+    return program;
+}
+
+void OPSLoader::collectNames(const std::vector<std::string>& commands) {
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const std::string& command = commands[i];
+        if (!command.empty() && command.back() == ':') {
+            labelNames.insert(command.substr(0, command.length() - 1));
+        } else if (command == "alloc_array" && i >= 2) {
+            arrayNames.insert(commands[i - 2]);
+        } else if (command == "alloc_array_2d" && i >= 3) {
+            arrayNames.insert(commands[i - 3]);
+        }
+    }
+}
+
+void OPSLoader::emit(const Instruction& instruction, const std::string& text) {
+    program.code.push_back(instruction);
+    program.text.push_back(text);
+}
+
+int OPSLoader::variableIndex(const std::string& name) {
+    auto it = variableSlots.find(name);
+    if (it != variableSlots.end()) return it->second;
+    program.variables.push_back(name);
+    return variableSlots[name] = static_cast<int>(program.variables.size() - 1);
+}
+
+int OPSLoader::arrayIndex(const std::string& name) {
+    auto it = arraySlots.find(name);
+    if (it != arraySlots.end()) return it->second;
+    program.arrays.push_back(name);
+    return arraySlots[name] = static_cast<int>(program.arrays.size() - 1);
+}
+
+int OPSLoader::labelIndex(const std::string& name) {
+    auto it = labelSlots.find(name);
+    if (it != labelSlots.end()) return it->second;
+    program.labels.push_back(name);
+    return labelSlots[name] = static_cast<int>(program.labels.size() - 1);
+}
+
+void OPSLoader::error(const std::string& message, size_t position) const {
+    throw std::runtime_error("Ошибка загрузки ОПС: " + message +
+                              " (позиция " + std::to_string(position) + ")");
+}
+
+bool OPSLoader::isNumber(const std::string& str) const {
+    if (str.empty()) return false;
+
+    size_t start = 0;
+    if (str[0] == '-' || str[0] == '+') {
+        start = 1;
+        if (str.length() == 1) return false;
+    }
+
+    for (size_t i = start; i < str.length(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(str[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OPSLoader::isDoubleNumber(const std::string& str) const {
+    if (str.empty()) return false;
+
+    size_t start = 0;
+    if (str[0] == '-' || str[0] == '+') {
+        start = 1;
+        if (str.length() == 1) return false;
+    }
+
+    bool hasDot = false;
+    for (size_t i = start; i < str.length(); ++i) {
+        if (str[i] == '.') {
+            if (hasDot) return false; // Вторая точка
+            hasDot = true;
+        } else if (!std::isdigit(static_cast<unsigned char>(str[i]))) {
+            return false;
+        }
+    }
+    return hasDot; // Должна быть точка для double
+}
+
+bool OPSLoader::isVariable(const std::string& str) const {
+    if (str.empty()) return false;
+    if (!std::isalpha(static_cast<unsigned char>(str[0])) && str[0] != '_') return false;
+
+    for (size_t i = 1; i < str.length(); ++i) {
+        if (!std::isalnum(static_cast<unsigned char>(str[i])) && str[i] != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OPSLoader::isTypeKeyword(const std::string& str) const {
+    return str == "int" || str == "float" || str == "double" || str == "char";
+}
+
+DataType OPSLoader::parseType(const std::string& str) const {
+    if (str == "float") return DataType::FLOAT;
+    if (str == "double") return DataType::DOUBLE;
+    if (str == "char") return DataType::CHAR;
+    return DataType::INT;
+}
+
+void OPSLinker::link(OPSProgram& program) const {
+    if (program.linked) return;
+
+    // Адрес метки - число обычных команд перед ней
+    std::vector<size_t> targets(program.labels.size(), 0);
+    std::vector<bool> defined(program.labels.size(), false);
+    size_t position = 0;
+    for (const Instruction& ins : program.code) {
+        if (ins.op == OpCode::LABEL) {
+            targets[ins.a] = position;
+            defined[ins.a] = true;
+        } else {
+            position++;
+        }
+    }
+
+    std::vector<Instruction> code;
+    std::vector<std::string> text;
+    code.reserve(position);
+    text.reserve(position);
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        Instruction ins = program.code[i];
+        if (ins.op == OpCode::LABEL) continue;
+        if (ins.op == OpCode::JUMP || isConditionalJump(ins.op)) {
+            if (!defined[ins.a]) {
+                throw std::runtime_error("Ошибка компоновки ОПС: метка не найдена: " + program.labels[ins.a]);
+            }
+            ins.a = static_cast<int>(targets[ins.a]);
+        }
+        code.push_back(ins);
+        text.push_back(program.text[i]);
+    }
+
+    program.code = std::move(code);
+    program.text = std::move(text);
+    program.labelTargets = std::move(targets);
+    program.linked = true;
+    program.maxStackDepth = computeMaxStackDepth(program);
+}
+
+size_t OPSLinker::computeMaxStackDepth(const OPSProgram& program) const {
+    const std::vector<Instruction>& code = program.code;
+    const size_t count = code.size();
+
+    // Для каждой команды - интервал возможных глубин стека на входе [low, high];
+    // low = -1 означает, что команда ещё не достигнута
+    std::vector<long> low(count, -1);
+    std::vector<long> high(count, -1);
+    std::vector<size_t> worklist;
+    // Каждая команда кладёт не больше одного значения, поэтому на пути без
+    // повторений глубина не превышает числа команд; больше - стек растёт в цикле
+    const long limit = static_cast<long>(count) + 1;
+    long maxDepth = 0;
+
+    auto propagate = [&](size_t target, long lo, long hi) {
+        if (target >= count) return;  // выход за конец программы - завершение
+        if (low[target] < 0) {
+            low[target] = lo;
+            high[target] = hi;
+        } else if (lo < low[target] || hi > high[target]) {
+            low[target] = std::min(low[target], lo);
+            high[target] = std::max(high[target], hi);
+        } else {
+            return;
+        }
+        worklist.push_back(target);
+    };
+
+    propagate(0, 0, 0);
+    while (!worklist.empty()) {
+        size_t pc = worklist.back();
+        worklist.pop_back();
+
+        const Instruction& ins = code[pc];
+        StackEffect effect = stackEffect(ins.op);
+        if (low[pc] < effect.pops) {
+            throw std::runtime_error("Ошибка компоновки ОПС: возможно опустошение стека в команде '" +
+                                     program.text[pc] + "' (позиция " + std::to_string(pc) + ")");
+        }
+        long lo = low[pc] - effect.pops + effect.pushes;
+        long hi = high[pc] - effect.pops + effect.pushes;
+        if (hi > limit) {
+            throw std::runtime_error("Ошибка компоновки ОПС: неограниченный рост стека в цикле (позиция " +
+                                     std::to_string(pc) + ")");
+        }
+        maxDepth = std::max(maxDepth, std::max(high[pc], hi));
+
+        if (ins.op == OpCode::JUMP) {
+            propagate(static_cast<size_t>(ins.a), lo, hi);
+        } else if (isConditionalJump(ins.op)) {
+            propagate(pc + 1, lo, hi);
+            propagate(static_cast<size_t>(ins.a), lo, hi);
+        } else {
+            propagate(pc + 1, lo, hi);
+        }
+    }
+
+    return static_cast<size_t>(maxDepth);
+}
+
+StackEffect stackEffect(OpCode op) {
+    switch (op) {
+        case OpCode::PUSH_CONST:
+        case OpCode::PUSH_VAR:       return {0, 1};
+        case OpCode::POP:
+        case OpCode::STORE:
+        case OpCode::DECLARE_ASSIGN:
+        case OpCode::JUMP_FALSE:
+        case OpCode::WRITE:
+        case OpCode::ARRAY_READ:     return {1, 0};
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::DIV:
+        case OpCode::GT:
+        case OpCode::LT:
+        case OpCode::EQ:
+        case OpCode::ADD_I32:
+        case OpCode::SUB_I32:
+        case OpCode::MUL_I32:
+        case OpCode::DIV_I32:
+        case OpCode::ADD_F64:
+        case OpCode::SUB_F64:
+        case OpCode::MUL_F64:
+        case OpCode::DIV_F64:
+        case OpCode::GT_I32:
+        case OpCode::LT_I32:
+        case OpCode::EQ_I32:
+        case OpCode::GT_F64:
+        case OpCode::LT_F64:
+        case OpCode::EQ_F64:
+        case OpCode::ARRAY_GET_2D:
+        case OpCode::ARRAY_GET_2D_UNCHECKED: return {2, 1};
+        case OpCode::TEE:
+        case OpCode::ARRAY_GET:
+        case OpCode::ARRAY_GET_UNCHECKED: return {1, 1};
+        case OpCode::LOOP_INIT:      return {1, 0};
+        case OpCode::LOAD_ELEM_VAR_INDEX:
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+        case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED: return {0, 1};
+        case OpCode::ARRAY_SET:
+        case OpCode::ARRAY_SET_UNCHECKED:
+        case OpCode::ARRAY_READ_2D:  return {2, 0};
+        case OpCode::ARRAY_SET_2D:
+        case OpCode::ARRAY_SET_2D_UNCHECKED: return {3, 0};
+        default:                     return {0, 0};
+    }
+}
+
+bool isTemporaryName(const std::string& name) {
+    return !name.empty() && name[0] == '$';
+}
+
+std::string temporaryName(size_t index) {
+    return "$t" + std::to_string(index);
+}
+
+bool isConditionalJump(OpCode op) {
+    return op == OpCode::JUMP_FALSE || op == OpCode::CMP_VAR_VAR_JF || op == OpCode::CMP_VAR_CONST_JF ||
+           op == OpCode::LOOP_INIT || op == OpCode::LOOP_NEXT ||
+           op == OpCode::GUARD_INDEX || op == OpCode::GUARD_ROW || op == OpCode::GUARD_COL;
+}
@@ -0,0 +1,165 @@
+#ifndef OPS_PROGRAM_H
+#define OPS_PROGRAM_H
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include "ops_value.h"
+
+// Коды операций декодированной ОПС
+enum class OpCode {
+    NOP,            // пустая команда (нераспознанная лексема)
+    POP,            // снять значение со стека (создаётся оптимизатором)
+    TEE,            // сохранить вершину стека в переменной, не снимая её (создаётся оптимизатором)
+    LABEL,          // метка (mN:)
+    PUSH_CONST,     // поместить непосредственное значение в стек
+    PUSH_VAR,       // поместить значение переменной в стек
+    STORE,          // присваивание (x :=)
+    DECLARE,        // объявление переменной (type x declare)
+    DECLARE_ASSIGN, // объявление с присваиванием (type x declare_assign)
+    ADD,            // +
+    SUB,            // -
+    MUL,            // *
+    DIV,            // /
+    GT,             // >
+    LT,             // <
+    EQ,             // ==
+    JUMP,           // безусловный переход (mN j)
+    JUMP_FALSE,     // условный переход (mN jf)
+    READ,           // чтение в переменную (x r)
+    WRITE,          // вывод значения (w)
+    ALLOC_ARRAY,    // выделение памяти массива (alloc_array)
+    ARRAY_GET,      // получение элемента массива (array_get)
+    ARRAY_SET,      // установка элемента массива (array_set)
+    ARRAY_READ,     // чтение в элемент массива (array_read)
+    ALLOC_ARRAY_2D, // выделение памяти 2D массива (alloc_array_2d)
+    ARRAY_GET_2D,   // получение элемента 2D массива (array_get_2d)
+    ARRAY_SET_2D,   // установка элемента 2D массива (array_set_2d)
+    ARRAY_READ_2D,  // чтение в элемент 2D массива (array_read_2d)
+
+    // Специализированные команды: типы операндов доказаны выводом типов
+    ADD_I32, SUB_I32, MUL_I32, DIV_I32,   // целочисленная арифметика
+    ADD_F64, SUB_F64, MUL_F64, DIV_F64,   // вещественная арифметика
+    GT_I32, LT_I32, EQ_I32,               // сравнение целых
+    GT_F64, LT_F64, EQ_F64,               // сравнение вещественных
+
+    // Суперкоманды: слитые последовательности, типичные для кода разборщика
+    INC_VAR,            // x c + x :=      (a - переменная, imm - константа, fused - + или -)
+    CMP_VAR_VAR_JF,     // x y < mN jf     (a - адрес перехода, b, c - переменные, fused - сравнение)
+    CMP_VAR_CONST_JF,   // x c < mN jf     (a - адрес перехода, b - переменная, imm - константа)
+    LOAD_ELEM_VAR_INDEX, // i arr array_get (a - массив, b - переменная-индекс)
+    LOAD_ELEM_VAR_INDEX_TEE, // i arr array_get $t tee (то же, c - временная переменная для результата)
+
+    // Цикл со счётчиком: for (int i = a; i < n; i = i + s) после распознавания
+    // индуктивной переменной (b - переменная цикла, c - номер счётчика,
+    // imm - шаг, fused - сравнение условия < или >)
+    LOOP_INIT,          // граница в стеке: число итераций в счётчик, 0 - переход на выход (a)
+    LOOP_NEXT,          // i += шаг; пока счётчик не исчерпан - переход на начало тела (a)
+
+    // Обращения к массивам без проверки границ: индекс доказанно в диапазоне
+    // (индуктивная переменная цикла, проверенная охраной перед циклом)
+    ARRAY_GET_UNCHECKED,
+    ARRAY_SET_UNCHECKED,
+    ARRAY_GET_2D_UNCHECKED,
+    ARRAY_SET_2D_UNCHECKED,
+    LOAD_ELEM_VAR_INDEX_UNCHECKED,
+    LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED,
+
+    // Охрана цикла со счётчиком: все значения i + imm (c - номер счётчика)
+    // лежат в границах массива b, иначе переход на проверяемую копию цикла (a)
+    GUARD_INDEX,        // размер одномерного массива
+    GUARD_ROW,          // число строк 2D массива
+    GUARD_COL           // число столбцов 2D массива
+};
+
+// Объявленный тип переменной или элементов массива
+enum class DataType {
+    INT,
+    FLOAT,
+    DOUBLE,
+    CHAR
+};
+
+// Декодированная команда ОПС
+struct Instruction {
+    OpCode op = OpCode::NOP;
+    DataType type = DataType::INT; // тип для объявлений и выделения памяти
+    int a = 0;                     // индекс переменной, массива, метки (после компоновки - адрес перехода)
+    int b = 0;                     // размер массива (число строк для 2D)
+    int c = 0;                     // число столбцов 2D массива
+    Value imm;                     // непосредственное значение для PUSH_CONST
+    OpCode fused = OpCode::NOP;    // операция внутри суперкоманды
+};
+
+// Программа ОПС после загрузки: команды и таблицы имён
+struct OPSProgram {
+    std::vector<Instruction> code;       // декодированные команды
+    std::vector<std::string> text;       // исходная запись каждой команды (для трассировки)
+    std::vector<std::string> variables;  // таблица переменных (индекс = номер ячейки кадра)
+    std::vector<std::string> arrays;     // таблица массивов
+    std::vector<std::string> labels;     // таблица меток
+    std::vector<size_t> labelTargets;    // адреса меток после компоновки
+    bool linked = false;                 // метки разрешены в адреса переходов
+    bool prepared = false;               // специализирована по типам и слита (образ .opsb)
+    size_t maxStackDepth = 0;            // наибольшая глубина стека операндов (вычисляется при компоновке)
+    size_t loopCounters = 0;             // число счётчиков циклов LOOP_INIT / LOOP_NEXT
+};
+
+// Временные переменные оптимизатора ($t0, $t1, ...): в исходном коде такие
+// имена невозможны, в итоговом состоянии интерпретатора они не показываются
+bool isTemporaryName(const std::string& name);
+std::string temporaryName(size_t index);
+
+// Действие команды на стек операндов: сколько снимает и сколько кладёт
+struct StackEffect {
+    int pops;
+    int pushes;
+};
+
+StackEffect stackEffect(OpCode op);
+
+// Команда с условным переходом по адресу в поле a (jf, слитые сравнения, циклы со
+// счётчиком, охрана границ)
+bool isConditionalJump(OpCode op);
+
+// Загрузчик: переводит текстовую ОПС в декодированную программу
+class OPSLoader {
+public:
+    OPSProgram load(const std::vector<std::string>& commands);
+
+private:
+    OPSProgram program;
+    std::unordered_set<std::string> arrayNames;  // имена, объявленные через alloc_array(_2d)
+    std::unordered_set<std::string> labelNames;  // имена, определённые как метки (mN:)
+    std::unordered_map<std::string, int> variableSlots; // имя → номер ячейки кадра
+    std::unordered_map<std::string, int> arraySlots;    // имя → номер массива
+    std::unordered_map<std::string, int> labelSlots;    // имя → номер метки
+
+    // Вспомогательные методы
+    void collectNames(const std::vector<std::string>& commands);
+    void emit(const Instruction& instruction, const std::string& text);
+    int variableIndex(const std::string& name);
+    int arrayIndex(const std::string& name);
+    int labelIndex(const std::string& name);
+    void error(const std::string& message, size_t position) const;
+
+    bool isNumber(const std::string& str) const;       // Проверка на целое число
+    bool isDoubleNumber(const std::string& str) const; // Проверка на число с плавающей точкой
+    bool isVariable(const std::string& str) const;     // Проверка на идентификатор
+    bool isTypeKeyword(const std::string& str) const;  // int, float, double, char
+    DataType parseType(const std::string& str) const;
+};
+
+// Компоновщик: разрешает метки в абсолютные адреса и убирает их из потока команд
+class OPSLinker {
+public:
+    void link(OPSProgram& program) const;
+
+    // Абстрактная интерпретация глубины стека по графу переходов:
+    // доказывает отсутствие опустошения и находит наибольшую глубину
+    // (скомпонованной программы; загрузчик образа проверяет ею заголовок)
+    size_t computeMaxStackDepth(const OPSProgram& program) const;
+};
+
+#endif // OPS_PROGRAM_H
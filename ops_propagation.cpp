@@ -0,0 +1,321 @@
+#include "ops_propagation.h"
+#include <charconv>
+#include <climits>
+
+namespace {
+
+// Абстрактное значение на стеке операндов внутри блока
+struct StackSlot {
+    enum Kind { UNKNOWN, CONSTANT, VARIABLE } kind = UNKNOWN;
+    Value constant;
+    int variable = -1;  // значение переменной на момент помещения в стек
+};
+
+bool isFoldable(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL || op == OpCode::DIV ||
+           op == OpCode::GT || op == OpCode::LT || op == OpCode::EQ;
+}
+
+bool isZero(const Value& value) {
+    return (value.isInt() && value.asInt() == 0) || (value.isDouble() && value.asDouble() == 0.0);
+}
+
+// Вычисление операции над константами по правилам интерпретатора.
+// Деление на ноль и переполнение int не сворачиваются: ошибка или
+// поведение должны остаться во время выполнения
+bool evaluate(OpCode op, const Value& a, const Value& b, Value& result) {
+    bool useDouble = a.isDouble() || b.isDouble();
+    switch (op) {
+        case OpCode::GT:
+            result = Value(useDouble ? (a.asDouble() > b.asDouble() ? 1 : 0) : (a.asInt() > b.asInt() ? 1 : 0));
+            return true;
+        case OpCode::LT:
+            result = Value(useDouble ? (a.asDouble() < b.asDouble() ? 1 : 0) : (a.asInt() < b.asInt() ? 1 : 0));
+            return true;
+        case OpCode::EQ:
+            result = Value(useDouble ? (a.asDouble() == b.asDouble() ? 1 : 0) : (a.asInt() == b.asInt() ? 1 : 0));
+            return true;
+        case OpCode::DIV:
+            if (isZero(b)) return false;
+            break;
+        default:
+            break;
+    }
+
+    if (useDouble) {
+        if (op == OpCode::ADD) result = a + b;
+        else if (op == OpCode::SUB) result = a - b;
+        else if (op == OpCode::MUL) result = a * b;
+        else result = a / b;
+        return true;
+    }
+
+    long long x = a.asInt();
+    long long y = b.asInt();
+    long long value;
+    if (op == OpCode::ADD) value = x + y;
+    else if (op == OpCode::SUB) value = x - y;
+    else if (op == OpCode::MUL) value = x * y;
+    else value = x / y;
+    if (value < INT_MIN || value > INT_MAX) return false;
+    result = Value(static_cast<int>(value));
+    return true;
+}
+
+// Запись константы в тексте ОПС: вещественные всегда с точкой
+std::string constantText(const Value& value) {
+    if (value.isInt()) return std::to_string(value.asInt());
+    char buffer[64];
+    auto converted = std::to_chars(buffer, buffer + sizeof(buffer), value.asDouble());
+    std::string text(buffer, converted.ptr);
+    if (text.find_first_of(".en") == std::string::npos) text += ".0";
+    return text;
+}
+
+Value declaredValue(DataType type, const Value& value) {
+    if (type == DataType::INT) return Value(value.asInt());
+    if (type == DataType::DOUBLE || type == DataType::FLOAT) return Value(value.asDouble());
+    return value;
+}
+
+} // namespace
+
+bool OPSPropagation::VarState::operator==(const VarState& other) const {
+    if (kind != other.kind) return false;
+    if (kind == COPY) return source == other.source;
+    if (kind == CONSTANT) {
+        if (constant.isInt() != other.constant.isInt()) return false;
+        return constant.isInt() ? constant.asInt() == other.constant.asInt()
+                                : constant.asDouble() == other.constant.asDouble();
+    }
+    return true;
+}
+
+size_t OPSPropagation::optimize(OPSProgram& program) const {
+    // Метки нужны для построения графа - скомпонованную программу не трогаем
+    if (program.linked) return 0;
+
+    // Подстановка констант открывает свёртку, свёртка - новые константы
+    size_t total = 0;
+    while (true) {
+        size_t changed = propagate(program);
+        changed += fold(program);
+        if (changed == 0) break;
+        total += changed;
+    }
+    return total;
+}
+
+size_t OPSPropagation::propagate(OPSProgram& program) const {
+    ControlFlowGraph graph = ControlFlowGraph::build(program);
+    if (graph.blocks.empty()) return 0;
+
+    // Итеративный анализ вперёд: состояние на входе блока - встреча состояний
+    // на выходах уже обработанных предшественников
+    const size_t blockCount = graph.blocks.size();
+    std::vector<std::vector<VarState>> entry(blockCount);
+    std::vector<bool> reached(blockCount, false);
+    entry[0].assign(program.variables.size(), VarState());
+    reached[0] = true;
+
+    std::vector<size_t> worklist = {0};
+    std::vector<bool> queued(blockCount, false);
+    queued[0] = true;
+    while (!worklist.empty()) {
+        size_t b = worklist.back();
+        worklist.pop_back();
+        queued[b] = false;
+
+        std::vector<VarState> state = entry[b];
+        walkBlock(program, graph.blocks[b], state, false);
+
+        for (size_t successor : graph.blocks[b].successors) {
+            bool changed = false;
+            if (!reached[successor]) {
+                entry[successor] = state;
+                reached[successor] = true;
+                changed = true;
+            } else {
+                for (size_t v = 0; v < state.size(); ++v) {
+                    VarState& target = entry[successor][v];
+                    if (target.kind != VarState::NAC && !(target == state[v])) {
+                        target = VarState();
+                        changed = true;
+                    }
+                }
+            }
+            if (changed && !queued[successor]) {
+                worklist.push_back(successor);
+                queued[successor] = true;
+            }
+        }
+    }
+
+    // Замена операндов по найденным состояниям; недостижимые блоки не трогаются
+    size_t rewritten = 0;
+    for (size_t b = 0; b < blockCount; ++b) {
+        if (!reached[b]) continue;
+        std::vector<VarState> state = entry[b];
+        rewritten += walkBlock(program, graph.blocks[b], state, true);
+    }
+    return rewritten;
+}
+
+size_t OPSPropagation::walkBlock(OPSProgram& program, const ControlFlowGraph::Block& block,
+                                 std::vector<VarState>& state, bool rewrite) const {
+    std::vector<StackSlot> stack;
+    auto pop = [&]() {
+        if (stack.empty()) return StackSlot();  // значение пришло из другого блока
+        StackSlot slot = stack.back();
+        stack.pop_back();
+        return slot;
+    };
+
+    // Переменная x получает новое значение: копии x и её значения в стеке устаревают
+    auto kill = [&](int x) {
+        for (VarState& var : state) {
+            if (var.kind == VarState::COPY && var.source == x) var = VarState();
+        }
+        for (StackSlot& slot : stack) {
+            if (slot.kind == StackSlot::VARIABLE && slot.variable == x) slot = StackSlot();
+        }
+    };
+
+    size_t rewritten = 0;
+    for (size_t i = block.begin; i < block.end; ++i) {
+        Instruction& ins = program.code[i];
+        switch (ins.op) {
+            case OpCode::PUSH_CONST: {
+                StackSlot slot;
+                slot.kind = StackSlot::CONSTANT;
+                slot.constant = ins.imm;
+                stack.push_back(slot);
+                break;
+            }
+            case OpCode::PUSH_VAR: {
+                const VarState& var = state[ins.a];
+                StackSlot slot;
+                if (var.kind == VarState::CONSTANT) {
+                    slot.kind = StackSlot::CONSTANT;
+                    slot.constant = var.constant;
+                    if (rewrite) {
+                        ins = Instruction();
+                        ins.op = OpCode::PUSH_CONST;
+                        ins.imm = slot.constant;
+                        program.text[i] = constantText(slot.constant);
+                        rewritten++;
+                    }
+                } else {
+                    slot.kind = StackSlot::VARIABLE;
+                    slot.variable = var.kind == VarState::COPY ? var.source : ins.a;
+                    if (rewrite && slot.variable != ins.a) {
+                        ins.a = slot.variable;
+                        program.text[i] = program.variables[slot.variable];
+                        rewritten++;
+                    }
+                }
+                stack.push_back(slot);
+                break;
+            }
+            case OpCode::STORE:
+            case OpCode::TEE: {
+                StackSlot value = pop();
+                if (ins.op == OpCode::TEE) stack.push_back(value);
+                if (value.kind == StackSlot::VARIABLE && value.variable == ins.a) break;  // x x :=
+                kill(ins.a);
+                VarState& var = state[ins.a];
+                var = VarState();
+                if (value.kind == StackSlot::CONSTANT) {
+                    var.kind = VarState::CONSTANT;
+                    var.constant = value.constant;
+                } else if (value.kind == StackSlot::VARIABLE) {
+                    var.kind = VarState::COPY;
+                    var.source = value.variable;
+                }
+                break;
+            }
+            case OpCode::DECLARE_ASSIGN: {
+                // Значение приводится к объявленному типу - копия переменной
+                // другого типа не была бы точной, поэтому отслеживаются только константы
+                StackSlot value = pop();
+                kill(ins.a);
+                VarState& var = state[ins.a];
+                var = VarState();
+                if (value.kind == StackSlot::CONSTANT) {
+                    var.kind = VarState::CONSTANT;
+                    var.constant = declaredValue(ins.type, value.constant);
+                }
+                break;
+            }
+            case OpCode::DECLARE: {
+                kill(ins.a);
+                VarState& var = state[ins.a];
+                var = VarState();
+                var.kind = VarState::CONSTANT;
+                var.constant = declaredValue(ins.type, Value(0));
+                break;
+            }
+            case OpCode::READ:
+                kill(ins.a);
+                state[ins.a] = VarState();
+                break;
+            default: {
+                StackEffect effect = stackEffect(ins.op);
+                for (int k = 0; k < effect.pops; ++k) pop();
+                for (int k = 0; k < effect.pushes; ++k) stack.push_back(StackSlot());
+                break;
+            }
+        }
+    }
+    return rewritten;
+}
+
+size_t OPSPropagation::fold(OPSProgram& program) const {
+    std::vector<Instruction> code;
+    std::vector<std::string> text;
+    code.reserve(program.code.size());
+    text.reserve(program.text.size());
+    size_t folded = 0;
+
+    // Свёртка по уже сокращённому потоку: 1 2 + 3 * сворачивается в цепочку
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        const Instruction& ins = program.code[i];
+        size_t n = code.size();
+
+        if (isFoldable(ins.op) && n >= 2 &&
+            code[n - 2].op == OpCode::PUSH_CONST && code[n - 1].op == OpCode::PUSH_CONST) {
+            Value result;
+            if (evaluate(ins.op, code[n - 2].imm, code[n - 1].imm, result)) {
+                code.pop_back();
+                text.pop_back();
+                code.back().imm = result;
+                text.back() = constantText(result);
+                folded++;
+                continue;
+            }
+        }
+
+        // Условие перехода известно: 0 mN jf → mN j; 1 mN jf → (ничего)
+        if (ins.op == OpCode::JUMP_FALSE && n >= 1 && code[n - 1].op == OpCode::PUSH_CONST) {
+            bool jump = isZero(code[n - 1].imm);
+            code.pop_back();
+            text.pop_back();
+            if (jump) {
+                Instruction branch;
+                branch.op = OpCode::JUMP;
+                branch.a = ins.a;
+                code.push_back(branch);
+                text.push_back(program.labels[ins.a] + " j");
+            }
+            folded++;
+            continue;
+        }
+
+        code.push_back(ins);
+        text.push_back(program.text[i]);
+    }
+
+    program.code = std::move(code);
+    program.text = std::move(text);
+    return folded;
+}
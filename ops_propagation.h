@@ -0,0 +1,33 @@
+#ifndef OPS_PROPAGATION_H
+#define OPS_PROPAGATION_H
+
+#include <vector>
+#include "ops_cfg.h"
+
+// Распространение констант и копий по графу потока управления с последующей
+// свёрткой: x := 5 ... x → 5; y := x ... y → x; 2 3 + → 5; 1 mN jf → (ничего).
+// Работает по нескомпонованной программе (до оконной оптимизации)
+class OPSPropagation {
+public:
+    // Возвращает число изменённых команд
+    size_t optimize(OPSProgram& program) const;
+
+private:
+    // Абстрактное значение переменной
+    struct VarState {
+        enum Kind { NAC, CONSTANT, COPY } kind = NAC;   // NAC - значение неизвестно
+        Value constant;
+        int source = -1;                                // для COPY - переменная-источник
+
+        bool operator==(const VarState& other) const;
+    };
+
+    size_t propagate(OPSProgram& program) const;
+    size_t fold(OPSProgram& program) const;
+
+    // Проход по блоку: переход состояния; при rewrite - замена операндов
+    size_t walkBlock(OPSProgram& program, const ControlFlowGraph::Block& block,
+                     std::vector<VarState>& state, bool rewrite) const;
+};
+
+#endif // OPS_PROPAGATION_H
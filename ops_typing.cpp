@@ -0,0 +1,326 @@
+#include "ops_typing.h"
+
+namespace {
+
+StaticType join(StaticType a, StaticType b) {
+    if (a == StaticType::NONE) return b;
+    if (b == StaticType::NONE || a == b) return a;
+    return StaticType::DYNAMIC;
+}
+
+StaticType typeOf(const Value& value) {
+    return value.isInt() ? StaticType::INT : StaticType::DOUBLE;
+}
+
+StaticType declaredType(DataType type) {
+    return (type == DataType::DOUBLE || type == DataType::FLOAT) ? StaticType::DOUBLE : StaticType::INT;
+}
+
+// Чтение ещё не определённого значения (например, массива до alloc_array)
+// во время выполнения - ошибка, статически считаем его динамическим
+StaticType loaded(StaticType type) {
+    return type == StaticType::NONE ? StaticType::DYNAMIC : type;
+}
+
+bool isArithmetic(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL || op == OpCode::DIV;
+}
+
+bool isComparison(OpCode op) {
+    return op == OpCode::GT || op == OpCode::LT || op == OpCode::EQ;
+}
+
+OpCode specializedInt(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: return OpCode::ADD_I32;
+        case OpCode::SUB: return OpCode::SUB_I32;
+        case OpCode::MUL: return OpCode::MUL_I32;
+        case OpCode::DIV: return OpCode::DIV_I32;
+        case OpCode::GT:  return OpCode::GT_I32;
+        case OpCode::LT:  return OpCode::LT_I32;
+        default:          return OpCode::EQ_I32;
+    }
+}
+
+OpCode specializedDouble(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: return OpCode::ADD_F64;
+        case OpCode::SUB: return OpCode::SUB_F64;
+        case OpCode::MUL: return OpCode::MUL_F64;
+        case OpCode::DIV: return OpCode::DIV_F64;
+        case OpCode::GT:  return OpCode::GT_F64;
+        case OpCode::LT:  return OpCode::LT_F64;
+        default:          return OpCode::EQ_F64;
+    }
+}
+
+} // namespace
+
+bool OPSTypeInference::analyze(const OPSProgram& program, const std::vector<Value>& initialFrame) {
+    const size_t count = program.code.size();
+    states.assign(count, State());
+    consistent = true;
+    if (count == 0) return false;
+
+    // Начальное состояние: типы переменных берутся из кадра, массивы не выделены
+    State entry;
+    entry.reached = true;
+    entry.variables.assign(program.variables.size(), StaticType::INT);
+    for (size_t i = 0; i < initialFrame.size() && i < entry.variables.size(); ++i) {
+        entry.variables[i] = typeOf(initialFrame[i]);
+    }
+    entry.arrays.assign(program.arrays.size(), StaticType::NONE);
+    entry.arrays2D.assign(program.arrays.size(), StaticType::NONE);
+
+    std::vector<size_t> worklist;
+    merge(states[0], entry);
+    worklist.push_back(0);
+
+    while (!worklist.empty() && consistent) {
+        size_t pc = worklist.back();
+        worklist.pop_back();
+
+        const Instruction& ins = program.code[pc];
+        State out = states[pc];
+        transfer(ins, pc, out);
+
+        std::vector<size_t> successors;
+        if (ins.op == OpCode::JUMP) {
+            successors.push_back(static_cast<size_t>(ins.a));
+        } else {
+            successors.push_back(pc + 1);
+            if (isConditionalJump(ins.op)) {
+                successors.push_back(static_cast<size_t>(ins.a));
+            }
+        }
+        for (size_t target : successors) {
+            if (target < count && merge(states[target], out)) {
+                worklist.push_back(target);
+            }
+        }
+    }
+
+    return consistent;
+}
+
+size_t OPSTypeInference::specialize(OPSProgram& program, const std::vector<Value>& initialFrame) {
+    const size_t count = program.code.size();
+
+    // Глубина стека различается на разных путях - специализация небезопасна
+    if (!analyze(program, initialFrame)) return 0;
+
+    // Сколько команд снимает значение, положенное каждой PUSH_CONST:
+    // константу можно перевести в double, только если потребитель у неё один
+    std::vector<int> consumers(count, 0);
+    for (size_t pc = 0; pc < count; ++pc) {
+        const State& state = states[pc];
+        if (!state.reached) continue;
+        int pops = stackEffect(program.code[pc].op).pops;
+        for (int i = 0; i < pops; ++i) {
+            int producer = state.producers[state.producers.size() - 1 - i];
+            if (producer >= 0) consumers[producer]++;
+        }
+    }
+
+    size_t specialized = 0;
+    for (size_t pc = 0; pc < count; ++pc) {
+        Instruction& ins = program.code[pc];
+        const State& state = states[pc];
+        if (!state.reached || !(isArithmetic(ins.op) || isComparison(ins.op))) continue;
+
+        size_t depth = state.stack.size();
+        StaticType left = state.stack[depth - 2];
+        StaticType right = state.stack[depth - 1];
+
+        if (left == StaticType::INT && right == StaticType::INT) {
+            ins.op = specializedInt(ins.op);
+            specialized++;
+            continue;
+        }
+
+        // Смешанный случай с целой константой: операция всё равно выполняется
+        // в double, поэтому константа заранее переводится в double
+        int promote = -1;
+        if (left == StaticType::DOUBLE && right == StaticType::INT) {
+            promote = state.producers[depth - 1];
+        } else if (left == StaticType::INT && right == StaticType::DOUBLE) {
+            promote = state.producers[depth - 2];
+        } else if (left != StaticType::DOUBLE || right != StaticType::DOUBLE) {
+            continue;
+        }
+        if (promote >= 0) {
+            if (consumers[promote] != 1) continue;
+            Instruction& constant = program.code[promote];
+            constant.imm = Value(constant.imm.asDouble());
+        } else if (left != right) {
+            continue;
+        }
+        ins.op = specializedDouble(ins.op);
+        specialized++;
+    }
+
+    states.clear();
+    return specialized;
+}
+
+bool OPSTypeInference::merge(State& target, const State& incoming) {
+    if (!target.reached) {
+        target = incoming;
+        return true;
+    }
+    if (target.stack.size() != incoming.stack.size()) {
+        consistent = false;
+        return false;
+    }
+
+    bool changed = false;
+    auto joinAll = [&changed](std::vector<StaticType>& into, const std::vector<StaticType>& from) {
+        for (size_t i = 0; i < into.size(); ++i) {
+            StaticType joined = join(into[i], from[i]);
+            if (joined != into[i]) {
+                into[i] = joined;
+                changed = true;
+            }
+        }
+    };
+    joinAll(target.variables, incoming.variables);
+    joinAll(target.arrays, incoming.arrays);
+    joinAll(target.arrays2D, incoming.arrays2D);
+    joinAll(target.stack, incoming.stack);
+    for (size_t i = 0; i < target.producers.size(); ++i) {
+        if (target.producers[i] != incoming.producers[i] && target.producers[i] != -1) {
+            target.producers[i] = -1;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void OPSTypeInference::transfer(const Instruction& ins, size_t pc, State& state) const {
+    auto pop = [&state]() {
+        StaticType type = state.stack.back();
+        state.stack.pop_back();
+        state.producers.pop_back();
+        return type;
+    };
+    auto push = [&state](StaticType type, int producer) {
+        state.stack.push_back(type);
+        state.producers.push_back(producer);
+    };
+
+    switch (ins.op) {
+        case OpCode::PUSH_CONST:
+            push(typeOf(ins.imm), static_cast<int>(pc));
+            break;
+        case OpCode::PUSH_VAR:
+            push(state.variables[ins.a], -1);
+            break;
+        case OpCode::STORE:
+            state.variables[ins.a] = pop();
+            break;
+        case OpCode::TEE:
+            state.variables[ins.a] = state.stack.back();
+            break;
+        case OpCode::DECLARE:
+            state.variables[ins.a] = declaredType(ins.type);
+            break;
+        case OpCode::DECLARE_ASSIGN: {
+            StaticType value = pop();
+            // char сохраняет значение как есть
+            state.variables[ins.a] = ins.type == DataType::CHAR ? value : declaredType(ins.type);
+            break;
+        }
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV: {
+            StaticType right = pop();
+            StaticType left = pop();
+            // Хотя бы один double - результат double; оба int - int
+            if (left == StaticType::DOUBLE || right == StaticType::DOUBLE) {
+                push(StaticType::DOUBLE, -1);
+            } else if (left == StaticType::INT && right == StaticType::INT) {
+                push(StaticType::INT, -1);
+            } else {
+                push(StaticType::DYNAMIC, -1);
+            }
+            break;
+        }
+        case OpCode::ADD_I32: case OpCode::SUB_I32: case OpCode::MUL_I32: case OpCode::DIV_I32:
+            pop(); pop();
+            push(StaticType::INT, -1);
+            break;
+        case OpCode::ADD_F64: case OpCode::SUB_F64: case OpCode::MUL_F64: case OpCode::DIV_F64:
+            pop(); pop();
+            push(StaticType::DOUBLE, -1);
+            break;
+        case OpCode::GT: case OpCode::LT: case OpCode::EQ:
+        case OpCode::GT_I32: case OpCode::LT_I32: case OpCode::EQ_I32:
+        case OpCode::GT_F64: case OpCode::LT_F64: case OpCode::EQ_F64:
+            pop(); pop();
+            push(StaticType::INT, -1);
+            break;
+        case OpCode::POP:
+        case OpCode::JUMP_FALSE:
+        case OpCode::WRITE:
+            pop();
+            break;
+        case OpCode::READ:
+            state.variables[ins.a] = StaticType::DOUBLE;
+            break;
+        case OpCode::INC_VAR: {
+            StaticType& variable = state.variables[ins.a];
+            if (variable == StaticType::DOUBLE || ins.imm.isDouble()) {
+                variable = StaticType::DOUBLE;
+            } else if (variable != StaticType::INT) {
+                variable = StaticType::DYNAMIC;
+            }
+            break;
+        }
+        case OpCode::LOAD_ELEM_VAR_INDEX:
+        case OpCode::LOAD_ELEM_VAR_INDEX_UNCHECKED:
+            push(loaded(state.arrays[ins.a]), -1);
+            break;
+        case OpCode::LOOP_INIT:
+            pop();
+            break;
+        case OpCode::LOOP_NEXT:
+            // Переменная цикла объявлена как int и меняется только на целый шаг
+            state.variables[ins.b] = StaticType::INT;
+            break;
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE:
+        case OpCode::LOAD_ELEM_VAR_INDEX_TEE_UNCHECKED:
+            push(loaded(state.arrays[ins.a]), -1);
+            state.variables[ins.c] = state.stack.back();
+            break;
+        case OpCode::ALLOC_ARRAY:
+            // Элементы хранятся в родном типе объявления (char читается как int)
+            state.arrays[ins.a] = declaredType(ins.type);
+            break;
+        case OpCode::ARRAY_GET:
+        case OpCode::ARRAY_GET_UNCHECKED:
+            pop();
+            push(loaded(state.arrays[ins.a]), -1);
+            break;
+        case OpCode::ARRAY_SET:
+        case OpCode::ARRAY_SET_UNCHECKED:
+        case OpCode::ARRAY_READ_2D:
+            // Записываемое значение приводится к типу элементов - тип массива не меняется
+            pop(); pop();
+            break;
+        case OpCode::ARRAY_READ:
+            pop();
+            break;
+        case OpCode::ALLOC_ARRAY_2D:
+            state.arrays2D[ins.a] = declaredType(ins.type);
+            break;
+        case OpCode::ARRAY_GET_2D:
+        case OpCode::ARRAY_GET_2D_UNCHECKED:
+            pop(); pop();
+            push(loaded(state.arrays2D[ins.a]), -1);
+            break;
+        case OpCode::ARRAY_SET_2D:
+        case OpCode::ARRAY_SET_2D_UNCHECKED:
+            pop(); pop(); pop();
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef OPS_TYPING_H
+#define OPS_TYPING_H
+
+#include <vector>
+#include "ops_program.h"
+
+// Статический тип значения (решётка: NONE < INT, DOUBLE < DYNAMIC)
+enum class StaticType {
+    NONE,     // значение ещё не определено (команда не достигнута)
+    INT,      // всегда целое
+    DOUBLE,   // всегда вещественное
+    DYNAMIC   // тип известен только во время выполнения
+};
+
+// Вывод типов по скомпонованной программе: прямой анализ потока данных
+// по графу переходов (переменные, элементы массивов, ячейки стека).
+// Арифметика и сравнения с доказанными типами операндов заменяются
+// специализированными командами (ADD_I32, LT_F64, ...); проверки тега
+// остаются только там, где тип действительно динамический
+class OPSTypeInference {
+public:
+    // initialFrame - значения переменных на момент запуска (задаёт их начальные типы).
+    // Возвращает число специализированных команд
+    size_t specialize(OPSProgram& program, const std::vector<Value>& initialFrame);
+
+    // Только анализ, без замены команд (для JIT по уже слитой программе).
+    // false - глубина стека различается на разных путях, типы не известны
+    bool analyze(const OPSProgram& program, const std::vector<Value>& initialFrame);
+
+    // Типы на входе в команду pc после analyze (недостижимая команда - reached false)
+    bool reached(size_t pc) const { return states[pc].reached; }
+    const std::vector<StaticType>& variableTypes(size_t pc) const { return states[pc].variables; }
+    const std::vector<StaticType>& stackTypes(size_t pc) const { return states[pc].stack; }
+
+private:
+    // Абстрактное состояние на входе в команду
+    struct State {
+        bool reached = false;
+        std::vector<StaticType> variables;
+        std::vector<StaticType> arrays;      // элементы одномерных массивов
+        std::vector<StaticType> arrays2D;    // элементы двумерных массивов
+        std::vector<StaticType> stack;       // типы ячеек стека операндов
+        std::vector<int> producers;          // команда PUSH_CONST, положившая ячейку (-1 - неизвестно)
+    };
+
+    std::vector<State> states;
+    bool consistent = true;                  // глубина стека совпадает на всех путях
+
+    bool merge(State& target, const State& incoming);
+    void transfer(const Instruction& ins, size_t pc, State& state) const;
+};
+
+#endif // OPS_TYPING_H
@@ -0,0 +1,213 @@
+#ifndef OPS_VALUE_H
+#define OPS_VALUE_H
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+// Тип данных для значений
+enum class ValueType {
+    INT,
+    DOUBLE
+};
+
+#ifdef OPS_NAN_BOXING
+
+// Компактное представление (сборка с OPS_NAN_BOXING): 8 байт на значение.
+// double хранится как есть; int32 - в полезной нагрузке «тихого» NaN с
+// отрицательным знаком и меткой 0xFFF9 в старших 16 битах. Настоящие NaN
+// приводятся к канонической форме 0x7FF8..., поэтому с целыми не совпадают
+struct Value {
+    uint64_t bits;
+    
+    static constexpr uint64_t TAG_MASK = 0xFFFF000000000000ULL;
+    static constexpr uint64_t INT_TAG = 0xFFF9000000000000ULL;
+    static constexpr uint64_t CANONICAL_NAN = 0x7FF8000000000000ULL;
+    
+    Value() : bits(INT_TAG) {}
+    Value(int val) : bits(INT_TAG | static_cast<uint32_t>(val)) {}
+    Value(double val) { setDouble(val); }
+    
+    // Проверка типа
+    bool isInt() const { return (bits & TAG_MASK) == INT_TAG; }
+    bool isDouble() const { return !isInt(); }
+    
+    // Прямой доступ без проверки тега: только для значений, тип которых
+    // доказан выводом типов (специализированные команды). Арифметика над
+    // каноническими NaN даёт NaN процессора (0x7FF8... или 0xFFF8...), которые
+    // с меткой целого не совпадают, поэтому setRawDouble не канонизирует
+    int rawInt() const { return static_cast<int32_t>(static_cast<uint32_t>(bits)); }
+    double rawDouble() const {
+        double val;
+        std::memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+    void setRawInt(int val) { bits = INT_TAG | static_cast<uint32_t>(val); }
+    void setRawDouble(double val) { std::memcpy(&bits, &val, sizeof(val)); }
+    
+    // Преобразование в int (по умолчанию)
+    int asInt() const {
+        return isInt() ? rawInt() : static_cast<int>(rawDouble());
+    }
+    
+    // Преобразование в double
+    double asDouble() const {
+        return isInt() ? static_cast<double>(rawInt()) : rawDouble();
+    }
+    
+    // Строковое представление
+    std::string toString() const {
+        if (isInt()) {
+            return std::to_string(rawInt());
+        } else {
+            return std::to_string(rawDouble());
+        }
+    }
+    
+    // Арифметические операции
+    Value operator+(const Value& other) const {
+        if (isDouble() || other.isDouble()) {
+            return Value(asDouble() + other.asDouble());
+        } else {
+            return Value(rawInt() + other.rawInt());
+        }
+    }
+    
+    Value operator-(const Value& other) const {
+        if (isDouble() || other.isDouble()) {
+            return Value(asDouble() - other.asDouble());
+        } else {
+            return Value(rawInt() - other.rawInt());
+        }
+    }
+    
+    Value operator*(const Value& other) const {
+        if (isDouble() || other.isDouble()) {
+            return Value(asDouble() * other.asDouble());
+        } else {
+            return Value(rawInt() * other.rawInt());
+        }
+    }
+    
+    Value operator/(const Value& other) const {
+        if (isDouble() || other.isDouble()) {
+            return Value(asDouble() / other.asDouble());
+        } else {
+            return Value(rawInt() / other.rawInt());
+        }
+    }
+    
+    // Оператор вывода
+    friend std::ostream& operator<<(std::ostream& os, const Value& val) {
+        if (val.isInt()) {
+            os << val.rawInt();
+        } else {
+            os << val.rawDouble();
+        }
+        return os;
+    }
+
+private:
+    void setDouble(double val) {
+        if (val != val) {
+            bits = CANONICAL_NAN;
+        } else {
+            setRawDouble(val);
+        }
+    }
+};
+
+static_assert(sizeof(Value) == 8, "NaN-упакованное значение должно занимать 8 байт");
+
+#else
+
+// Структура для хранения значения с типом (представление по умолчанию, 16 байт)
+struct Value {
+    ValueType type;
+    union {
+        int intValue;
+        double doubleValue;
+    };
+    
+    Value() : type(ValueType::INT), intValue(0) {}
+    Value(int val) : type(ValueType::INT), intValue(val) {}
+    Value(double val) : type(ValueType::DOUBLE), doubleValue(val) {}
+    
+    // Проверка типа
+    bool isInt() const { return type == ValueType::INT; }
+    bool isDouble() const { return type == ValueType::DOUBLE; }
+    
+    // Прямой доступ без проверки тега: только для значений, тип которых
+    // доказан выводом типов (специализированные команды)
+    int rawInt() const { return intValue; }
+    double rawDouble() const { return doubleValue; }
+    void setRawInt(int val) { intValue = val; }
+    void setRawDouble(double val) { doubleValue = val; }
+    
+    // Преобразование в int (по умолчанию)
+    int asInt() const {
+        return type == ValueType::INT ? intValue : static_cast<int>(doubleValue);
+    }
+    
+    // Преобразование в double
+    double asDouble() const {
+        return type == ValueType::DOUBLE ? doubleValue : static_cast<double>(intValue);
+    }
+    
+    // Строковое представление
+    std::string toString() const {
+        if (type == ValueType::INT) {
+            return std::to_string(intValue);
+        } else {
+            return std::to_string(doubleValue);
+        }
+    }
+    
+    // Арифметические операции
+    Value operator+(const Value& other) const {
+        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
+            return Value(asDouble() + other.asDouble());
+        } else {
+            return Value(intValue + other.intValue);
+        }
+    }
+    
+    Value operator-(const Value& other) const {
+        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
+            return Value(asDouble() - other.asDouble());
+        } else {
+            return Value(intValue - other.intValue);
+        }
+    }
+    
+    Value operator*(const Value& other) const {
+        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
+            return Value(asDouble() * other.asDouble());
+        } else {
+            return Value(intValue * other.intValue);
+        }
+    }
+    
+    Value operator/(const Value& other) const {
+        if (type == ValueType::DOUBLE || other.type == ValueType::DOUBLE) {
+            return Value(asDouble() / other.asDouble());
+        } else {
+            return Value(intValue / other.intValue);
+        }
+    }
+    
+    // Оператор вывода
+    friend std::ostream& operator<<(std::ostream& os, const Value& val) {
+        if (val.type == ValueType::INT) {
+            os << val.intValue;
+        } else {
+            os << val.doubleValue;
+        }
+        return os;
+    }
+};
+
+#endif // OPS_NAN_BOXING
+
+#endif // OPS_VALUE_H 
@@ -1,16 +1,117 @@
 #include "syntax_analyzer.h"
 #include "ops_generator.h"
 #include "ops_interpreter.h"
+#include "ops_peephole.h"
+#include "ops_propagation.h"
+#include "ops_deadcode.h"
+#include "ops_cse.h"
+#include "ops_licm.h"
+#include "ops_counted_loops.h"
+#include "ops_bounds.h"
+#include "ops_cbackend.h"
+#include "ops_image.h"
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <stack>
 #include <fstream>
 #include <memory>
+#include <charconv>
+#include <cctype>
+#include <climits>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+namespace {
+
+// Числовой литерал ОПС
+struct Literal {
+    bool isInt = true;
+    long long intValue = 0;
+    double doubleValue = 0.0;
+};
+
+bool parseLiteral(const std::string& text, Literal& literal) {
+    if (text.empty()) return false;
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* digits = (*begin == '-' || *begin == '+') ? begin + 1 : begin;
+    if (digits == end) return false;
+    for (const char* c = digits; c != end; ++c) {
+        if (!std::isdigit(static_cast<unsigned char>(*c)) && *c != '.') return false;
+    }
+    if (*begin == '+') ++begin;
+
+    if (text.find('.') == std::string::npos) {
+        std::from_chars_result result = std::from_chars(begin, end, literal.intValue);
+        if (result.ec != std::errc() || result.ptr != end) return false;
+        if (literal.intValue < INT_MIN || literal.intValue > INT_MAX) return false;
+        literal.isInt = true;
+    } else {
+        std::from_chars_result result = std::from_chars(begin, end, literal.doubleValue);
+        if (result.ec != std::errc() || result.ptr != end) return false;
+        literal.isInt = false;
+    }
+    return true;
+}
+
+// Запись double, которую загрузчик ОПС прочтёт обратно тем же значением и типом
+bool formatDouble(double value, std::string& text) {
+    char buffer[64];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+    if (result.ec != std::errc()) return false;
+    text.assign(buffer, result.ptr);
+    if (text.find_first_not_of("-0123456789.") != std::string::npos) return false; // inf, nan
+    if (text.find('.') == std::string::npos) text += ".0";
+    return true;
+}
+
+// Вычисление op над двумя литералами; false - свёртка невозможна
+// (деление на ноль и переполнение остаются ошибками времени выполнения)
+bool foldConstants(const std::string& left, const std::string& right, const std::string& op, std::string& result) {
+    Literal a;
+    Literal b;
+    if (!parseLiteral(left, a) || !parseLiteral(right, b)) return false;
+
+    if (op == ">" || op == "<" || op == "==") {
+        bool value;
+        if (a.isInt && b.isInt) {
+            value = op == ">" ? a.intValue > b.intValue : op == "<" ? a.intValue < b.intValue : a.intValue == b.intValue;
+        } else {
+            double x = a.isInt ? static_cast<double>(a.intValue) : a.doubleValue;
+            double y = b.isInt ? static_cast<double>(b.intValue) : b.doubleValue;
+            value = op == ">" ? x > y : op == "<" ? x < y : x == y;
+        }
+        result = value ? "1" : "0";
+        return true;
+    }
+
+    if (a.isInt && b.isInt) {
+        long long value;
+        if (op == "+") value = a.intValue + b.intValue;
+        else if (op == "-") value = a.intValue - b.intValue;
+        else if (op == "*") value = a.intValue * b.intValue;
+        else if (op == "/" && b.intValue != 0) value = a.intValue / b.intValue;
+        else return false;
+        if (value < INT_MIN || value > INT_MAX) return false;
+        result = std::to_string(value);
+        return true;
+    }
+
+    double x = a.isInt ? static_cast<double>(a.intValue) : a.doubleValue;
+    double y = b.isInt ? static_cast<double>(b.intValue) : b.doubleValue;
+    double value;
+    if (op == "+") value = x + y;
+    else if (op == "-") value = x - y;
+    else if (op == "*") value = x * y;
+    else if (op == "/" && y != 0.0) value = x / y;
+    else return false;
+    return formatDouble(value, result);
+}
+
+} // namespace
+
 // Конструктор синтаксического анализатора - исправляю порядок инициализации
 SyntaxAnalyzer::SyntaxAnalyzer() : opsGenerator(new OPSGenerator()), currentToken(0), labelCounter(0) {}
 
@@ -113,10 +214,9 @@ void SyntaxAnalyzer::parseDeclaration() {
         if (currentToken < tokens.size() && tokens[currentToken].getType() == "LEFT_BRACKET") {
             currentToken++; // пропускаем '['
             
-            // Парсим размер массива
-            if (currentToken < tokens.size() && (tokens[currentToken].getType() == "NUMBER" || tokens[currentToken].getType() == "DOUBLE_NUMBER")) {
-                std::string size1 = tokens[currentToken].getValue();
-                currentToken++;
+            // Парсим размер массива (константное выражение, свёрнутое при разборе)
+            if (currentToken < tokens.size() && tokens[currentToken].getType() != "RIGHT_BRACKET") {
+                std::string size1 = parseArraySize();
                 
                 if (currentToken >= tokens.size() || tokens[currentToken].getType() != "RIGHT_BRACKET") {
                     if (currentToken < tokens.size()) {
@@ -131,9 +231,8 @@ void SyntaxAnalyzer::parseDeclaration() {
                 if (currentToken < tokens.size() && tokens[currentToken].getType() == "LEFT_BRACKET") {
                     currentToken++; // пропускаем '['
                     
-                    if (currentToken < tokens.size() && (tokens[currentToken].getType() == "NUMBER" || tokens[currentToken].getType() == "DOUBLE_NUMBER")) {
-                        std::string size2 = tokens[currentToken].getValue();
-                        currentToken++;
+                    if (currentToken < tokens.size() && tokens[currentToken].getType() != "RIGHT_BRACKET") {
+                        std::string size2 = parseArraySize();
                         
                         // Генерируем ОПС для объявления двумерного массива
                         // Формат: тип имя_массива строки столбцы alloc_array_2d
@@ -395,6 +494,7 @@ void SyntaxAnalyzer::parseWhileStatement() {
 
 void SyntaxAnalyzer::parseExpression() {
     std::stack<std::string> operatorStack;
+    size_t expressionStart = opsCode.size(); // свёртка констант не выходит за пределы выражения
     int iterationsCount = 0;
     size_t lastToken = currentToken;
     
@@ -471,7 +571,7 @@ void SyntaxAnalyzer::parseExpression() {
             // Простая обработка приоритета операторов
             while (!operatorStack.empty() && 
                    getPriority(operatorStack.top()) >= getPriority(op)) {
-                opsCode.push_back(operatorStack.top());
+                emitOperator(operatorStack.top(), expressionStart);
                 operatorStack.pop();
             }
             operatorStack.push(op);
@@ -483,7 +583,7 @@ void SyntaxAnalyzer::parseExpression() {
         }
         else if (token.getType() == "RIGHT_PAREN") {
             while (!operatorStack.empty() && operatorStack.top() != "(") {
-                opsCode.push_back(operatorStack.top());
+                emitOperator(operatorStack.top(), expressionStart);
                 operatorStack.pop();
             }
             if (!operatorStack.empty()) {
@@ -500,7 +600,7 @@ void SyntaxAnalyzer::parseExpression() {
     // Выгружаем оставшиеся операторы
     while (!operatorStack.empty()) {
         if (operatorStack.top() != "(") {
-            opsCode.push_back(operatorStack.top());
+            emitOperator(operatorStack.top(), expressionStart);
         }
         operatorStack.pop();
     }
@@ -509,6 +609,7 @@ void SyntaxAnalyzer::parseExpression() {
 // Новый метод для парсинга условий в if/while
 void SyntaxAnalyzer::parseCondition() {
     std::stack<std::string> operatorStack;
+    size_t expressionStart = opsCode.size(); // свёртка констант не выходит за пределы выражения
     int iterationsCount = 0;
     size_t lastToken = currentToken;
     
@@ -585,7 +686,7 @@ void SyntaxAnalyzer::parseCondition() {
             // Простая обработка приоритета операторов
             while (!operatorStack.empty() && 
                    getPriority(operatorStack.top()) >= getPriority(op)) {
-                opsCode.push_back(operatorStack.top());
+                emitOperator(operatorStack.top(), expressionStart);
                 operatorStack.pop();
             }
             operatorStack.push(op);
@@ -606,11 +707,42 @@ void SyntaxAnalyzer::parseCondition() {
     
     // Выгружаем оставшиеся операторы
     while (!operatorStack.empty()) {
-        opsCode.push_back(operatorStack.top());
+        emitOperator(operatorStack.top(), expressionStart);
         operatorStack.pop();
     }
 }
 
+void SyntaxAnalyzer::emitOperator(const std::string& op, size_t expressionStart) {
+    // Свёртка констант: если оба операнда - литералы этого же выражения,
+    // операция выполняется на этапе разбора (с семантикой интерпретатора)
+    size_t size = opsCode.size();
+    if (size >= expressionStart + 2) {
+        std::string folded;
+        if (foldConstants(opsCode[size - 2], opsCode[size - 1], op, folded)) {
+            opsCode.pop_back();
+            opsCode.back() = folded;
+            return;
+        }
+    }
+    opsCode.push_back(op);
+}
+
+std::string SyntaxAnalyzer::parseArraySize() {
+    // Размер массива - константное выражение: после свёртки остаётся один целый литерал
+    size_t start = opsCode.size();
+    parseExpression();
+    Literal size;
+    if (opsCode.size() != start + 1 || !parseLiteral(opsCode.back(), size) || !size.isInt || size.intValue < 0) {
+        if (currentToken < tokens.size()) {
+            error("Array size must be a non-negative constant integer expression", tokens[currentToken]);
+        }
+        throw std::runtime_error("Array size must be a non-negative constant integer expression");
+    }
+    std::string result = opsCode.back();
+    opsCode.pop_back();
+    return result;
+}
+
 int SyntaxAnalyzer::getPriority(const std::string& op) {
     if (op == ">" || op == "<" || op == "==") return 1;
     if (op == "+" || op == "-") return 2;
@@ -686,98 +818,364 @@ std::string readFile(const std::string& filename) {
     return content;
 }
 
-void processCode(const std::string& code, const std::string& description) {
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "АНАЛИЗ: " << description << std::endl;
-    std::cout << std::string(60, '-') << std::endl;
-    std::cout << "Исходный код:" << std::endl;
-    std::cout << code << std::endl;
+// Параметры запуска из командной строки
+struct RunOptions {
+    ExecutionMode mode = ExecutionMode::TRACE;
+    bool rawOutput = false;
+    std::string inputPath;                  // данные для read() ("-" - stdin, пусто - интерактивно)
+    DispatchMode dispatch = OPSInterpreter::threadedDispatchAvailable() ? DispatchMode::THREADED : DispatchMode::SWITCH;
+    PeepholeConfig peephole;                // правила оконной оптимизации ОПС
+    bool propagation = true;                // распространение констант и копий
+    bool deadCode = true;                   // удаление мёртвого кода и присваиваний
+    bool cse = true;                        // устранение общих подвыражений
+    bool licm = true;                       // вынос инвариантов из циклов
+    bool countedLoops = true;               // циклы со счётчиком (loop_init / loop_next)
+    bool boundsChecks = true;               // удаление проверок границ в циклах со счётчиком
+    bool jit = true;                        // машинный код для горячих циклов
+    long long jitThreshold = -1;            // обратных переходов до компиляции цикла (-1 - по умолчанию)
+    bool stats = false;                     // профиль выполнения после программы
+    bool emitC = false;                     // перевести программу в C вместо выполнения
+    bool compileOnly = false;               // записать образ программы (.opsb) вместо выполнения
+    std::string imagePath;                  // выполнить образ программы вместо input.txt
+    std::string outputPath;                 // файл результата (-o)
+};
+
+// Выполнение декодированной программы интерпретатором с параметрами запуска
+void executeProgram(const OPSProgram& program, const RunOptions& options) {
+    OPSInterpreter interpreter;
+    interpreter.setExecutionMode(options.mode);
+    interpreter.setDispatchMode(options.dispatch);
+    interpreter.setJitEnabled(options.jit);
+    if (options.jitThreshold >= 0) {
+        interpreter.setTierThreshold(static_cast<uint64_t>(options.jitThreshold));
+    }
+    interpreter.setStatsEnabled(options.stats);
+    
+    BufferedOutputSink output(stdout, 1 << 20);
+    output.setRaw(options.rawOutput);
+    interpreter.setOutputSink(&output);
+    
+    // Неинтерактивный ввод: данные из файла или stdin без приглашений
+    BulkInputReader input;
+    if (!options.inputPath.empty()) {
+        input.open(options.inputPath);
+        interpreter.setInputSource(&input);
+    }
+    
+    interpreter.execute(program);
+}
+
+// Выполнение образа программы (.opsb): без анализа исходного кода и оптимизатора
+void processImage(const std::string& path, const RunOptions& options) {
+    bool verbose = options.mode != ExecutionMode::QUIET;
+    
+    if (verbose) {
+        std::cout << "\n" << std::string(60, '=') << std::endl;
+        std::cout << "ВЫПОЛНЕНИЕ ОБРАЗА: " << path << std::endl;
+    }
+    
+    try {
+        OPSImageLoader loader;
+        executeProgram(loader.load(path), options);
+    }
+    catch (const std::exception& e) {
+        std::cout << "❌ ОШИБКА ВЫПОЛНЕНИЯ ОПС: " << e.what() << std::endl;
+        std::cout << "⚠️  Выполнение остановлено." << std::endl;
+    }
+}
+
+// Анализ, оптимизация и выполнение программы. false - файл результата
+// (--emit-c, --compile-only) не записан; при выполнении ошибки программы
+// только печатаются
+bool processCode(const std::string& code, const std::string& description, const RunOptions& options) {
+    // В тихом режиме выводится только результат программы (команда w)
+    bool verbose = options.mode != ExecutionMode::QUIET;
+    bool buildOnly = options.emitC || options.compileOnly;
+    
+    if (verbose) {
+        std::cout << "\n" << std::string(60, '=') << std::endl;
+        std::cout << "АНАЛИЗ: " << description << std::endl;
+        std::cout << std::string(60, '-') << std::endl;
+        std::cout << "Исходный код:" << std::endl;
+        std::cout << code << std::endl;
+    }
     
     try {
         // Лексический анализ
-        std::cout << std::string(30, '-') << std::endl;
-        std::cout << "1) ЛЕКСИЧЕСКИЙ АНАЛИЗ (конечный автомат):" << std::endl;
         Lexer lexer(code);
         std::vector<Token> tokens = lexer.tokenize();
         
-        std::cout << "Токены:" << std::endl;
-        for (const auto& token : tokens) {
-            if (token.getType() != "EOF") {
-                std::cout << "  " << token.getType() << ": '" << token.getValue() << "'" << std::endl;
+        if (verbose) {
+            std::cout << std::string(30, '-') << std::endl;
+            std::cout << "1) ЛЕКСИЧЕСКИЙ АНАЛИЗ (конечный автомат):" << std::endl;
+            std::cout << "Токены:" << std::endl;
+            for (const auto& token : tokens) {
+                if (token.getType() != "EOF") {
+                    std::cout << "  " << token.getType() << ": '" << token.getValue() << "'" << std::endl;
+                }
             }
         }
         
         // Синтаксический анализ + генерация ОПС
-        std::cout << std::string(30, '-') << std::endl;
-        std::cout << "2) СИНТАКСИЧЕСКИЙ АНАЛИЗ (магазинный автомат + генератор ОПС):" << std::endl;
-        
         SyntaxAnalyzer analyzer;
         std::vector<OPSCommand> result = analyzer.analyze(tokens);
         
-        std::cout << "Сгенерированная ОПС:" << std::endl;
-        std::cout << "  ";
-        analyzer.printOPSCode();
-        
-        // Выполнение ОПС интерпретатором
-        std::cout << std::string(30, '-') << std::endl;
-        std::cout << "3) ВЫПОЛНЕНИЕ ОПС (стековая машина):" << std::endl;
+        if (verbose) {
+            std::cout << std::string(30, '-') << std::endl;
+            std::cout << "2) СИНТАКСИЧЕСКИЙ АНАЛИЗ (магазинный автомат + генератор ОПС):" << std::endl;
+            std::cout << "Сгенерированная ОПС:" << std::endl;
+            std::cout << "  ";
+            analyzer.printOPSCode();
+            
+            // Выполнение ОПС интерпретатором
+            std::cout << std::string(30, '-') << std::endl;
+            std::cout << "3) ВЫПОЛНЕНИЕ ОПС (стековая машина):" << std::endl;
+        }
         
         try {
-            OPSInterpreter interpreter;
-            
-            // Преобразуем ОПС код в вектор строк
-            std::vector<std::string> opsCommands;
-            std::stringstream ss;
-            analyzer.printOPSCode();
             // Получаем ОПС код из analyzer.opsCode
-            for (const auto& cmd : analyzer.opsCode) {
-                opsCommands.push_back(cmd);
-            }
+            std::vector<std::string> opsCommands(analyzer.opsCode.begin(), analyzer.opsCode.end());
             
             if (!opsCommands.empty()) {
-                interpreter.execute(opsCommands);
+                OPSLoader loader;
+                OPSProgram program = loader.load(opsCommands);
+                
+                // Распространение констант и копий по графу потока управления
+                if (options.propagation) {
+                    OPSPropagation propagation;
+                    size_t changed = propagation.optimize(program);
+                    if (verbose) {
+                        std::cout << "Распространение констант и копий: изменено команд - " << changed << std::endl;
+                    }
+                }
+                
+                // Удаление недостижимого кода и мёртвых присваиваний; итоговые
+                // значения переменных нужны только для вывода состояния
+                if (options.deadCode) {
+                    OPSDeadCode deadCode(verbose);
+                    size_t removed = deadCode.optimize(program);
+                    if (verbose) {
+                        std::cout << "Удаление мёртвого кода: удалено команд - " << removed << std::endl;
+                    }
+                }
+                
+                // Инварианты циклов - в предзаголовок перед меткой начала цикла
+                if (options.licm) {
+                    OPSLoopInvariantMotion licm;
+                    size_t hoisted = licm.optimize(program);
+                    if (verbose) {
+                        std::cout << "Вынос инвариантов из циклов: вынесено вычислений - " << hoisted << std::endl;
+                    }
+                }
+                
+                // Повторные вычисления выражений и элементов массивов -
+                // чтение временных переменных; сохранения (tee), которые
+                // никто не читает, убирает повторное удаление мёртвого кода
+                if (options.cse) {
+                    OPSCommonSubexpressions cse;
+                    size_t replaced = cse.optimize(program);
+                    if (options.deadCode) {
+                        OPSDeadCode(verbose).optimize(program);
+                    }
+                    if (verbose) {
+                        std::cout << "Общие подвыражения: заменено вычислений - " << replaced << std::endl;
+                    }
+                }
+                
+                // Оконная оптимизация между анализом и выполнением
+                OPSPeephole peephole(options.peephole);
+                size_t removed = peephole.optimize(program);
+                if (verbose) {
+                    std::cout << "Оконная оптимизация: удалено команд - " << removed << std::endl;
+                }
+                
+                // Циклы с индуктивной переменной - условие и приращение одной командой
+                if (options.countedLoops) {
+                    OPSCountedLoops countedLoops;
+                    size_t lowered = countedLoops.optimize(program);
+                    if (verbose) {
+                        std::cout << "Циклы со счётчиком: переписано циклов - " << lowered << std::endl;
+                    }
+                }
+                
+                // Обращения к массивам по переменной цикла - без проверки
+                // границ под охраной перед циклом
+                if (options.boundsChecks) {
+                    OPSBoundsChecks boundsChecks;
+                    size_t unchecked = boundsChecks.optimize(program);
+                    if (verbose) {
+                        std::cout << "Проверки границ: обращений без проверки - " << unchecked << std::endl;
+                    }
+                }
+                
+                // Заблаговременная компиляция: исходный текст на C вместо выполнения
+                if (options.emitC) {
+                    OPSCBackend backend(options.rawOutput);
+                    std::string path = options.outputPath.empty() ? "program.c" : options.outputPath;
+                    // Файл создаётся только после успешного перевода: иначе
+                    // сборка получила бы пустой исходный текст
+                    std::string source = backend.translate(program);
+                    std::ofstream file(path, std::ios::binary);
+                    file << source;
+                    if (!file) {
+                        throw std::runtime_error("Не удалось записать файл: " + path);
+                    }
+                    if (verbose) {
+                        std::cout << "Программа на C записана в " << path << std::endl;
+                    }
+                    return true;
+                }
+                
+                // Образ программы (.opsb) вместо выполнения
+                if (options.compileOnly) {
+                    OPSImageWriter writer;
+                    std::string path = options.outputPath.empty() ? "program.opsb" : options.outputPath;
+                    writer.write(program, path);
+                    if (verbose) {
+                        std::cout << "Образ программы записан в " << path << std::endl;
+                    }
+                    return true;
+                }
+                
+                executeProgram(program, options);
             } else {
                 std::cout << "❌ Нет команд ОПС для выполнения" << std::endl;
+                return !buildOnly;
             }
         }
         catch (const std::exception& e) {
             std::cout << "❌ ОШИБКА ВЫПОЛНЕНИЯ ОПС: " << e.what() << std::endl;
             std::cout << "⚠️  Выполнение остановлено." << std::endl;
+            return !buildOnly;
         }
     }
     catch (const std::exception& e) {
         std::cout << "❌ ОШИБКА: " << e.what() << std::endl;
+        return !buildOnly;
     }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [--quiet | --summary | --trace] [--raw-output] [--input FILE]"
+              << " [--dispatch switch|threaded] [--no-peephole] [--no-propagation] [--no-dead-code] [--no-cse] [--no-licm] [--no-counted-loops] [--no-bce] [--no-jit] [--jit-threshold N] [--stats] [--emit-c] [--compile-only] [--load FILE] [-o FILE]" << std::endl;
+    std::cout << "  --quiet    только вывод программы (write)" << std::endl;
+    std::cout << "  --summary  без трассировки команд, с итоговым состоянием" << std::endl;
+    std::cout << "  --trace    трассировка каждой команды ОПС (по умолчанию)" << std::endl;
+    std::cout << "  --raw-output  выводить только значения, по одному в строке" << std::endl;
+    std::cout << "  --input FILE  читать данные для read() из файла без приглашений ('-' - stdin)" << std::endl;
+    std::cout << "  --no-peephole  отключить оконную оптимизацию ОПС" << std::endl;
+    std::cout << "  --no-propagation  отключить распространение констант и копий" << std::endl;
+    std::cout << "  --no-dead-code  не удалять недостижимый код и мёртвые присваивания" << std::endl;
+    std::cout << "  --no-cse  не устранять общие подвыражения" << std::endl;
+    std::cout << "  --no-licm  не выносить инварианты из циклов" << std::endl;
+    std::cout << "  --no-counted-loops  не переводить циклы for в команды со счётчиком" << std::endl;
+    std::cout << "  --no-bce  не удалять проверки границ массивов в циклах" << std::endl;
+    std::cout << "  --no-jit  выполнять циклы только интерпретатором (JIT x86-64: "
+              << (OPSInterpreter::jitAvailable() ? "собран" : "не собран") << ")" << std::endl;
+    std::cout << "  --jit-threshold N  переводить цикл в машинный код после N обратных переходов (по умолчанию 1000)" << std::endl;
+    std::cout << "  --stats  вывести профиль: счётчики циклов и блоков, переходы между уровнями" << std::endl;
+    std::cout << "  --emit-c  не выполнять, а перевести программу в C (файл -o, по умолчанию program.c)" << std::endl;
+    std::cout << "  --compile-only  не выполнять, а записать образ программы (файл -o, по умолчанию program.opsb)" << std::endl;
+    std::cout << "  --load FILE  выполнить образ программы вместо input.txt" << std::endl;
+    std::cout << "  -o FILE  файл результата" << std::endl;
+    std::cout << "  --dispatch switch|threaded  ядро основного цикла (threaded - computed goto, "
+              << (OPSInterpreter::threadedDispatchAvailable() ? "по умолчанию" : "не собрано") << ")" << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     #ifdef _WIN32
     // Set console output codepage to UTF-8
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
     #endif
 
-    std::cout << "🚀 КОМПИЛЯТОР: Лексический + Синтаксический анализатор" << std::endl;
-    std::cout << "Версия: 1.0" << std::endl;
-    std::cout << "Согласно лекциям по методам компиляции" << std::endl;
+    // Разбор параметров командной строки
+    RunOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quiet") {
+            options.mode = ExecutionMode::QUIET;
+        } else if (arg == "--summary") {
+            options.mode = ExecutionMode::SUMMARY;
+        } else if (arg == "--trace") {
+            options.mode = ExecutionMode::TRACE;
+        } else if (arg == "--raw-output") {
+            options.rawOutput = true;
+        } else if (arg == "--input" && i + 1 < argc) {
+            options.inputPath = argv[++i];
+        } else if (arg == "--no-peephole") {
+            options.peephole = PeepholeConfig::none();
+        } else if (arg == "--no-propagation") {
+            options.propagation = false;
+        } else if (arg == "--no-dead-code") {
+            options.deadCode = false;
+        } else if (arg == "--no-cse") {
+            options.cse = false;
+        } else if (arg == "--no-licm") {
+            options.licm = false;
+        } else if (arg == "--no-counted-loops") {
+            options.countedLoops = false;
+        } else if (arg == "--no-bce") {
+            options.boundsChecks = false;
+        } else if (arg == "--no-jit") {
+            options.jit = false;
+        } else if (arg == "--jit-threshold" && i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            options.jitThreshold = std::stoll(argv[++i]);
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--emit-c") {
+            options.emitC = true;
+        } else if (arg == "--compile-only") {
+            options.compileOnly = true;
+        } else if (arg == "--load" && i + 1 < argc) {
+            options.imagePath = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.outputPath = argv[++i];
+        } else if (arg == "--dispatch" && i + 1 < argc && std::string(argv[i + 1]) == "switch") {
+            options.dispatch = DispatchMode::SWITCH;
+            ++i;
+        } else if (arg == "--dispatch" && i + 1 < argc && std::string(argv[i + 1]) == "threaded") {
+            options.dispatch = DispatchMode::THREADED;
+            ++i;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    bool verbose = options.mode != ExecutionMode::QUIET;
+
+    if (verbose) {
+        std::cout << "🚀 КОМПИЛЯТОР: Лексический + Синтаксический анализатор" << std::endl;
+        std::cout << "Версия: 1.0" << std::endl;
+        std::cout << "Согласно лекциям по методам компиляции" << std::endl;
+    }
 
     // Ищем файл input.txt
     std::string inputFile = "input.txt";
     
     // Простая проверка существования файла
     std::ifstream fileCheck(inputFile);
-    if (fileCheck.good()) {
+    // При --emit-c и --compile-only ошибка - код завершения 1 (для шага сборки)
+    bool succeeded = true;
+    if (!options.imagePath.empty()) {
+        processImage(options.imagePath, options);
+    } else if (fileCheck.good()) {
         fileCheck.close();
-        std::cout << "\n📁 Анализ кода из файла: " << inputFile << std::endl;
+        if (verbose) {
+            std::cout << "\n📁 Анализ кода из файла: " << inputFile << std::endl;
+        }
         
         try {
             std::string fileContent = readFile(inputFile);
-            processCode(fileContent, "Код из файла " + inputFile);
+            succeeded = processCode(fileContent, "Код из файла " + inputFile, options);
     }
     catch (const std::exception& e) {
             std::cout << "❌ Ошибка чтения файла: " << e.what() << std::endl;
+            succeeded = false;
         }
     } else {
+        succeeded = false;
         std::cout << "\n❌ Файл " << inputFile << " не найден!" << std::endl;
         std::cout << "Создайте файл 'input.txt' с кодом для анализа." << std::endl;
         std::cout << "\nПример содержимого:" << std::endl;
@@ -786,12 +1184,17 @@ int main() {
         std::cout << "}" << std::endl;
     }
 
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "✅ Анализ завершен!" << std::endl;
-    
-    std::cout << "\nНажмите Enter для выхода..." << std::endl;
-    std::cin.get();
-    return 0;
+    if (verbose) {
+        std::cout << "\n" << std::string(60, '=') << std::endl;
+        std::cout << "✅ Анализ завершен!" << std::endl;
+        
+        // При вводе из stdin ожидание нажатия Enter не имеет смысла
+        if (options.inputPath != "-") {
+            std::cout << "\nНажмите Enter для выхода..." << std::endl;
+            std::cin.get();
+        }
+    }
+    return succeeded || !(options.emitC || options.compileOnly) ? 0 : 1;
 }
 
 // ============== НОВЫЕ МЕТОДЫ ДЛЯ МАССИВОВ (согласно лекции) ==============
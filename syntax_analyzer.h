@@ -52,6 +52,8 @@ private:
     void parseExpression();
     void parseCondition();  // для парсинга условий в if/while
     int getPriority(const std::string& op);
+    void emitOperator(const std::string& op, size_t expressionStart); // оператор в ОПС со свёрткой констант
+    std::string parseArraySize();   // размер массива: константное выражение → литерал
     void parseSimpleExpression();  // для простых аргументов (числа, переменные)
     
     // Методы парсинга для массивов (согласно лекции)